@@ -0,0 +1,232 @@
+/* Benchmarks for GeometryTable, CollisionBvh and SelfCollisionAnalysis */
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <urdf_model/collision_analysis.h>
+#include <urdf_model/collision_bvh.h>
+#include <urdf_model/forward_kinematics.h>
+#include <urdf_model/geometry_table.h>
+
+#include "synthetic_model.h"
+
+static const double PI = 3.14159265358979323846;
+
+/// \brief CHAIN model winding through space like a long snake robot
+///
+/// The joints of the synthetic models all turn about z and are offset along
+/// x, which folds every configuration into a plane where nearly all links
+/// overlap.  Here the joint offsets point along a spiral over the sphere and
+/// the axes alternate, so only links that come back near each other overlap.
+/// Every link carries a cylinder along the link and a sphere at its joint.
+static void buildCollisionModel(size_t num_links, urdf::ModelInterface &model)
+{
+  urdf_benchmark::buildModel(urdf_benchmark::CHAIN, num_links, model);
+  const double golden_angle = PI * (3.0 - std::sqrt(5.0));
+  for (size_t i = 0; i < num_links; ++i)
+  {
+    if (i > 0)
+    {
+      urdf::Joint &joint = *model.joints_[urdf_benchmark::jointName(i)];
+      const double z = 1.0 - 2.0 * static_cast<double>(i % 97) / 96.0;
+      const double r = std::sqrt(1.0 - z * z);
+      const double phi = golden_angle * static_cast<double>(i);
+      joint.parent_to_joint_origin_transform.position = urdf::Vector3(r * std::cos(phi), r * std::sin(phi), z) * 0.1;
+      joint.axis = i % 3 == 0 ? urdf::Vector3(1, 0, 0) : i % 3 == 1 ? urdf::Vector3(0, 1, 0) : urdf::Vector3(0, 0, 1);
+    }
+    urdf::Link &link = *model.links_[urdf_benchmark::linkName(i)];
+    urdf::CollisionSharedPtr cylinder(new urdf::Collision());
+    urdf::CylinderSharedPtr cylinder_geometry(new urdf::Cylinder());
+    cylinder_geometry->radius = 0.01;
+    cylinder_geometry->length = 0.06;
+    cylinder->geometry = cylinder_geometry;
+    cylinder->origin.position = urdf::Vector3(0.03, 0, 0);
+    cylinder->origin.rotation.setFromRPY(0, PI / 2, 0);
+    urdf::CollisionSharedPtr sphere(new urdf::Collision());
+    urdf::SphereSharedPtr sphere_geometry(new urdf::Sphere());
+    sphere_geometry->radius = 0.015;
+    sphere->geometry = sphere_geometry;
+    link.collision_array.push_back(cylinder);
+    link.collision_array.push_back(sphere);
+    link.collision = cylinder;
+  }
+}
+
+/// a configuration bending every joint a little
+static std::vector<double> bentConfiguration(size_t num_positions)
+{
+  std::vector<double> q(num_positions);
+  for (size_t k = 0; k < num_positions; ++k)
+  {
+    q[k] = 0.1 + 0.2 * static_cast<double>(k % 5) / 4.0;
+  }
+  return q;
+}
+
+/// Volume of every collision element through dynamic_pointer_cast
+static void BM_GeometryVolumeCast(benchmark::State &state)
+{
+  urdf::ModelInterface model;
+  buildCollisionModel(static_cast<size_t>(state.range(0)), model);
+  std::vector<urdf::CollisionSharedPtr> collisions;
+  for (size_t i = 0; i < static_cast<size_t>(state.range(0)); ++i)
+  {
+    const urdf::Link &link = *model.links_[urdf_benchmark::linkName(i)];
+    collisions.insert(collisions.end(), link.collision_array.begin(), link.collision_array.end());
+  }
+
+  for (auto _ : state)
+  {
+    double volume = 0;
+    for (const urdf::CollisionSharedPtr &collision : collisions)
+    {
+      if (urdf::SphereSharedPtr sphere = urdf::dynamic_pointer_cast<urdf::Sphere>(collision->geometry))
+      {
+        volume += 4.0 / 3.0 * PI * sphere->radius * sphere->radius * sphere->radius;
+      }
+      else if (urdf::CylinderSharedPtr cylinder = urdf::dynamic_pointer_cast<urdf::Cylinder>(collision->geometry))
+      {
+        volume += PI * cylinder->radius * cylinder->radius * cylinder->length;
+      }
+    }
+    benchmark::DoNotOptimize(volume);
+  }
+  state.SetItemsProcessed(state.iterations() * collisions.size());
+}
+BENCHMARK(BM_GeometryVolumeCast)->Arg(10)->Arg(1000)->Arg(100000);
+
+/// The same volume from the per type arrays of a GeometryTable
+static void BM_GeometryVolumeTable(benchmark::State &state)
+{
+  urdf::ModelInterface model;
+  buildCollisionModel(static_cast<size_t>(state.range(0)), model);
+  urdf::GeometryTable table{urdf::CompiledModel(model)};
+
+  for (auto _ : state)
+  {
+    double volume = 0;
+    for (const double r : table.sphere_radius)
+    {
+      volume += 4.0 / 3.0 * PI * r * r * r;
+    }
+    for (size_t k = 0; k < table.cylinder_radius.size(); ++k)
+    {
+      volume += PI * table.cylinder_radius[k] * table.cylinder_radius[k] * table.cylinder_length[k];
+    }
+    benchmark::DoNotOptimize(volume);
+  }
+  state.SetItemsProcessed(state.iterations() * table.size());
+}
+BENCHMARK(BM_GeometryVolumeTable)->Arg(10)->Arg(1000)->Arg(100000);
+
+static void BM_CollisionBvhBuild(benchmark::State &state)
+{
+  urdf::ModelInterface model;
+  buildCollisionModel(static_cast<size_t>(state.range(0)), model);
+  urdf::CompiledModel compiled(model);
+  urdf::ForwardKinematics fk(compiled);
+  urdf::CollisionBvh bvh(compiled);
+
+  fk.update(bentConfiguration(fk.getNumPositions()).data());
+  for (auto _ : state)
+  {
+    bvh.build(fk.getLinkPoses().data());
+    benchmark::DoNotOptimize(bvh.getRootBox());
+  }
+  state.SetItemsProcessed(state.iterations() * bvh.getNumElements());
+}
+BENCHMARK(BM_CollisionBvhBuild)->Arg(10)->Arg(1000)->Arg(100000);
+
+static void BM_CollisionBvhRefit(benchmark::State &state)
+{
+  urdf::ModelInterface model;
+  buildCollisionModel(static_cast<size_t>(state.range(0)), model);
+  urdf::CompiledModel compiled(model);
+  urdf::ForwardKinematics fk(compiled);
+  urdf::CollisionBvh bvh(compiled);
+
+  fk.update(bentConfiguration(fk.getNumPositions()).data());
+  bvh.build(fk.getLinkPoses().data());
+  for (auto _ : state)
+  {
+    bvh.refit(fk.getLinkPoses().data());
+    benchmark::DoNotOptimize(bvh.getRootBox());
+  }
+  state.SetItemsProcessed(state.iterations() * bvh.getNumElements());
+}
+BENCHMARK(BM_CollisionBvhRefit)->Arg(10)->Arg(1000)->Arg(100000);
+
+static void BM_SelfCollisionPairs(benchmark::State &state)
+{
+  urdf::ModelInterface model;
+  buildCollisionModel(static_cast<size_t>(state.range(0)), model);
+  urdf::CompiledModel compiled(model);
+  urdf::ForwardKinematics fk(compiled);
+  urdf::CollisionBvh bvh(compiled);
+
+  fk.update(bentConfiguration(fk.getNumPositions()).data());
+  bvh.build(fk.getLinkPoses().data());
+  std::vector<urdf::CollisionBvh::Pair> pairs;
+  for (auto _ : state)
+  {
+    bvh.computeSelfCollisionPairs(pairs);
+    benchmark::DoNotOptimize(pairs.data());
+  }
+  state.counters["pairs"] = static_cast<double>(pairs.size());
+  state.SetItemsProcessed(state.iterations() * bvh.getNumElements());
+}
+BENCHMARK(BM_SelfCollisionPairs)->Arg(10)->Arg(1000)->Arg(100000);
+
+/// The all pairs box test the tree traversal replaces
+static void BM_SelfCollisionPairsAllPairs(benchmark::State &state)
+{
+  urdf::ModelInterface model;
+  buildCollisionModel(static_cast<size_t>(state.range(0)), model);
+  urdf::CompiledModel compiled(model);
+  urdf::ForwardKinematics fk(compiled);
+  urdf::CollisionBvh bvh(compiled);
+
+  fk.update(bentConfiguration(fk.getNumPositions()).data());
+  bvh.build(fk.getLinkPoses().data());
+  const int num_elements = static_cast<int>(bvh.getNumElements());
+  std::vector<urdf::CollisionBvh::Pair> pairs;
+  for (auto _ : state)
+  {
+    pairs.clear();
+    for (int a = 0; a < num_elements; ++a)
+    {
+      for (int b = a + 1; b < num_elements; ++b)
+      {
+        if (bvh.getElementBox(a).overlaps(bvh.getElementBox(b)) &&
+            !bvh.isExcludedLinkPair(bvh.getElementLink(a), bvh.getElementLink(b)))
+        {
+          pairs.push_back(urdf::CollisionBvh::Pair{a, b});
+        }
+      }
+    }
+    benchmark::DoNotOptimize(pairs.data());
+  }
+  state.counters["pairs"] = static_cast<double>(pairs.size());
+  state.SetItemsProcessed(state.iterations() * num_elements);
+}
+BENCHMARK(BM_SelfCollisionPairsAllPairs)->Arg(10)->Arg(1000)->Arg(10000);
+
+static void BM_SelfCollisionAnalysis(benchmark::State &state)
+{
+  const size_t num_samples = 256;
+  urdf::ModelInterface model;
+  buildCollisionModel(static_cast<size_t>(state.range(0)), model);
+  urdf::SelfCollisionAnalysis analysis{urdf::CompiledModel(model)};
+  urdf::ThreadPool pool;
+
+  std::uint64_t seed = 0;
+  for (auto _ : state)
+  {
+    analysis.sample(pool, num_samples, ++seed);
+  }
+  state.SetItemsProcessed(state.iterations() * num_samples);
+}
+BENCHMARK(BM_SelfCollisionAnalysis)->Arg(10)->Arg(100)->Arg(1000)->UseRealTime();
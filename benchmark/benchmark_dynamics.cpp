@@ -0,0 +1,170 @@
+/* Benchmarks for ClusterDynamics, CompositeRigidBody and InverseDynamics */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <urdf_model/composite_rigid_body.h>
+#include <urdf_model/dynamics.h>
+#include <urdf_model/inverse_dynamics.h>
+
+#include "synthetic_model.h"
+
+using urdf_benchmark::ModelShape;
+
+/// every fourth joint of the tree models is fixed
+static const size_t FIXED_EVERY = 4;
+
+/// \brief LOOPS model whose loops pin the far ends of two sibling links together
+///
+/// Each loop forms a two link cluster with one dependent coordinate.
+static void buildLoopModel(size_t num_links, urdf::ModelInterface &model)
+{
+  urdf_benchmark::buildRawModel(urdf_benchmark::LOOPS, num_links, model);
+  for (size_t i = 1; i + 1 < num_links; i += 2)
+  {
+    urdf::LoopConstraint &constraint =
+      static_cast<urdf::LoopConstraint &>(*model.constraints_["loop_" + std::to_string(i)]);
+    constraint.predecessor_to_constraint_origin_transform.position = urdf::Vector3(0.1, 0, 0);
+    constraint.successor_to_constraint_origin_transform.position = urdf::Vector3(0.1, 0, 0);
+    model.joints_[urdf_benchmark::jointName(i + 1)]->independent = false;
+  }
+  std::map<std::string, std::string> parent_link_tree;
+  model.initTree(parent_link_tree);
+  model.initRoot(parent_link_tree);
+}
+
+static void BM_ClusterDynamics(benchmark::State &state)
+{
+  const ModelShape shape = static_cast<ModelShape>(state.range(0));
+  const size_t num_links = static_cast<size_t>(state.range(1));
+  urdf::ModelInterface model;
+  if (shape == urdf_benchmark::LOOPS)
+  {
+    buildLoopModel(num_links, model);
+  }
+  else
+  {
+    urdf_benchmark::buildModel(shape, num_links, model, FIXED_EVERY);
+  }
+  urdf::ClusterDynamics dynamics{urdf::CompiledModel(model)};
+
+  std::vector<double> q(dynamics.getNumPositions(), 0.1);
+  std::vector<double> v(dynamics.getNumVelocities(), 0.0);
+  std::vector<double> tau(dynamics.getNumVelocities(), 0.0);
+  std::vector<double> vdot(dynamics.getNumVelocities());
+  for (auto _ : state)
+  {
+    dynamics.forwardDynamics(q.data(), v.data(), tau.data(), vdot.data());
+    benchmark::DoNotOptimize(vdot.data());
+    tau[0] += 1e-9;
+  }
+  state.SetItemsProcessed(state.iterations() * num_links);
+}
+BENCHMARK(BM_ClusterDynamics)
+  ->ArgsProduct({{urdf_benchmark::CHAIN, urdf_benchmark::WIDE_TREE, urdf_benchmark::LOOPS}, {10, 1000, 100000}});
+
+/// update() followed by the mass matrix and its factorization, as a whole body controller would per tick
+static void BM_MassMatrix(benchmark::State &state)
+{
+  const ModelShape shape = static_cast<ModelShape>(state.range(0));
+  const size_t num_links = static_cast<size_t>(state.range(1));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(shape, num_links, model, FIXED_EVERY);
+  urdf::CompositeRigidBody crb{urdf::CompiledModel(model)};
+
+  const size_t nv = crb.getNumVelocities();
+  std::vector<double> q(crb.getNumPositions(), 0.1);
+  std::vector<double> h(nv * nv);
+  for (auto _ : state)
+  {
+    crb.update(q.data());
+    crb.computeMassMatrix(h.data());
+    crb.factorize(h.data());
+    benchmark::DoNotOptimize(h.data());
+    q[0] += 1e-9;
+  }
+  state.SetItemsProcessed(state.iterations() * num_links);
+}
+BENCHMARK(BM_MassMatrix)
+  ->ArgsProduct({{urdf_benchmark::CHAIN, urdf_benchmark::WIDE_TREE}, {10, 100, 1000}});
+
+static void BM_CentroidalMomentumMatrix(benchmark::State &state)
+{
+  const ModelShape shape = static_cast<ModelShape>(state.range(0));
+  const size_t num_links = static_cast<size_t>(state.range(1));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(shape, num_links, model, FIXED_EVERY);
+  urdf::CompositeRigidBody crb{urdf::CompiledModel(model)};
+
+  std::vector<double> q(crb.getNumPositions(), 0.1);
+  std::vector<double> a(6 * crb.getNumVelocities());
+  for (auto _ : state)
+  {
+    crb.update(q.data());
+    crb.computeCentroidalMomentumMatrix(a.data());
+    benchmark::DoNotOptimize(a.data());
+    q[0] += 1e-9;
+  }
+  state.SetItemsProcessed(state.iterations() * num_links);
+}
+BENCHMARK(BM_CentroidalMomentumMatrix)
+  ->ArgsProduct({{urdf_benchmark::CHAIN, urdf_benchmark::WIDE_TREE}, {10, 1000, 100000}});
+
+/// number of samples evaluated per iteration by the inverse dynamics benchmarks
+static const size_t NUM_SAMPLES = 1024;
+
+/// One InverseDynamics::compute() call per sample
+static void BM_InverseDynamics(benchmark::State &state)
+{
+  const ModelShape shape = static_cast<ModelShape>(state.range(0));
+  const size_t num_links = static_cast<size_t>(state.range(1));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(shape, num_links, model, FIXED_EVERY);
+  urdf::InverseDynamics id{urdf::CompiledModel(model)};
+
+  const size_t nq = id.getNumPositions();
+  const size_t nv = id.getNumVelocities();
+  std::vector<double> q(nq * NUM_SAMPLES, 0.1);
+  std::vector<double> v(nv * NUM_SAMPLES, 0.2);
+  std::vector<double> a(nv * NUM_SAMPLES, 0.3);
+  std::vector<double> tau(nv * NUM_SAMPLES);
+  for (auto _ : state)
+  {
+    for (size_t s = 0; s < NUM_SAMPLES; ++s)
+    {
+      id.compute(&q[s * nq], &v[s * nv], &a[s * nv], &tau[s * nv]);
+    }
+    benchmark::DoNotOptimize(tau.data());
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_SAMPLES);
+}
+BENCHMARK(BM_InverseDynamics)
+  ->ArgsProduct({{urdf_benchmark::CHAIN, urdf_benchmark::WIDE_TREE}, {10, 100, 1000}});
+
+/// The same samples through InverseDynamics::computeBatch()
+static void BM_InverseDynamicsBatch(benchmark::State &state)
+{
+  const ModelShape shape = static_cast<ModelShape>(state.range(0));
+  const size_t num_links = static_cast<size_t>(state.range(1));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(shape, num_links, model, FIXED_EVERY);
+  urdf::InverseDynamics id{urdf::CompiledModel(model)};
+
+  const size_t nq = id.getNumPositions();
+  const size_t nv = id.getNumVelocities();
+  std::vector<double> q(nq * NUM_SAMPLES, 0.1);
+  std::vector<double> v(nv * NUM_SAMPLES, 0.2);
+  std::vector<double> a(nv * NUM_SAMPLES, 0.3);
+  std::vector<double> tau(nv * NUM_SAMPLES);
+  for (auto _ : state)
+  {
+    id.computeBatch(NUM_SAMPLES, q.data(), v.data(), a.data(), tau.data());
+    benchmark::DoNotOptimize(tau.data());
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_SAMPLES);
+}
+BENCHMARK(BM_InverseDynamicsBatch)
+  ->ArgsProduct({{urdf_benchmark::CHAIN, urdf_benchmark::WIDE_TREE}, {10, 100, 1000}});
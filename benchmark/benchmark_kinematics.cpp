@@ -0,0 +1,190 @@
+/* Benchmarks for ForwardKinematics, ParallelForwardKinematics and GeometricJacobian */
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <urdf_model/forward_kinematics.h>
+#include <urdf_model/jacobian.h>
+#include <urdf_model/parallel_kinematics.h>
+
+#include "synthetic_model.h"
+
+using urdf_benchmark::ModelShape;
+
+/// every fourth joint of the benchmark models is fixed
+static const size_t FIXED_EVERY = 4;
+
+static void BM_ForwardKinematics(benchmark::State &state)
+{
+  const ModelShape shape = static_cast<ModelShape>(state.range(0));
+  const size_t num_links = static_cast<size_t>(state.range(1));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(shape, num_links, model, FIXED_EVERY);
+  urdf::ForwardKinematics fk{urdf::CompiledModel(model)};
+
+  std::vector<double> q(fk.getNumPositions(), 0.1);
+  for (auto _ : state)
+  {
+    fk.update(q.data());
+    benchmark::DoNotOptimize(fk.getLinkPoses().data());
+    q[0] += 1e-9;
+  }
+  state.SetItemsProcessed(state.iterations() * num_links);
+}
+BENCHMARK(BM_ForwardKinematics)
+  ->ArgsProduct({{urdf_benchmark::CHAIN, urdf_benchmark::WIDE_TREE}, {10, 1000, 100000}});
+
+/// The recursive walk over Link::child_links with name keyed maps that
+/// ForwardKinematics replaces
+static void BM_ForwardKinematicsRecursive(benchmark::State &state)
+{
+  const ModelShape shape = static_cast<ModelShape>(state.range(0));
+  const size_t num_links = static_cast<size_t>(state.range(1));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(shape, num_links, model, FIXED_EVERY);
+
+  std::map<std::string, double> positions;
+  for (std::map<std::string, urdf::JointSharedPtr>::const_iterator joint = model.joints_.begin();
+       joint != model.joints_.end(); ++joint)
+  {
+    positions[joint->first] = 0.1;
+  }
+
+  std::map<std::string, urdf::Pose> poses;
+  std::function<void(const urdf::Link &, const urdf::Pose &)> walk =
+    [&](const urdf::Link &link, const urdf::Pose &pose)
+  {
+    poses[link.name] = pose;
+    for (const urdf::LinkSharedPtr &child : link.child_links)
+    {
+      const urdf::Joint &joint = *child->parent_joint;
+      urdf::Pose motion;
+      if (joint.type != urdf::Joint::FIXED)
+      {
+        const double angle = positions.find(joint.name)->second;
+        const double s = std::sin(0.5 * angle);
+        motion.rotation = urdf::Rotation(joint.axis.x * s, joint.axis.y * s, joint.axis.z * s, std::cos(0.5 * angle));
+      }
+      walk(*child, pose * joint.parent_to_joint_origin_transform * motion);
+    }
+  };
+
+  // the recursion depth of a long chain would overflow the stack
+  if (shape == urdf_benchmark::CHAIN && num_links > 10000)
+  {
+    state.SkipWithError("chain too deep for a recursive walk");
+    return;
+  }
+  for (auto _ : state)
+  {
+    walk(*model.getRoot(), urdf::Pose());
+    benchmark::DoNotOptimize(poses);
+  }
+  state.SetItemsProcessed(state.iterations() * num_links);
+}
+BENCHMARK(BM_ForwardKinematicsRecursive)
+  ->ArgsProduct({{urdf_benchmark::CHAIN, urdf_benchmark::WIDE_TREE}, {10, 1000, 100000}});
+
+/// Only the last joint in preorder moves, as for a wrist on an arm
+static void BM_ForwardKinematicsIncremental(benchmark::State &state)
+{
+  const ModelShape shape = static_cast<ModelShape>(state.range(0));
+  const size_t num_links = static_cast<size_t>(state.range(1));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(shape, num_links, model, FIXED_EVERY);
+  urdf::ForwardKinematics fk{urdf::CompiledModel(model)};
+
+  std::vector<double> q(fk.getNumPositions(), 0.1);
+  fk.update(q.data());
+  for (auto _ : state)
+  {
+    q.back() += 1e-9;
+    benchmark::DoNotOptimize(fk.updateIncremental(q.data()));
+  }
+  state.SetItemsProcessed(state.iterations() * num_links);
+}
+BENCHMARK(BM_ForwardKinematicsIncremental)
+  ->ArgsProduct({{urdf_benchmark::CHAIN, urdf_benchmark::WIDE_TREE}, {10, 1000, 100000}});
+
+/// configurations per iteration of BM_ParallelForwardKinematics
+static const size_t NUM_CONFIGURATIONS = 16384;
+
+/// \brief One batch of configurations of a CHAIN model on a pool of state.range(1) threads
+///
+/// Wall clock time, so items per second should grow close to linearly with
+/// the thread count up to the number of cores.
+static void BM_ParallelForwardKinematics(benchmark::State &state)
+{
+  const size_t num_links = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(urdf_benchmark::CHAIN, num_links, model, FIXED_EVERY);
+  urdf::ParallelForwardKinematics fk{urdf::CompiledModel(model)};
+  urdf::ThreadPool pool(static_cast<size_t>(state.range(1)));
+
+  const size_t nq = fk.getNumPositions();
+  std::vector<double> q(nq * NUM_CONFIGURATIONS);
+  for (size_t k = 0; k < q.size(); ++k)
+  {
+    q[k] = 1e-3 * static_cast<double>(k % 1000);
+  }
+  std::vector<urdf::Pose> poses(fk.getNumLinks() * NUM_CONFIGURATIONS);
+  for (auto _ : state)
+  {
+    fk.computeBatch(pool, NUM_CONFIGURATIONS, q.data(), poses.data());
+    benchmark::DoNotOptimize(poses.data());
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_CONFIGURATIONS);
+  state.counters["threads"] = static_cast<double>(pool.getNumThreads());
+}
+
+/// powers of two up to the core count, and the core count itself
+static void threadCounts(benchmark::internal::Benchmark *benchmark)
+{
+  const int num_cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  for (int num_links : {10, 50})
+  {
+    for (int threads = 1; threads < num_cores; threads *= 2)
+    {
+      benchmark->Args({num_links, threads});
+    }
+    benchmark->Args({num_links, num_cores});
+  }
+}
+BENCHMARK(BM_ParallelForwardKinematics)->Apply(threadCounts)->UseRealTime();
+
+/// update() with velocities, then the sparse Jacobian and its derivative at
+/// the last link, as an operational space controller would per tick
+static void BM_GeometricJacobian(benchmark::State &state)
+{
+  const ModelShape shape = static_cast<ModelShape>(state.range(0));
+  const size_t num_links = static_cast<size_t>(state.range(1));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(shape, num_links, model, FIXED_EVERY);
+  urdf::GeometricJacobian jacobian{urdf::CompiledModel(model)};
+
+  const int link = static_cast<int>(jacobian.getNumLinks()) - 1;
+  const urdf::Vector3 point(0.1, 0.0, 0.0);
+  std::vector<double> q(jacobian.getNumPositions(), 0.1);
+  std::vector<double> v(jacobian.getNumVelocities(), 0.2);
+  std::vector<double> columns(6 * jacobian.getSupportSize(link));
+  std::vector<double> derivative(columns.size());
+  for (auto _ : state)
+  {
+    jacobian.update(q.data(), v.data());
+    jacobian.computeSparseJacobian(link, point, urdf::GeometricJacobian::WORLD, columns.data());
+    jacobian.computeSparseJacobianDerivative(link, point, urdf::GeometricJacobian::WORLD, derivative.data());
+    benchmark::DoNotOptimize(columns.data());
+    benchmark::DoNotOptimize(derivative.data());
+    q[0] += 1e-9;
+  }
+  state.SetItemsProcessed(state.iterations() * num_links);
+}
+BENCHMARK(BM_GeometricJacobian)
+  ->ArgsProduct({{urdf_benchmark::CHAIN, urdf_benchmark::WIDE_TREE}, {10, 100, 1000}});
@@ -0,0 +1,125 @@
+/* Benchmarks for JointLimitTable */
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <urdf_model/joint_limits.h>
+
+#include "synthetic_model.h"
+
+/// CHAIN model whose joints all have limits and a safety controller
+static void buildLimitedModel(size_t num_links, urdf::ModelInterface &model)
+{
+  urdf_benchmark::buildModel(urdf_benchmark::CHAIN, num_links, model);
+  for (size_t i = 1; i < num_links; ++i)
+  {
+    urdf::Joint &joint = *model.joints_[urdf_benchmark::jointName(i)];
+    joint.limits.reset(new urdf::JointLimits());
+    joint.limits->lower = -2.0;
+    joint.limits->upper = 2.0;
+    joint.limits->velocity = 1.0;
+    joint.limits->effort = 10.0;
+    joint.safety.reset(new urdf::JointSafety());
+    joint.safety->soft_lower_limit = -1.8;
+    joint.safety->soft_upper_limit = 1.8;
+    joint.safety->k_position = 20.0;
+    joint.safety->k_velocity = 50.0;
+  }
+}
+
+/// joint states spread over and beyond the soft limits
+static void fillStates(size_t n, std::vector<double> &q, std::vector<double> &v, std::vector<double> &effort)
+{
+  q.resize(n);
+  v.resize(n);
+  effort.resize(n);
+  for (size_t e = 0; e < n; ++e)
+  {
+    q[e] = -2.2 + 4.4 * static_cast<double>((e * 37) % 101) / 100.0;
+    v[e] = -1.5 + 3.0 * static_cast<double>((e * 53) % 97) / 96.0;
+    effort[e] = -12.0 + 24.0 * static_cast<double>((e * 71) % 89) / 88.0;
+  }
+}
+
+static void BM_SaturateEfforts(benchmark::State &state)
+{
+  const size_t num_links = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  buildLimitedModel(num_links, model);
+  urdf::JointLimitTable table{urdf::CompiledModel(model)};
+
+  std::vector<double> q, v, effort, out(table.size());
+  fillStates(table.size(), q, v, effort);
+  for (auto _ : state)
+  {
+    table.saturateEfforts(q.data(), v.data(), effort.data(), out.data());
+    benchmark::DoNotOptimize(out.data());
+    q[0] += 1e-9;
+  }
+  state.SetItemsProcessed(state.iterations() * table.size());
+}
+BENCHMARK(BM_SaturateEfforts)->Arg(10)->Arg(1000)->Arg(100000);
+
+/// The same saturation through each joint's JointLimits and JointSafety
+static void BM_SaturateEffortsPerJoint(benchmark::State &state)
+{
+  const size_t num_links = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  buildLimitedModel(num_links, model);
+  std::vector<urdf::JointConstSharedPtr> joints;
+  for (size_t i = 1; i < num_links; ++i)
+  {
+    joints.push_back(model.getJoint(urdf_benchmark::jointName(i)));
+  }
+
+  std::vector<double> q, v, effort, out(joints.size());
+  fillStates(joints.size(), q, v, effort);
+  for (auto _ : state)
+  {
+    for (size_t e = 0; e < joints.size(); ++e)
+    {
+      const urdf::JointLimits &limits = *joints[e]->limits;
+      const urdf::JointSafety &safety = *joints[e]->safety;
+      double v_min = -limits.velocity, v_max = limits.velocity;
+      if (q[e] < safety.soft_lower_limit + limits.velocity / safety.k_position ||
+          q[e] > safety.soft_upper_limit - limits.velocity / safety.k_position)
+      {
+        v_min += safety.k_position * (q[e] - safety.soft_lower_limit);
+        v_max += safety.k_position * (q[e] - safety.soft_upper_limit);
+      }
+      double e_min = -limits.effort, e_max = limits.effort;
+      if (v[e] < v_min + limits.effort / safety.k_velocity || v[e] > v_max - limits.effort / safety.k_velocity)
+      {
+        e_min += safety.k_velocity * (v[e] - v_min);
+        e_max += safety.k_velocity * (v[e] - v_max);
+      }
+      out[e] = std::min(std::max(effort[e], e_min), e_max);
+    }
+    benchmark::DoNotOptimize(out.data());
+    q[0] += 1e-9;
+  }
+  state.SetItemsProcessed(state.iterations() * joints.size());
+}
+BENCHMARK(BM_SaturateEffortsPerJoint)->Arg(10)->Arg(1000)->Arg(100000);
+
+static void BM_CheckViolations(benchmark::State &state)
+{
+  const size_t num_links = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  buildLimitedModel(num_links, model);
+  urdf::JointLimitTable table{urdf::CompiledModel(model)};
+
+  std::vector<double> q, v, effort;
+  std::vector<std::uint8_t> violations(table.size());
+  fillStates(table.size(), q, v, effort);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(table.checkViolations(q.data(), v.data(), effort.data(), violations.data()));
+    q[0] += 1e-9;
+  }
+  state.SetItemsProcessed(state.iterations() * table.size());
+}
+BENCHMARK(BM_CheckViolations)->Arg(10)->Arg(1000)->Arg(100000);
@@ -0,0 +1,291 @@
+/* Benchmarks for ModelInterface lookups, tree construction, snapshots and CoordinateMap */
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <urdf_model/coordinate_map.h>
+#include <urdf_model/model.h>
+#include <urdf_model/model_snapshot.h>
+
+#include "legacy_init_tree.h"
+#include "synthetic_model.h"
+
+using urdf_benchmark::ModelShape;
+
+static void BM_GetLink(benchmark::State &state)
+{
+  const size_t num_links = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(urdf_benchmark::WIDE_TREE, num_links, model);
+
+  std::vector<std::string> names;
+  for (size_t i = 0; i < num_links; ++i)
+    names.push_back(urdf_benchmark::linkName((i * 7919) % num_links));
+
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    urdf::LinkConstSharedPtr link = model.getLink(names[i]);
+    benchmark::DoNotOptimize(link);
+    if (++i == names.size()) i = 0;
+  }
+}
+BENCHMARK(BM_GetLink)->Arg(10)->Arg(1000)->Arg(100000);
+
+static void BM_GetLinkNameIndex(benchmark::State &state)
+{
+  const size_t num_links = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(urdf_benchmark::WIDE_TREE, num_links, model);
+  model.buildNameIndex();
+
+  std::vector<std::string> names;
+  for (size_t i = 0; i < num_links; ++i)
+    names.push_back(urdf_benchmark::linkName((i * 7919) % num_links));
+
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    urdf::LinkConstSharedPtr link = model.getLink(names[i]);
+    benchmark::DoNotOptimize(link);
+    if (++i == names.size()) i = 0;
+  }
+}
+BENCHMARK(BM_GetLinkNameIndex)->Arg(10)->Arg(1000)->Arg(100000);
+
+static void BM_GetLinkByHandle(benchmark::State &state)
+{
+  const size_t num_links = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(urdf_benchmark::WIDE_TREE, num_links, model);
+  model.buildNameIndex();
+
+  std::vector<int> handles;
+  for (size_t i = 0; i < num_links; ++i)
+    handles.push_back(model.getLinkHandle(urdf_benchmark::linkName((i * 7919) % num_links)));
+
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    const urdf::Link &link = *model.getLinkByHandle(handles[i]);
+    benchmark::DoNotOptimize(&link);
+    if (++i == handles.size()) i = 0;
+  }
+}
+BENCHMARK(BM_GetLinkByHandle)->Arg(10)->Arg(1000)->Arg(100000);
+
+static void BM_GetJoint(benchmark::State &state)
+{
+  const size_t num_links = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(urdf_benchmark::WIDE_TREE, num_links, model);
+
+  std::vector<std::string> names;
+  for (size_t i = 1; i < num_links; ++i)
+    names.push_back(urdf_benchmark::jointName(1 + (i * 7919) % (num_links - 1)));
+
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    urdf::JointConstSharedPtr joint = model.getJoint(names[i]);
+    benchmark::DoNotOptimize(joint);
+    if (++i == names.size()) i = 0;
+  }
+}
+BENCHMARK(BM_GetJoint)->Arg(10)->Arg(1000)->Arg(100000);
+
+static void BM_GetNearestCommonAncestor(benchmark::State &state)
+{
+  const size_t num_links = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(urdf_benchmark::CHAIN, num_links, model);
+
+  std::vector<std::pair<std::string, std::string> > queries;
+  for (size_t i = 0; i < 1024; ++i)
+    queries.push_back(std::make_pair(urdf_benchmark::linkName((i * 7919) % num_links),
+                                     urdf_benchmark::linkName((i * 104729) % num_links)));
+
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    urdf::LinkConstSharedPtr ancestor = model.getNearestCommonAncestor(queries[i].first, queries[i].second);
+    benchmark::DoNotOptimize(ancestor);
+    if (++i == queries.size()) i = 0;
+  }
+}
+BENCHMARK(BM_GetNearestCommonAncestor)->Arg(10)->Arg(1000)->Arg(100000);
+
+template <bool Legacy>
+static void BM_InitTree(benchmark::State &state)
+{
+  const ModelShape shape = static_cast<ModelShape>(state.range(0));
+  const size_t num_links = static_cast<size_t>(state.range(1));
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    std::unique_ptr<urdf::ModelInterface> model(new urdf::ModelInterface());
+    urdf_benchmark::buildRawModel(shape, num_links, *model);
+    std::map<std::string, std::string> parent_link_tree;
+    state.ResumeTiming();
+
+    if (Legacy)
+      urdf_benchmark::legacyInitTree(*model, parent_link_tree);
+    else
+      model->initTree(parent_link_tree);
+    model->initRoot(parent_link_tree);
+    benchmark::DoNotOptimize(model->clusters_.size());
+
+    // keep tearing down the links out of the measurement
+    state.PauseTiming();
+    model.reset();
+    state.ResumeTiming();
+  }
+}
+BENCHMARK_TEMPLATE(BM_InitTree, false)
+  ->ArgNames({"shape", "links"})
+  ->ArgsProduct({{urdf_benchmark::CHAIN, urdf_benchmark::WIDE_TREE, urdf_benchmark::LOOPS},
+                 {10, 1000, 100000}})
+  ->Unit(benchmark::kMicrosecond);
+// The recursive implementation overflows the stack on chains much deeper
+// than 10k links
+BENCHMARK_TEMPLATE(BM_InitTree, true)
+  ->Name("BM_InitTreeLegacy")
+  ->ArgNames({"shape", "links"})
+  ->Args({urdf_benchmark::CHAIN, 10})
+  ->Args({urdf_benchmark::CHAIN, 1000})
+  ->Args({urdf_benchmark::CHAIN, 10000})
+  ->ArgsProduct({{urdf_benchmark::WIDE_TREE, urdf_benchmark::LOOPS}, {10, 1000, 100000}})
+  ->Unit(benchmark::kMicrosecond);
+
+/// Map a snapshot file and resolve one link, the startup cost BM_InitTree compares with
+static void BM_SnapshotOpen(benchmark::State &state)
+{
+  const ModelShape shape = static_cast<ModelShape>(state.range(0));
+  const size_t num_links = static_cast<size_t>(state.range(1));
+  const std::string filename =
+    (std::filesystem::temp_directory_path() / ("urdfdom_headers_benchmark_" + std::to_string(num_links) + ".snap")).string();
+  {
+    urdf::ModelInterface model;
+    urdf_benchmark::buildModel(shape, num_links, model);
+    urdf::ModelSnapshot::writeFile(model, filename);
+  }
+  const std::string name = urdf_benchmark::linkName(num_links / 2);
+  for (auto _ : state)
+  {
+    urdf::ModelSnapshot snapshot(filename);
+    benchmark::DoNotOptimize(snapshot.getLinkIndex(name));
+  }
+  std::filesystem::remove(filename);
+}
+BENCHMARK(BM_SnapshotOpen)
+  ->ArgNames({"shape", "links"})
+  ->ArgsProduct({{urdf_benchmark::CHAIN, urdf_benchmark::WIDE_TREE, urdf_benchmark::LOOPS},
+                 {10, 1000, 100000}})
+  ->Unit(benchmark::kMicrosecond);
+
+/// Rebuild a ModelInterface from a snapshot in memory, without initTree()
+static void BM_SnapshotToModel(benchmark::State &state)
+{
+  const ModelShape shape = static_cast<ModelShape>(state.range(0));
+  const size_t num_links = static_cast<size_t>(state.range(1));
+  std::vector<std::uint64_t> image;
+  {
+    urdf::ModelInterface model;
+    urdf_benchmark::buildModel(shape, num_links, model);
+    std::ostringstream out;
+    urdf::ModelSnapshot::write(model, out);
+    const std::string bytes = out.str();
+    image.resize(bytes.size() / 8);
+    std::memcpy(image.data(), bytes.data(), bytes.size());
+  }
+  urdf::ModelSnapshot snapshot;
+  snapshot.attach(image.data(), image.size() * 8);
+  for (auto _ : state)
+  {
+    std::unique_ptr<urdf::ModelInterface> model(new urdf::ModelInterface());
+    snapshot.toModel(*model);
+    benchmark::DoNotOptimize(model->clusters_.size());
+
+    state.PauseTiming();
+    model.reset();
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_SnapshotToModel)
+  ->ArgNames({"shape", "links"})
+  ->ArgsProduct({{urdf_benchmark::CHAIN, urdf_benchmark::WIDE_TREE, urdf_benchmark::LOOPS},
+                 {10, 1000, 100000}})
+  ->Unit(benchmark::kMicrosecond);
+
+/// CHAIN model in which every third joint mimics the joint before it
+static void buildMimicModel(size_t num_links, urdf::ModelInterface &model)
+{
+  urdf_benchmark::buildModel(urdf_benchmark::CHAIN, num_links, model);
+  for (size_t i = 3; i < num_links; i += 3)
+  {
+    urdf::JointMimicSharedPtr mimic(new urdf::JointMimic());
+    mimic->joint_name = urdf_benchmark::jointName(i - 1);
+    mimic->multiplier = -1.0;
+    mimic->offset = 0.1;
+    model.joints_[urdf_benchmark::jointName(i)]->mimic = mimic;
+  }
+}
+
+static void BM_ExpandPositions(benchmark::State &state)
+{
+  const size_t num_links = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  buildMimicModel(num_links, model);
+  urdf::CoordinateMap map{urdf::CompiledModel(model)};
+
+  std::vector<double> reduced(map.getNumReducedPositions(), 0.1);
+  std::vector<double> full(map.getNumPositions());
+  for (auto _ : state)
+  {
+    map.expandPositions(reduced.data(), full.data());
+    benchmark::DoNotOptimize(full.data());
+    reduced[0] += 1e-9;
+  }
+  state.SetItemsProcessed(state.iterations() * full.size());
+}
+BENCHMARK(BM_ExpandPositions)->Arg(10)->Arg(1000)->Arg(100000);
+
+/// The same expansion resolving JointMimic::joint_name on every call
+static void BM_ExpandPositionsByName(benchmark::State &state)
+{
+  const size_t num_links = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  buildMimicModel(num_links, model);
+
+  std::map<std::string, double> positions;
+  for (std::map<std::string, urdf::JointSharedPtr>::const_iterator joint = model.joints_.begin();
+       joint != model.joints_.end(); ++joint)
+  {
+    if (!joint->second->mimic)
+    {
+      positions[joint->first] = 0.1;
+    }
+  }
+  for (auto _ : state)
+  {
+    for (size_t i = 1; i < num_links; ++i)
+    {
+      const urdf::JointConstSharedPtr joint = model.getJoint(urdf_benchmark::jointName(i));
+      if (joint->mimic)
+      {
+        positions[joint->name] = joint->mimic->multiplier * positions[joint->mimic->joint_name] + joint->mimic->offset;
+      }
+    }
+    benchmark::DoNotOptimize(positions);
+  }
+  state.SetItemsProcessed(state.iterations() * (num_links - 1));
+}
+BENCHMARK(BM_ExpandPositionsByName)->Arg(10)->Arg(1000)->Arg(100000);
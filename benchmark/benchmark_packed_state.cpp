@@ -0,0 +1,112 @@
+/* Benchmarks for packed model states and StateHistory */
+
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <urdf_model_state/packed_state.h>
+
+#include "synthetic_model.h"
+
+/// states kept by the history benchmarks, ten seconds at 1 kHz
+static const size_t HISTORY_CAPACITY = 10000;
+
+/// a ModelState with one JointState per joint of the chain layout
+static void buildState(const urdf::StateLayout &layout, urdf::ModelState &state)
+{
+  urdf::PackedModelState packed(layout);
+  packed.toModelState(state);
+}
+
+static void sample(size_t r, urdf::ModelState &state)
+{
+  const double t = 1e-3 * static_cast<double>(r);
+  state.time_stamp.sec = static_cast<int32_t>(r / 1000);
+  state.time_stamp.nsec = static_cast<int32_t>(r % 1000) * 1000000;
+  for (size_t k = 0; k < state.joint_states.size(); ++k)
+  {
+    urdf::JointState &joint = *state.joint_states[k];
+    joint.position[0] = std::sin((1.0 + 0.1 * static_cast<double>(k)) * t);
+    joint.velocity[0] = std::cos((1.0 + 0.1 * static_cast<double>(k)) * t);
+    joint.effort[0] = 0.0;
+  }
+}
+
+/// a history of deep copied ModelStates, one JointState per joint and push
+static void BM_ModelStateHistory(benchmark::State &state)
+{
+  const size_t num_joints = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(urdf_benchmark::CHAIN, num_joints + 1, model);
+  const urdf::StateLayout layout{urdf::CompiledModel(model)};
+  urdf::ModelState current;
+  buildState(layout, current);
+
+  std::deque<urdf::ModelState> history;
+  size_t r = 0;
+  for (auto _ : state)
+  {
+    sample(r++, current);
+    if (history.size() == HISTORY_CAPACITY)
+    {
+      history.pop_front();
+    }
+    history.emplace_back();
+    urdf::ModelState &copy = history.back();
+    copy.time_stamp = current.time_stamp;
+    for (const urdf::JointStateSharedPtr &joint : current.joint_states)
+    {
+      copy.joint_states.emplace_back(new urdf::JointState(*joint));
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ModelStateHistory)->Arg(10)->Arg(40)->Arg(200);
+
+/// the same history as packed states
+static void BM_StateHistoryPush(benchmark::State &state)
+{
+  const size_t num_joints = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(urdf_benchmark::CHAIN, num_joints + 1, model);
+  const urdf::StateLayout layout{urdf::CompiledModel(model)};
+  urdf::ModelState current;
+  buildState(layout, current);
+
+  urdf::StateHistory history(layout, HISTORY_CAPACITY);
+  size_t r = 0;
+  for (auto _ : state)
+  {
+    sample(r++, current);
+    benchmark::DoNotOptimize(history.push(current).data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StateHistoryPush)->Arg(10)->Arg(40)->Arg(200);
+
+/// a packed state back into a reused ModelState
+static void BM_PackedStateToModelState(benchmark::State &state)
+{
+  const size_t num_joints = static_cast<size_t>(state.range(0));
+  urdf::ModelInterface model;
+  urdf_benchmark::buildModel(urdf_benchmark::CHAIN, num_joints + 1, model);
+  const urdf::StateLayout layout{urdf::CompiledModel(model)};
+  urdf::PackedModelState packed(layout);
+  for (size_t i = 0; i < layout.getSize(); ++i)
+  {
+    packed.view().data()[i] = 1e-3 * static_cast<double>(i);
+  }
+
+  urdf::ModelState out;
+  for (auto _ : state)
+  {
+    packed.toModelState(out);
+    benchmark::DoNotOptimize(out.joint_states.data());
+    packed.positions()[0] += 1e-9;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PackedStateToModelState)->Arg(10)->Arg(40)->Arg(200);
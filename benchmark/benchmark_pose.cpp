@@ -0,0 +1,73 @@
+/* Benchmarks for the value types in urdf_model/pose.h */
+
+#include <benchmark/benchmark.h>
+
+#include <urdf_model/pose.h>
+
+static void BM_Vector3Init(benchmark::State &state)
+{
+  const std::string xyz = "0.125 -1.5e-3 42";
+  urdf::Vector3 v;
+  for (auto _ : state)
+  {
+    v.init(xyz);
+    benchmark::DoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_Vector3Init);
+
+static void BM_RotationInit(benchmark::State &state)
+{
+  const std::string rpy = "0.1 -0.2 1.5707963267948966";
+  urdf::Rotation r;
+  for (auto _ : state)
+  {
+    r.init(rpy);
+    benchmark::DoNotOptimize(r);
+  }
+}
+BENCHMARK(BM_RotationInit);
+
+static void BM_RotationSetFromRPY(benchmark::State &state)
+{
+  urdf::Rotation r;
+  double roll = 0.1;
+  for (auto _ : state)
+  {
+    r.setFromRPY(roll, -0.2, 0.3);
+    benchmark::DoNotOptimize(r);
+    roll += 1e-9;
+  }
+}
+BENCHMARK(BM_RotationSetFromRPY);
+
+static void BM_RotationGetRPY(benchmark::State &state)
+{
+  urdf::Rotation r;
+  r.setFromRPY(0.1, -0.2, 0.3);
+  double roll, pitch, yaw;
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(r);
+    r.getRPY(roll, pitch, yaw);
+    benchmark::DoNotOptimize(roll);
+    benchmark::DoNotOptimize(pitch);
+    benchmark::DoNotOptimize(yaw);
+  }
+}
+BENCHMARK(BM_RotationGetRPY);
+
+static void BM_RotationRotateVector(benchmark::State &state)
+{
+  urdf::Rotation r;
+  r.setFromRPY(0.1, -0.2, 0.3);
+  urdf::Vector3 v(1.0, 2.0, 3.0);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(r);
+    benchmark::DoNotOptimize(v);
+    urdf::Vector3 result = r * v;
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_RotationRotateVector);
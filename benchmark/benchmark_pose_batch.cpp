@@ -0,0 +1,93 @@
+/* Benchmarks for the batched kernels in urdf_model/pose_batch.h */
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include <urdf_model/pose_batch.h>
+
+static urdf::PoseArray makePoses(std::size_t n, double offset)
+{
+  urdf::PoseArray poses(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    urdf::Pose pose;
+    pose.position = urdf::Vector3(0.1 * i, offset, 1.0);
+    pose.rotation.setFromRPY(0.001 * i, offset, 0.3);
+    poses.set(i, pose);
+  }
+  return poses;
+}
+
+/// one Pose multiplication at a time, for comparison with BM_ComposePoses
+static void BM_ComposePosesLoop(benchmark::State &state)
+{
+  const std::size_t n = state.range(0);
+  const urdf::PoseArray a = makePoses(n, 0.1), b = makePoses(n, -0.2);
+  urdf::PoseArray out(n);
+  for (auto _ : state)
+  {
+    urdf::detail::composePosesScalar(0, n, a, b, out);
+    benchmark::DoNotOptimize(out.qw.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_ComposePosesLoop)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_ComposePoses(benchmark::State &state)
+{
+  const std::size_t n = state.range(0);
+  const urdf::PoseArray a = makePoses(n, 0.1), b = makePoses(n, -0.2);
+  urdf::PoseArray out(n);
+  for (auto _ : state)
+  {
+    urdf::composePoses(a, b, out);
+    benchmark::DoNotOptimize(out.qw.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_ComposePoses)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_TransformPointsLoop(benchmark::State &state)
+{
+  const std::size_t n = state.range(0);
+  const urdf::PoseArray poses = makePoses(1, 0.1);
+  const urdf::detail::AffineTransform transform(poses.get(0));
+  std::vector<double> x(n, 1.0), y(n, 2.0), z(n, 3.0), out_x(n), out_y(n), out_z(n);
+  for (auto _ : state)
+  {
+    urdf::detail::transformPointsScalar(transform, 0, n, x.data(), y.data(), z.data(),
+                                        out_x.data(), out_y.data(), out_z.data());
+    benchmark::DoNotOptimize(out_z.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_TransformPointsLoop)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_TransformPoints(benchmark::State &state)
+{
+  const std::size_t n = state.range(0);
+  const urdf::PoseArray poses = makePoses(1, 0.1);
+  const urdf::Pose pose = poses.get(0);
+  std::vector<double> x(n, 1.0), y(n, 2.0), z(n, 3.0), out_x(n), out_y(n), out_z(n);
+  for (auto _ : state)
+  {
+    urdf::transformPoints(pose, n, x.data(), y.data(), z.data(), out_x.data(), out_y.data(), out_z.data());
+    benchmark::DoNotOptimize(out_z.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_TransformPoints)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_RpyToQuaternions(benchmark::State &state)
+{
+  const std::size_t n = state.range(0);
+  std::vector<double> roll(n, 0.1), pitch(n, -0.2), yaw(n, 0.3), qx(n), qy(n), qz(n), qw(n);
+  for (auto _ : state)
+  {
+    urdf::rpyToQuaternions(n, roll.data(), pitch.data(), yaw.data(), qx.data(), qy.data(), qz.data(), qw.data());
+    benchmark::DoNotOptimize(qw.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_RpyToQuaternions)->Arg(1 << 10);
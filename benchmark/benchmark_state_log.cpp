@@ -0,0 +1,164 @@
+/* Benchmarks for StateLogWriter and StateLogReader */
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <urdf_model_state/state_log.h>
+
+/// ModelState of a robot with num_joints single DoF joints
+static void buildState(size_t num_joints, urdf::ModelState &state)
+{
+  state.clear();
+  for (size_t k = 0; k < num_joints; ++k)
+  {
+    urdf::JointStateSharedPtr joint(new urdf::JointState());
+    joint->joint = "joint_" + std::to_string(k);
+    joint->position.assign(1, 0.0);
+    joint->velocity.assign(1, 0.0);
+    joint->effort.assign(1, 0.0);
+    state.joint_states.push_back(joint);
+  }
+}
+
+/// smooth joint motion sampled at 1 kHz, efforts quantized like a motor driver reports them
+static void sample(size_t r, urdf::ModelState &state)
+{
+  const double t = 1e-3 * static_cast<double>(r);
+  state.time_stamp.sec = static_cast<int32_t>(r / 1000);
+  state.time_stamp.nsec = static_cast<int32_t>(r % 1000) * 1000000;
+  for (size_t k = 0; k < state.joint_states.size(); ++k)
+  {
+    urdf::JointState &joint = *state.joint_states[k];
+    const double w = 1.0 + 0.1 * static_cast<double>(k);
+    joint.position[0] = std::sin(w * t);
+    joint.velocity[0] = w * std::cos(w * t);
+    joint.effort[0] = std::round(100.0 * std::sin(0.5 * w * t)) / 100.0;
+  }
+}
+
+/// a log of num_records samples of a 40 joint robot, 8 byte aligned
+static std::vector<std::uint64_t> buildLog(size_t num_records, size_t &size)
+{
+  urdf::ModelState state;
+  buildState(40, state);
+  std::ostringstream out;
+  {
+    urdf::StateLogWriter writer(out, urdf::StateLogSchema(state));
+    for (size_t r = 0; r < num_records; ++r)
+    {
+      sample(r, state);
+      writer.append(state);
+    }
+  }
+  const std::string bytes = out.str();
+  size = bytes.size();
+  std::vector<std::uint64_t> words((size + 7) / 8);
+  std::memcpy(words.data(), bytes.data(), size);
+  return words;
+}
+
+static void BM_StateLogAppend(benchmark::State &state)
+{
+  const size_t num_samples = 1024;
+  urdf::ModelState model_state;
+  buildState(static_cast<size_t>(state.range(0)), model_state);
+  const urdf::StateLogSchema schema(model_state);
+  std::vector<double> samples(num_samples * schema.getNumColumns());
+  for (size_t r = 0; r < num_samples; ++r)
+  {
+    sample(r, model_state);
+    schema.toRecord(model_state, samples.data() + r * schema.getNumColumns());
+  }
+  std::ostringstream out;
+  urdf::StateLogWriter writer(out, schema);
+
+  size_t r = 0;
+  urdf::Time stamp;
+  for (auto _ : state)
+  {
+    stamp.nsec = static_cast<int32_t>(r % 1000) * 1000000;
+    stamp.sec = static_cast<int32_t>(r / 1000);
+    writer.append(stamp, samples.data() + (r % num_samples) * schema.getNumColumns());
+    // keep the stream small without timing the reset on most iterations
+    if (++r % 65536 == 0)
+    {
+      out.str(std::string());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StateLogAppend)->Arg(40);
+
+/// The same records passed as ModelState
+static void BM_StateLogAppendModelState(benchmark::State &state)
+{
+  urdf::ModelState model_state;
+  buildState(static_cast<size_t>(state.range(0)), model_state);
+  sample(0, model_state);
+  std::ostringstream out;
+  urdf::StateLogWriter writer(out, urdf::StateLogSchema(model_state));
+
+  size_t r = 0;
+  for (auto _ : state)
+  {
+    model_state.time_stamp.nsec = static_cast<int32_t>(r % 1000) * 1000000;
+    model_state.time_stamp.sec = static_cast<int32_t>(r / 1000);
+    model_state.joint_states[r % model_state.joint_states.size()]->position[0] += 1e-3;
+    writer.append(model_state);
+    if (++r % 65536 == 0)
+    {
+      out.str(std::string());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StateLogAppendModelState)->Arg(40);
+
+/// Sequential decoding of a 10 minute log
+static void BM_StateLogRead(benchmark::State &state)
+{
+  const size_t num_records = 600000;
+  size_t size = 0;
+  const std::vector<std::uint64_t> log = buildLog(num_records, size);
+  urdf::StateLogReader reader;
+  reader.attach(log.data(), size);
+  std::vector<double> values(reader.getSchema().getNumColumns());
+  urdf::Time stamp;
+
+  size_t r = 0;
+  for (auto _ : state)
+  {
+    reader.read(r, stamp, values.data());
+    benchmark::DoNotOptimize(values.data());
+    if (++r == num_records) r = 0;
+  }
+  state.counters["bytes_per_record"] = static_cast<double>(size) / static_cast<double>(num_records);
+  state.counters["raw_bytes_per_record"] = static_cast<double>(8 * (1 + values.size()));
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StateLogRead);
+
+/// Random seeks by time stamp into a 10 minute log
+static void BM_StateLogSeek(benchmark::State &state)
+{
+  const size_t num_records = 600000;
+  size_t size = 0;
+  const std::vector<std::uint64_t> log = buildLog(num_records, size);
+  urdf::StateLogReader reader;
+  reader.attach(log.data(), size);
+
+  std::int64_t t = 0;
+  for (auto _ : state)
+  {
+    t = (t + 7919LL * 1000003) % (600LL * 1000000000);
+    benchmark::DoNotOptimize(reader.seek(t));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StateLogSeek);
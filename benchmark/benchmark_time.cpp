@@ -0,0 +1,122 @@
+/* Benchmarks for urdf::Time conversion and comparison */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <urdf_model_state/model_state.h>
+
+/// time stamps of a log sampled at 1 kHz with jitter, shuffled in blocks as merged logs arrive
+static std::vector<urdf::Time> buildTimes(size_t n)
+{
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int64_t> jitter(-20000, 20000);
+  std::vector<urdf::Time> times(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    times[i] = urdf::Time::fromNSec(INT64_C(1700000000000000000) + static_cast<int64_t>(i) * 1000000 + jitter(rng));
+  }
+  for (size_t i = 0; i + 64 <= n; i += 64)
+  {
+    std::shuffle(times.begin() + i, times.begin() + i + 64, rng);
+  }
+  return times;
+}
+
+/// Time::set() as it was, through floor() and round()
+static void BM_TimeSetLibm(benchmark::State &state)
+{
+  double seconds = 1700000000.123456;
+  urdf::Time time;
+  for (auto _ : state)
+  {
+    time.sec = static_cast<int32_t>(std::floor(seconds));
+    time.nsec = static_cast<int32_t>(std::round((seconds - time.sec) * 1e9));
+    if (time.nsec >= 1e9)
+    {
+      time.sec++;
+      time.nsec = static_cast<int32_t>(time.nsec - 1e9);
+    }
+    benchmark::DoNotOptimize(time);
+    seconds += 1e-3;
+  }
+}
+BENCHMARK(BM_TimeSetLibm);
+
+static void BM_TimeSet(benchmark::State &state)
+{
+  double seconds = 1700000000.123456;
+  urdf::Time time;
+  for (auto _ : state)
+  {
+    time.set(seconds);
+    benchmark::DoNotOptimize(time);
+    seconds += 1e-3;
+  }
+}
+BENCHMARK(BM_TimeSet);
+
+/// sorting by the conversion to double, the only ordering Time used to have
+static void BM_TimeSortDouble(benchmark::State &state)
+{
+  const std::vector<urdf::Time> times = buildTimes(static_cast<size_t>(state.range(0)));
+  std::vector<urdf::Time> sorted;
+  for (auto _ : state)
+  {
+    sorted = times;
+    std::sort(sorted.begin(), sorted.end(), [](const urdf::Time &a, const urdf::Time &b) {
+      return static_cast<double>(a) < static_cast<double>(b);
+    });
+    benchmark::DoNotOptimize(sorted.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TimeSortDouble)->Arg(1000000);
+
+static void BM_TimeSort(benchmark::State &state)
+{
+  const std::vector<urdf::Time> times = buildTimes(static_cast<size_t>(state.range(0)));
+  std::vector<urdf::Time> sorted;
+  for (auto _ : state)
+  {
+    sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+    benchmark::DoNotOptimize(sorted.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TimeSort)->Arg(1000000);
+
+/// batch conversion to nanoseconds followed by binary searches on the integers
+static void BM_TimeSearchNSec(benchmark::State &state)
+{
+  std::vector<urdf::Time> times = buildTimes(static_cast<size_t>(state.range(0)));
+  std::sort(times.begin(), times.end());
+  std::vector<int64_t> nsecs(times.size());
+  urdf::toNSec(times.data(), times.size(), nsecs.data());
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    const int64_t key = times[i].toNSec() + 1;
+    benchmark::DoNotOptimize(std::lower_bound(nsecs.begin(), nsecs.end(), key));
+    i = (i + 7919) % times.size();
+  }
+}
+BENCHMARK(BM_TimeSearchNSec)->Arg(1000000);
+
+static void BM_TimeToNSecBatch(benchmark::State &state)
+{
+  const std::vector<urdf::Time> times = buildTimes(static_cast<size_t>(state.range(0)));
+  std::vector<int64_t> nsecs(times.size());
+  for (auto _ : state)
+  {
+    urdf::toNSec(times.data(), times.size(), nsecs.data());
+    benchmark::DoNotOptimize(nsecs.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TimeToNSecBatch)->Arg(1000000);
@@ -0,0 +1,136 @@
+/* Benchmarks for Trajectory interpolation and resampling */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <urdf_model_state/trajectory.h>
+
+/// knots recorded at 100 Hz for ten seconds
+static const size_t NUM_KNOTS = 1000;
+
+/// a floating base followed by num_joints joints, every fourth CONTINUOUS and the rest REVOLUTE
+static urdf::StateLayout buildLayout(size_t num_joints)
+{
+  urdf::StateLayout layout;
+  layout.addJoint("base", urdf::Joint::FLOATING);
+  for (size_t k = 0; k < num_joints; ++k)
+  {
+    layout.addJoint("joint_" + std::to_string(k), k % 4 == 0 ? urdf::Joint::CONTINUOUS : urdf::Joint::REVOLUTE);
+  }
+  return layout;
+}
+
+static urdf::Trajectory buildTrajectory(const urdf::StateLayout &layout)
+{
+  urdf::Trajectory trajectory(layout);
+  trajectory.reserve(NUM_KNOTS);
+  urdf::PackedModelState state(layout);
+  for (size_t r = 0; r < NUM_KNOTS; ++r)
+  {
+    const double t = 1e-2 * static_cast<double>(r);
+    state.time_stamp = urdf::Time::fromNSec(static_cast<int64_t>(r) * 10000000);
+    double *q = state.positions();
+    q[0] = t;
+    q[5] = std::sin(0.25 * t);
+    q[6] = std::cos(0.25 * t);
+    for (size_t i = 7; i < layout.getNumPositions(); ++i)
+    {
+      q[i] = std::sin((1.0 + 0.1 * static_cast<double>(i)) * t);
+      state.velocities()[i - 1] = (1.0 + 0.1 * static_cast<double>(i)) * std::cos((1.0 + 0.1 * static_cast<double>(i)) * t);
+    }
+    trajectory.append(state.view());
+  }
+  return trajectory;
+}
+
+/// stamps in the middle of knot intervals, spread over the whole trajectory
+static urdf::Time sampleTime(size_t i)
+{
+  return urdf::Time::fromNSec(static_cast<int64_t>((i * 7919) % (NUM_KNOTS - 1)) * 10000000 + 3333333);
+}
+
+/// the same lookup on a vector of ModelStates, searching by double and interpolating joint by joint
+static void BM_ModelStateInterpolate(benchmark::State &state)
+{
+  const urdf::StateLayout layout = buildLayout(static_cast<size_t>(state.range(0)));
+  const urdf::Trajectory trajectory = buildTrajectory(layout);
+  std::vector<urdf::ModelState> states(NUM_KNOTS);
+  for (size_t r = 0; r < NUM_KNOTS; ++r)
+  {
+    trajectory[r].toModelState(states[r]);
+  }
+  urdf::ModelState out;
+  trajectory[0].toModelState(out);
+
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    const urdf::Time stamp = sampleTime(i++);
+    const double t = stamp;
+    const size_t b = std::lower_bound(states.begin(), states.end(), t,
+                                      [](const urdf::ModelState &s, double value) { return s.time_stamp < value; }) -
+                     states.begin();
+    const urdf::ModelState &first = states[b - 1], &second = states[b];
+    const double s = (t - first.time_stamp) / (second.time_stamp - first.time_stamp);
+    out.time_stamp = stamp;
+    for (size_t j = 0; j < out.joint_states.size(); ++j)
+    {
+      const urdf::JointState &p = *first.joint_states[j], &n = *second.joint_states[j];
+      urdf::JointState &o = *out.joint_states[j];
+      for (size_t c = 0; c < o.position.size(); ++c)
+      {
+        o.position[c] = p.position[c] + s * (n.position[c] - p.position[c]);
+      }
+      for (size_t c = 0; c < o.velocity.size(); ++c)
+      {
+        o.velocity[c] = p.velocity[c] + s * (n.velocity[c] - p.velocity[c]);
+        o.effort[c] = p.effort[c] + s * (n.effort[c] - p.effort[c]);
+      }
+    }
+    benchmark::DoNotOptimize(out.joint_states.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ModelStateInterpolate)->Arg(40)->Arg(200);
+
+static void BM_TrajectorySample(benchmark::State &state)
+{
+  const urdf::StateLayout layout = buildLayout(static_cast<size_t>(state.range(0)));
+  const urdf::Trajectory trajectory = buildTrajectory(layout);
+  const urdf::Trajectory::Interpolation interpolation = static_cast<urdf::Trajectory::Interpolation>(state.range(1));
+  urdf::PackedModelState out(layout);
+
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    trajectory.sample(sampleTime(i++), out.view(), interpolation);
+    benchmark::DoNotOptimize(out.positions());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TrajectorySample)
+  ->ArgsProduct({{40, 200}, {urdf::Trajectory::LINEAR, urdf::Trajectory::CUBIC_HERMITE}});
+
+/// the 100 Hz recording replayed at 1 kHz
+static void BM_TrajectoryResample(benchmark::State &state)
+{
+  const urdf::StateLayout layout = buildLayout(static_cast<size_t>(state.range(0)));
+  const urdf::Trajectory trajectory = buildTrajectory(layout);
+  const urdf::Trajectory::Interpolation interpolation = static_cast<urdf::Trajectory::Interpolation>(state.range(1));
+  const size_t num_samples = 10 * NUM_KNOTS;
+  urdf::Trajectory out;
+
+  for (auto _ : state)
+  {
+    trajectory.resample(urdf::Time(), urdf::Time(0, 1000000), num_samples, out, interpolation);
+    benchmark::DoNotOptimize(out[num_samples - 1].data());
+  }
+  state.SetItemsProcessed(state.iterations() * num_samples);
+}
+BENCHMARK(BM_TrajectoryResample)
+  ->ArgsProduct({{40, 200}, {urdf::Trajectory::LINEAR, urdf::Trajectory::CUBIC_HERMITE}});
@@ -0,0 +1,229 @@
+/* The recursive, string keyed initTree() of urdfdom_headers 1.1, kept as a
+   baseline for BM_InitTree */
+
+#ifndef URDF_BENCHMARK_LEGACY_INIT_TREE_H
+#define URDF_BENCHMARK_LEGACY_INIT_TREE_H
+
+#include <algorithm>
+#include <map>
+#include <stack>
+#include <string>
+#include <vector>
+
+#include <urdf_model/model.h>
+
+namespace urdf_benchmark {
+
+inline void legacyDfsFirstPass(urdf::ModelInterface &model, const std::string &link_name,
+                  std::map<std::string, bool> &visited,
+                  std::stack<std::string> &finishing_order)
+{
+  visited[link_name] = true;
+  for (urdf::LinkSharedPtr &child : model.links_[link_name]->child_links)
+  {
+    if (visited[child->name]) { continue; }
+    legacyDfsFirstPass(model, child->name, visited, finishing_order);
+  }
+  for (urdf::LinkSharedPtr &loop_link : model.links_[link_name]->loop_links)
+  {
+    if (visited[loop_link->name]) { continue; }
+    legacyDfsFirstPass(model, loop_link->name, visited, finishing_order);
+  }
+  finishing_order.push(link_name);
+}
+
+inline void legacyDfsSecondPass(urdf::ModelInterface &model, const std::map<std::string, std::vector<urdf::LinkSharedPtr>> &reverse_graph,
+                const std::string &link_name, std::map<std::string, bool> &visited,
+                std::vector<urdf::LinkSharedPtr> &scc)
+{
+  visited[link_name] = true;
+  scc.push_back(model.links_[link_name]);
+  for (const urdf::LinkSharedPtr &reverse_child : reverse_graph.at(link_name))
+  {
+    if (visited[reverse_child->name]) { continue; }
+    legacyDfsSecondPass(model, reverse_graph, reverse_child->name, visited, scc);
+  }
+}
+
+inline void legacyInitTree(urdf::ModelInterface &model, std::map<std::string, std::string> &parent_link_tree)
+{
+  // loop through all joints, for every link, assign children links and children joints
+  for (std::map<std::string, urdf::JointSharedPtr>::iterator joint = model.joints_.begin();joint != model.joints_.end(); joint++)
+  {
+    std::string parent_link_name = joint->second->parent_link_name;
+    std::string child_link_name = joint->second->child_link_name;
+    
+    if (parent_link_name.empty() || child_link_name.empty())
+    {
+      throw urdf::ParseError("Joint [" + joint->second->name + "] is missing a parent and/or child link specification.");
+    }
+    else
+    {
+      // find child and parent links
+      urdf::LinkSharedPtr child_link, parent_link;
+      model.getLink(child_link_name, child_link);
+      if (!child_link)
+      {
+        throw urdf::ParseError("child link [" + child_link_name + "] of joint [" + joint->first + "] not found");
+      }
+      model.getLink(parent_link_name, parent_link);
+      if (!parent_link)
+      {
+        throw urdf::ParseError("parent link [" + parent_link_name + "] of joint [" + joint->first + "] not found.  This is not valid according to the URDF spec. Every link you refer to from a joint needs to be explicitly defined in the robot description. To fix this problem you can either remove this joint [" + joint->first + "] from your urdf file, or add \"<link name=\"" + parent_link_name + "\" />\" to your urdf file.");
+      }
+      
+      //set parent link for child link
+      child_link->setParent(parent_link);
+
+      //set parent joint for child link        
+      child_link->parent_joint = joint->second;
+      
+      //set child joint for parent link
+      parent_link->child_joints.push_back(joint->second);
+
+      //set child link for parent link
+      parent_link->child_links.push_back(child_link);
+
+      // fill in child/parent string map
+      parent_link_tree[child_link->name] = parent_link_name;
+    }
+  }
+
+  // loop through all constraints, for every link, assign loop links and ancestors
+  auto getSubchain = [](urdf::LinkSharedPtr link) -> std::vector<urdf::LinkSharedPtr>
+  {
+    std::vector<urdf::LinkSharedPtr> subchain;
+    while (link)
+    {
+      subchain.push_back(link);
+      link = link->getParent();
+    }
+    std::reverse(subchain.begin(), subchain.end());
+    return subchain;
+  };
+
+  for (std::map<std::string, urdf::ConstraintSharedPtr>::iterator constraint = model.constraints_.begin();constraint != model.constraints_.end(); constraint++)
+  {
+    std::string predecessor_link_name = constraint->second->successor_link_name;
+    std::string successor_link_name = constraint->second->predecessor_link_name;
+    
+    if (predecessor_link_name.empty() || successor_link_name.empty())
+    {
+      throw urdf::ParseError("Constraint [" + constraint->second->name + "] is missing a predecessor and/or successor link specification.");
+    }
+    else
+    {
+      // find successor and predecessor links
+      urdf::LinkSharedPtr successor_link, predecessor_link;
+      model.getLink(successor_link_name, successor_link);
+      if (!successor_link)
+      {
+        throw urdf::ParseError("successor link [" + successor_link_name + "] of constraint [" + constraint->first + "] not found");
+      }
+      model.getLink(predecessor_link_name, predecessor_link);
+      if (!predecessor_link)
+      {
+        throw urdf::ParseError("predecessor link [" + predecessor_link_name + "] of constraint [" + constraint->first + "] not found.  This is not valid according to the URDF spec. Every link you refer to from a constraint needs to be explicitly defined in the robot description. To fix this problem you can either remove this constraint [" + constraint->first + "] from your urdf file, or add \"<link name=\"" + predecessor_link_name + "\" />\" to your urdf file.");
+      }
+
+      // set constraint for predecessor link
+      predecessor_link->constraints.push_back(constraint->second);
+
+      // set loop links
+      std::vector<urdf::LinkSharedPtr> predecessor_subchain = getSubchain(predecessor_link);
+      std::vector<urdf::LinkSharedPtr> successor_subchain = getSubchain(successor_link);
+
+      urdf::LinkSharedPtr ancestor;
+      std::vector<urdf::LinkSharedPtr>::iterator predecessor_it = predecessor_subchain.begin();
+      std::vector<urdf::LinkSharedPtr>::iterator successor_it = successor_subchain.begin();
+      while (predecessor_it != predecessor_subchain.end() &&
+             successor_it != successor_subchain.end() &&
+             *predecessor_it == *successor_it)
+      {
+        ancestor = *predecessor_it;
+        predecessor_it++;
+        successor_it++;
+      }
+      constraint->second->nearest_common_ancestor_name = ancestor->name;
+      predecessor_link->loop_links.push_back(*successor_it);
+      successor_link->loop_links.push_back(*predecessor_it);
+
+    }
+  }
+
+  // Extract strongly connected components
+  {
+    std::map<std::string, bool> visited;
+    std::stack<std::string> finishing_order;
+
+    // Build the reverse graph
+    std::map<std::string, std::vector<urdf::LinkSharedPtr>> reverse_link_graph;
+    for (std::map<std::string, urdf::LinkSharedPtr>::iterator link = model.links_.begin(); link != model.links_.end(); link++)
+    {
+      reverse_link_graph[link->second->name] = std::vector<urdf::LinkSharedPtr>();
+    }
+    for (std::map<std::string, urdf::LinkSharedPtr>::iterator link = model.links_.begin(); link != model.links_.end(); link++)
+    {
+      for (urdf::LinkSharedPtr &child : link->second->child_links)
+      {
+        reverse_link_graph[child->name].push_back(link->second);
+      }
+      for (urdf::LinkSharedPtr &loop_link : link->second->loop_links)
+      {
+        reverse_link_graph[loop_link->name].push_back(link->second);
+      }
+    }
+
+    // First Pass: Calculate finishing times
+    for (std::map<std::string, urdf::LinkSharedPtr>::iterator link = model.links_.begin(); link != model.links_.end(); link++)
+    {
+      if (visited[link->first]) { continue; }
+      legacyDfsFirstPass(model, link->first, visited, finishing_order);
+    }
+    visited.clear();
+
+    // Second Pass: Find strongly connected components
+    while (!finishing_order.empty())
+    {
+      std::string link_name = finishing_order.top();
+      finishing_order.pop();
+
+      if (visited[link_name]) { continue; }
+
+      std::vector<urdf::LinkSharedPtr> scc;
+      legacyDfsSecondPass(model, reverse_link_graph, link_name, visited, scc);
+
+      // Create a new cluster
+      urdf::ClusterSharedPtr cluster;
+      cluster.reset(new urdf::Cluster());
+
+      size_t cluster_id = model.clusters_.size();
+      model.clusters_.insert(std::make_pair(cluster_id, cluster));
+
+      for (urdf::LinkSharedPtr &link : scc)
+      {
+        cluster->push_back(link);
+        model.containing_cluster_.insert(std::make_pair(link->name, cluster_id));
+      }
+    }
+
+    // Set parent and child clusters
+    for (std::map<int, urdf::ClusterSharedPtr>::iterator cluster = model.clusters_.begin(); cluster != model.clusters_.end(); cluster++)
+    {
+      for (urdf::LinkSharedPtr &link : *cluster->second)
+      {
+        urdf::LinkSharedPtr parent_link = link->getParent();
+        if (!parent_link) { continue; }
+        int parent_cluster_id = model.containing_cluster_[parent_link->name];
+        if (parent_cluster_id == cluster->first) { continue; }
+        cluster->second->setParent(model.clusters_[parent_cluster_id]);
+        model.clusters_[parent_cluster_id]->child_clusters.push_back(cluster->second);
+        break;
+      }
+    }
+  }
+}
+
+}
+
+#endif
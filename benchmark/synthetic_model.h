@@ -0,0 +1,90 @@
+/* Synthetic models used by the benchmarks */
+
+#ifndef URDF_BENCHMARK_SYNTHETIC_MODEL_H
+#define URDF_BENCHMARK_SYNTHETIC_MODEL_H
+
+#include <map>
+#include <string>
+
+#include <urdf_model/model.h>
+
+namespace urdf_benchmark {
+
+enum ModelShape
+{
+  /// every link is the child of the previous one
+  CHAIN,
+  /// complete tree with a branching factor of 8
+  WIDE_TREE,
+  /// binary tree where every pair of siblings is closed by a LoopConstraint
+  LOOPS
+};
+
+inline std::string linkName(size_t i) { return "link_" + std::to_string(i); }
+inline std::string jointName(size_t i) { return "joint_" + std::to_string(i); }
+
+/// Fill links_, joints_ and constraints_ of model without building the tree,
+/// every fixed_every-th joint is FIXED (none if 0)
+inline void buildRawModel(ModelShape shape, size_t num_links, urdf::ModelInterface &model, size_t fixed_every = 0)
+{
+  model.clear();
+  model.name_ = "synthetic";
+
+  for (size_t i = 0; i < num_links; ++i)
+  {
+    urdf::LinkSharedPtr link(new urdf::Link());
+    link->name = linkName(i);
+    link->inertial.reset(new urdf::Inertial());
+    link->inertial->mass = 1.0;
+    link->inertial->ixx = link->inertial->iyy = link->inertial->izz = 0.01;
+    model.links_[link->name] = link;
+  }
+
+  for (size_t i = 1; i < num_links; ++i)
+  {
+    size_t parent = 0;
+    switch (shape)
+    {
+      case CHAIN: parent = i - 1; break;
+      case WIDE_TREE: parent = (i - 1) / 8; break;
+      case LOOPS: parent = (i - 1) / 2; break;
+    }
+
+    urdf::JointSharedPtr joint(new urdf::Joint());
+    joint->name = jointName(i);
+    joint->type = fixed_every > 0 && i % fixed_every == 0 ? urdf::Joint::FIXED : urdf::Joint::REVOLUTE;
+    joint->axis = urdf::Vector3(0, 0, 1);
+    joint->parent_to_joint_origin_transform.position = urdf::Vector3(0.1, 0, 0);
+    joint->parent_link_name = linkName(parent);
+    joint->child_link_name = linkName(i);
+    joint->independent = true;
+    model.joints_[joint->name] = joint;
+  }
+
+  if (shape == LOOPS)
+  {
+    for (size_t i = 1; i + 1 < num_links; i += 2)
+    {
+      urdf::LoopConstraintSharedPtr constraint(new urdf::LoopConstraint());
+      constraint->name = "loop_" + std::to_string(i);
+      constraint->type = urdf::LoopConstraint::REVOLUTE;
+      constraint->axis = urdf::Vector3(0, 0, 1);
+      constraint->predecessor_link_name = linkName(i);
+      constraint->successor_link_name = linkName(i + 1);
+      model.constraints_[constraint->name] = constraint;
+    }
+  }
+}
+
+/// Build a fully initialized model
+inline void buildModel(ModelShape shape, size_t num_links, urdf::ModelInterface &model, size_t fixed_every = 0)
+{
+  buildRawModel(shape, num_links, model, fixed_every);
+  std::map<std::string, std::string> parent_link_tree;
+  model.initTree(parent_link_tree);
+  model.initRoot(parent_link_tree);
+}
+
+}
+
+#endif
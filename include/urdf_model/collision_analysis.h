@@ -0,0 +1,351 @@
+/* Sampled self collision statistics and the allowed collision matrix they imply */
+
+#ifndef URDF_INTERFACE_COLLISION_ANALYSIS_H
+#define URDF_INTERFACE_COLLISION_ANALYSIS_H
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <urdf_model/collision_bvh.h>
+#include <urdf_model/collision_matrix.h>
+#include <urdf_model/compiled_model.h>
+#include <urdf_model/coordinate_map.h>
+#include <urdf_model/forward_kinematics.h>
+#include <urdf_model/joint.h>
+#include <urdf_model/thread_pool.h>
+
+namespace urdf{
+
+/// \brief Self collision statistics of a model over random configurations
+///
+/// sample() draws joint configurations uniformly from the JointLimits of
+/// the independent joints (see CoordinateMap), CONTINUOUS angles and
+/// unlimited revolute ones from [-pi, pi], unlimited translations from
+/// [-translation_range, translation_range] and FLOATING orientations
+/// uniformly from all rotations.  Mimic and coupled joints follow their
+/// sources; loop constraints are not enforced, which is why pairs within
+/// a Cluster are never sampled.  Every configuration is checked with a
+/// CollisionBvh and narrow_phase, and each link pair counts at most one
+/// contact per configuration.
+///
+/// Sample k of a seed is drawn from its own random stream, and the counts
+/// are sums, so the statistics do not depend on the number of threads.
+/// Repeated sample() calls continue the sample numbering and accumulate.
+///
+/// getReason() classifies every pair, computeMatrix() allows the pairs that
+/// need no check.  The analysis is meant to run offline, the matrix is then
+/// stored with AllowedCollisionMatrix::write().
+class SelfCollisionAnalysis
+{
+public:
+  /// why a pair of links need not be checked, CHECKED if it must be
+  enum Reason
+  {
+    CHECKED,
+    ADJACENT,
+    SAME_CLUSTER,
+    NEVER,
+    ALWAYS
+  };
+
+  /// \brief true if elements a and b of bvh collide for the given link poses
+  ///
+  /// Called from all pool threads at once, with a different bvh per thread.
+  typedef std::function<bool(const CollisionBvh &bvh, int a, int b, const Pose *link_poses)> NarrowPhase;
+
+  SelfCollisionAnalysis() { this->clear(); };
+  explicit SelfCollisionAnalysis(const CompiledModel &model,
+                                 const CollisionBvh::MeshBounds &mesh_bounds = CollisionBvh::MeshBounds())
+  {
+    this->init(model, mesh_bounds);
+  };
+
+  std::size_t getNumLinks() const { return this->matrix_.getNumLinks(); };
+  std::size_t getNumSamples() const { return this->num_samples_; };
+
+  void init(const CompiledModel &model, const CollisionBvh::MeshBounds &mesh_bounds = CollisionBvh::MeshBounds())
+  {
+    this->clear();
+    this->kinematics_.init(model);
+    this->coordinates_.init(model);
+    this->bvh_.init(model, mesh_bounds);
+    this->matrix_.init(model);
+    this->link_cluster_ = model.link_cluster;
+    this->contacts_.assign(this->matrix_.getNumPairs(), 0);
+    for (std::size_t j = 0; j < model.getNumJoints(); ++j)
+    {
+      if (model.joint_nq[j] == 0 || this->coordinates_.getJointSource(static_cast<int>(j)) >= 0)
+      {
+        continue;
+      }
+      JointRange range;
+      range.type = model.joint_type[j];
+      range.q_offset = model.joint_q_offset[j];
+      const JointLimits *limits = model.source_joints[j]->limits.get();
+      range.limited = (range.type == Joint::REVOLUTE || range.type == Joint::PRISMATIC) && limits &&
+                      limits->lower <= limits->upper;
+      range.lower = range.limited ? limits->lower : 0.0;
+      range.upper = range.limited ? limits->upper : 0.0;
+      this->ranges_.push_back(range);
+    }
+  };
+
+  /// \brief check num_samples more configurations, drawn from seed
+  void sample(ThreadPool &pool, std::size_t num_samples, std::uint64_t seed)
+  {
+    const std::size_t num_pairs = this->contacts_.size();
+    for (std::size_t t = this->workers_.size(); t < pool.getNumThreads(); ++t)
+    {
+      this->workers_.emplace_back();
+      Worker &worker = this->workers_.back();
+      worker.bvh = this->bvh_;
+      worker.q.resize(this->kinematics_.getNumPositions());
+      worker.reduced.resize(this->coordinates_.getNumReducedPositions());
+      worker.poses.resize(this->kinematics_.getNumLinks());
+      worker.contacts.assign(num_pairs, 0);
+      worker.last_contact.assign(num_pairs, 0);
+    }
+    for (Worker &worker : this->workers_)
+    {
+      worker.bvh.margin = this->margin;
+    }
+    const std::size_t first = this->num_samples_;
+    pool.parallelFor(num_samples, this->grain_size, [this, first, seed](std::size_t thread, std::size_t begin,
+                                                                      std::size_t end)
+    {
+      for (std::size_t s = begin; s < end; ++s)
+      {
+        this->checkSample(this->workers_[thread], first + s, seed);
+      }
+    });
+    for (std::size_t t = 0; t < pool.getNumThreads(); ++t)
+    {
+      std::vector<std::size_t> &contacts = this->workers_[t].contacts;
+      for (std::size_t k = 0; k < num_pairs; ++k)
+      {
+        this->contacts_[k] += contacts[k];
+        contacts[k] = 0;
+      }
+    }
+    this->num_samples_ += num_samples;
+  };
+
+  /// number of sampled configurations in which links a != b collide
+  std::size_t getContactCount(int a, int b) const
+  {
+    return this->contacts_[AllowedCollisionMatrix::pairIndex(this->getNumLinks(), a, b)];
+  };
+
+  /// \brief classify the pair of links a != b
+  ///
+  /// NEVER and ALWAYS need at least one sample; a pair is ALWAYS in contact
+  /// when it collides in at least always_fraction of the samples.
+  Reason getReason(int a, int b) const
+  {
+    if (this->bvh_.isExcludedLinkPair(a, b))
+    {
+      return this->link_cluster_[a] >= 0 && this->link_cluster_[a] == this->link_cluster_[b] ? SAME_CLUSTER : ADJACENT;
+    }
+    if (this->num_samples_ == 0)
+    {
+      return CHECKED;
+    }
+    const std::size_t contacts = this->getContactCount(a, b);
+    if (contacts == 0)
+    {
+      return NEVER;
+    }
+    if (static_cast<double>(contacts) >= this->always_fraction * static_cast<double>(this->num_samples_))
+    {
+      return ALWAYS;
+    }
+    return CHECKED;
+  };
+
+  /// allow every pair whose reason is not CHECKED
+  void computeMatrix(AllowedCollisionMatrix &matrix) const
+  {
+    matrix = this->matrix_;
+    const int num_links = static_cast<int>(this->getNumLinks());
+    for (int a = 0; a < num_links; ++a)
+    {
+      for (int b = a + 1; b < num_links; ++b)
+      {
+        if (this->getReason(a, b) != CHECKED)
+        {
+          matrix.setAllowed(a, b, true);
+        }
+      }
+    }
+  };
+
+  void clear()
+  {
+    this->kinematics_.clear();
+    this->coordinates_.clear();
+    this->bvh_.clear();
+    this->matrix_.clear();
+    this->link_cluster_.clear();
+    this->ranges_.clear();
+    this->contacts_.clear();
+    this->workers_.clear();
+    this->num_samples_ = 0;
+    this->narrow_phase = NarrowPhase();
+    this->margin = 0.0;
+    this->translation_range = 1.0;
+    this->always_fraction = 1.0;
+    this->grain_size = 16;
+  };
+
+  /// \brief exact test of two elements, empty to test their bounding boxes
+  ///
+  /// The default treats every element as the oriented box CollisionBvh
+  /// bounds it with.  That is exact for boxes but overcounts contacts of
+  /// other shapes, which may turn pairs that only nearly touch into ALWAYS
+  /// pairs; set a mesh or primitive distance test for exact results.
+  NarrowPhase narrow_phase;
+  /// CollisionBvh::margin of the broad phase, pairs closer than twice this are passed to narrow_phase
+  double margin;
+  /// half width of the range unlimited translations are drawn from
+  double translation_range;
+  /// fraction of samples in which a pair must collide to be ALWAYS in contact
+  double always_fraction;
+  /// configurations a thread takes from its range at a time
+  std::size_t grain_size;
+
+private:
+  struct JointRange
+  {
+    int type;
+    int q_offset;
+    bool limited;
+    double lower;
+    double upper;
+  };
+
+  struct Worker
+  {
+    CollisionBvh bvh;
+    std::vector<double> q;
+    std::vector<double> reduced;
+    std::vector<Pose> poses;
+    std::vector<CollisionBvh::Pair> pairs;
+    std::vector<std::size_t> contacts;
+    /// 1 + the last sample a pair collided in, so it is counted once
+    std::vector<std::size_t> last_contact;
+  };
+
+  /// splitmix64, a stream per sample that is independent of the threads
+  static std::uint64_t nextRandom(std::uint64_t &state)
+  {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  };
+
+  /// uniform in [0, 1)
+  static double nextUniform(std::uint64_t &state) { return static_cast<double>(nextRandom(state) >> 11) * 0x1.0p-53; };
+
+  void drawConfiguration(std::uint64_t state, double *q) const
+  {
+    const double pi = 3.14159265358979323846;
+    const double range = this->translation_range;
+    auto uniform = [&state](double lower, double upper) { return lower + (upper - lower) * nextUniform(state); };
+    for (const JointRange &joint : this->ranges_)
+    {
+      double *x = q + joint.q_offset;
+      switch (joint.type)
+      {
+        case Joint::REVOLUTE:
+          x[0] = joint.limited ? uniform(joint.lower, joint.upper) : uniform(-pi, pi);
+          break;
+        case Joint::CONTINUOUS:
+          x[0] = uniform(-pi, pi);
+          break;
+        case Joint::PRISMATIC:
+          x[0] = joint.limited ? uniform(joint.lower, joint.upper) : uniform(-range, range);
+          break;
+        case Joint::PLANAR:
+          x[0] = uniform(-range, range);
+          x[1] = uniform(-range, range);
+          x[2] = uniform(-pi, pi);
+          break;
+        case Joint::FLOATING:
+        {
+          x[0] = uniform(-range, range);
+          x[1] = uniform(-range, range);
+          x[2] = uniform(-range, range);
+          // uniform unit quaternion (Shoemake)
+          const double u1 = nextUniform(state), u2 = uniform(0.0, 2.0 * pi), u3 = uniform(0.0, 2.0 * pi);
+          const double s1 = std::sqrt(1.0 - u1), s2 = std::sqrt(u1);
+          x[3] = s1 * std::sin(u2);
+          x[4] = s1 * std::cos(u2);
+          x[5] = s2 * std::sin(u3);
+          x[6] = s2 * std::cos(u3);
+          break;
+        }
+      }
+    }
+  };
+
+  void checkSample(Worker &worker, std::size_t sample, std::uint64_t seed) const
+  {
+    std::uint64_t state = seed ^ (0x9e3779b97f4a7c15ull * (sample + 1));
+    nextRandom(state);
+    this->drawConfiguration(state, worker.q.data());
+    this->coordinates_.reducePositions(worker.q.data(), worker.reduced.data());
+    this->coordinates_.expandPositions(worker.reduced.data(), worker.q.data());
+    this->kinematics_.compute(worker.q.data(), worker.poses.data());
+    worker.bvh.build(worker.poses.data());
+    worker.bvh.computeSelfCollisionPairs(worker.pairs);
+
+    const std::size_t num_links = this->getNumLinks();
+    for (const CollisionBvh::Pair &pair : worker.pairs)
+    {
+      const int link_a = worker.bvh.getElementLink(pair.first);
+      const int link_b = worker.bvh.getElementLink(pair.second);
+      const std::size_t k = AllowedCollisionMatrix::pairIndex(num_links, link_a, link_b);
+      if (worker.last_contact[k] == sample + 1)
+      {
+        continue;
+      }
+      const bool contact = this->narrow_phase
+                             ? this->narrow_phase(worker.bvh, pair.first, pair.second, worker.poses.data())
+                             : boxesCollide(worker.bvh, pair.first, pair.second, worker.poses.data());
+      if (contact)
+      {
+        worker.last_contact[k] = sample + 1;
+        ++worker.contacts[k];
+      }
+    }
+  };
+
+  static bool boxesCollide(const CollisionBvh &bvh, int a, int b, const Pose *link_poses)
+  {
+    if (!bvh.isElementBounded(a) || !bvh.isElementBounded(b))
+    {
+      return true;
+    }
+    return orientedBoxesOverlap(link_poses[bvh.getElementLink(a)] * bvh.getElementOffset(a), bvh.getElementHalfExtent(a),
+                                link_poses[bvh.getElementLink(b)] * bvh.getElementOffset(b), bvh.getElementHalfExtent(b));
+  };
+
+  ForwardKinematics kinematics_;
+  CoordinateMap coordinates_;
+  /// copied into every worker
+  CollisionBvh bvh_;
+  /// names the links, no pair allowed
+  AllowedCollisionMatrix matrix_;
+  std::vector<int> link_cluster_;
+  std::vector<JointRange> ranges_;
+  std::vector<std::size_t> contacts_;
+  std::size_t num_samples_;
+  std::vector<Worker> workers_;
+};
+
+}
+
+#endif
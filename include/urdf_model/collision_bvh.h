@@ -0,0 +1,481 @@
+/* Bounding volume hierarchy over the collision geometry of a CompiledModel */
+
+#ifndef URDF_INTERFACE_COLLISION_BVH_H
+#define URDF_INTERFACE_COLLISION_BVH_H
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <urdf_model/collision_matrix.h>
+#include <urdf_model/compiled_model.h>
+#include <urdf_model/geometry_table.h>
+#include <urdf_model/pose.h>
+#include <urdf_model/spatial.h>
+
+namespace urdf{
+
+/// axis aligned box, empty when a lower bound exceeds an upper one
+struct BoundingBox
+{
+  Vector3 lower;
+  Vector3 upper;
+
+  bool overlaps(const BoundingBox &box) const
+  {
+    return this->lower.x <= box.upper.x && box.lower.x <= this->upper.x &&
+           this->lower.y <= box.upper.y && box.lower.y <= this->upper.y &&
+           this->lower.z <= box.upper.z && box.lower.z <= this->upper.z;
+  };
+};
+
+/// \brief true if two oriented boxes, given by their poses and half extents, overlap
+///
+/// Separating axis test over the 3 + 3 face normals and 9 edge pairs.
+inline bool orientedBoxesOverlap(const Pose &pose_a, const Vector3 &half_a, const Pose &pose_b, const Vector3 &half_b)
+{
+  double a[9], b[9];
+  spatial::rotationMatrix(pose_a.rotation, a);
+  spatial::rotationMatrix(pose_b.rotation, b);
+  const double ha[3] = {half_a.x, half_a.y, half_a.z};
+  const double hb[3] = {half_b.x, half_b.y, half_b.z};
+  // r = A^T B and t = A^T (p_b - p_a), b in the axes of a; the epsilon
+  // keeps near parallel edge pairs from producing spurious separations
+  const Vector3 d = pose_b.position - pose_a.position;
+  const double epsilon = 1e-12;
+  double r[3][3], abs_r[3][3], t[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    t[i] = a[i] * d.x + a[3 + i] * d.y + a[6 + i] * d.z;
+    for (int j = 0; j < 3; ++j)
+    {
+      r[i][j] = a[i] * b[j] + a[3 + i] * b[3 + j] + a[6 + i] * b[6 + j];
+      abs_r[i][j] = std::fabs(r[i][j]) + epsilon;
+    }
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    if (std::fabs(t[i]) > ha[i] + hb[0] * abs_r[i][0] + hb[1] * abs_r[i][1] + hb[2] * abs_r[i][2])
+    {
+      return false;
+    }
+  }
+  for (int j = 0; j < 3; ++j)
+  {
+    if (std::fabs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) >
+        ha[0] * abs_r[0][j] + ha[1] * abs_r[1][j] + ha[2] * abs_r[2][j] + hb[j])
+    {
+      return false;
+    }
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+    for (int j = 0; j < 3; ++j)
+    {
+      const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+      if (std::fabs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) >
+          ha[i1] * abs_r[i2][j] + ha[i2] * abs_r[i1][j] + hb[j1] * abs_r[i][j2] + hb[j2] * abs_r[i][j1])
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/// \brief Axis aligned bounding box tree over the collision elements of a model
+///
+/// init() packs the collision geometry into a GeometryTable, whose entries
+/// are the elements of the tree.  Each is bounded by a box in the frame of
+/// its geometry: the radius for a sphere, dim / 2 for a box and (radius,
+/// radius, length / 2) for a cylinder along z.  The headers do not load
+/// meshes, so a mesh is bounded by the box mesh_bounds returns for its
+/// file, scaled by the mesh scale; without mesh_bounds, or when it returns
+/// false, the element is unbounded and overlaps everything.
+///
+/// build() computes the world box of every element from the link poses and
+/// splits the elements at the median of their centers along the longest
+/// axis, down to one element per leaf.  refit() keeps that topology and
+/// only recomputes the boxes bottom up, which is linear in the number of
+/// elements; call build() again when the configuration has moved so far that
+/// queries slow down.  Nodes are stored in preorder, so the left child of an
+/// internal node directly follows it.
+///
+/// computeSelfCollisionPairs() traverses the tree against itself and skips
+/// pairs on the same link, on a parent and child link and on two links of
+/// the same Cluster, see isExcludedLinkPair(), as well as the pairs an
+/// AllowedCollisionMatrix allows.  Queries reuse an internal stack, so they
+/// do not allocate once it has grown and a CollisionBvh must not run two
+/// queries at once.
+class CollisionBvh
+{
+public:
+  /// two element indices, first < second
+  struct Pair
+  {
+    int first;
+    int second;
+  };
+
+  /// bounds of a mesh file in its own coordinates, before the mesh scale
+  typedef std::function<bool(std::string_view filename, Vector3 &lower, Vector3 &upper)> MeshBounds;
+
+  CollisionBvh() { this->clear(); };
+  explicit CollisionBvh(const CompiledModel &model, const MeshBounds &mesh_bounds = MeshBounds())
+  {
+    this->init(model, mesh_bounds);
+  };
+
+  std::size_t getNumElements() const { return this->elements_.size(); };
+  std::size_t getNumNodes() const { return this->nodes_.size(); };
+
+  void init(const CompiledModel &model, const MeshBounds &mesh_bounds = MeshBounds())
+  {
+    this->clear();
+    this->link_parent_ = model.link_parent;
+    this->link_cluster_ = model.link_cluster;
+    this->geometry_.init(model, GeometryTable::COLLISION);
+    const GeometryTable &table = this->geometry_;
+    this->elements_.resize(table.size());
+    for (std::size_t e = 0; e < table.size(); ++e)
+    {
+      this->elements_[e].link = table.entry_link[e];
+      this->elements_[e].offset = table.entry_origin[e];
+      this->elements_[e].bounded = true;
+    }
+    // one loop per type over its contiguous parameters
+    Element *spheres = this->elements_.data() + table.typeBegin(Geometry::SPHERE);
+    for (std::size_t k = 0; k < table.sphere_radius.size(); ++k)
+    {
+      const double r = table.sphere_radius[k];
+      spheres[k].half_extent = Vector3(r, r, r);
+    }
+    Element *boxes = this->elements_.data() + table.typeBegin(Geometry::BOX);
+    for (std::size_t k = 0; k < table.box_dim.size(); ++k)
+    {
+      boxes[k].half_extent = table.box_dim[k] * 0.5;
+    }
+    Element *cylinders = this->elements_.data() + table.typeBegin(Geometry::CYLINDER);
+    for (std::size_t k = 0; k < table.cylinder_radius.size(); ++k)
+    {
+      const double r = table.cylinder_radius[k];
+      cylinders[k].half_extent = Vector3(r, r, 0.5 * table.cylinder_length[k]);
+    }
+    Element *meshes = this->elements_.data() + table.typeBegin(Geometry::MESH);
+    for (std::size_t k = 0; k < table.mesh_scale.size(); ++k)
+    {
+      Element &element = meshes[k];
+      const Vector3 &scale = table.mesh_scale[k];
+      Vector3 lower, upper;
+      element.bounded = mesh_bounds && mesh_bounds(table.mesh_filenames[k], lower, upper);
+      element.half_extent = Vector3();
+      if (element.bounded)
+      {
+        // scale each corner coordinate, a negative scale mirrors the bounds
+        const Vector3 a(lower.x * scale.x, lower.y * scale.y, lower.z * scale.z);
+        const Vector3 b(upper.x * scale.x, upper.y * scale.y, upper.z * scale.z);
+        element.half_extent = Vector3(std::fabs(b.x - a.x), std::fabs(b.y - a.y), std::fabs(b.z - a.z)) * 0.5;
+        element.offset = element.offset * Pose((a + b) * 0.5, Rotation());
+      }
+    }
+    this->element_boxes_.resize(this->elements_.size());
+  };
+
+  /// \brief build the tree for the link poses of a ForwardKinematics update
+  void build(const Pose *link_poses)
+  {
+    const int num_elements = static_cast<int>(this->elements_.size());
+    this->updateElementBoxes(link_poses);
+    this->nodes_.clear();
+    this->nodes_.reserve(num_elements > 0 ? 2 * num_elements - 1 : 0);
+    this->order_.resize(num_elements);
+    this->centers_.resize(num_elements);
+    for (int e = 0; e < num_elements; ++e)
+    {
+      this->order_[e] = e;
+      this->centers_[e] = link_poses[this->elements_[e].link] * this->elements_[e].offset.position;
+    }
+    if (num_elements > 0)
+    {
+      this->buildNode(0, num_elements);
+    }
+    this->refitNodes();
+  };
+
+  /// \brief move the boxes of the built tree to new link poses
+  void refit(const Pose *link_poses)
+  {
+    this->updateElementBoxes(link_poses);
+    this->refitNodes();
+  };
+
+  /// \brief overlapping element pairs that are neither excluded nor allowed, in traversal order
+  void computeSelfCollisionPairs(std::vector<Pair> &pairs, const AllowedCollisionMatrix *allowed = nullptr)
+  {
+    pairs.clear();
+    if (this->nodes_.empty())
+    {
+      return;
+    }
+    std::vector<std::pair<int, int> > &stack = this->pair_stack_;
+    stack.clear();
+    stack.push_back(std::make_pair(0, 0));
+    while (!stack.empty())
+    {
+      const int a = stack.back().first;
+      const int b = stack.back().second;
+      stack.pop_back();
+      const Node &node_a = this->nodes_[a];
+      const Node &node_b = this->nodes_[b];
+      if (a == b)
+      {
+        // the pairs within a subtree are those within and across its children
+        if (node_a.element < 0)
+        {
+          stack.push_back(std::make_pair(a + 1, a + 1));
+          stack.push_back(std::make_pair(node_a.right, node_a.right));
+          stack.push_back(std::make_pair(a + 1, node_a.right));
+        }
+        continue;
+      }
+      if (!node_a.box.overlaps(node_b.box))
+      {
+        continue;
+      }
+      if (node_a.element >= 0 && node_b.element >= 0)
+      {
+        const int link_a = this->elements_[node_a.element].link;
+        const int link_b = this->elements_[node_b.element].link;
+        if (!this->isExcludedLinkPair(link_a, link_b) && !(allowed && allowed->isAllowed(link_a, link_b)))
+        {
+          pairs.push_back(Pair{std::min(node_a.element, node_b.element), std::max(node_a.element, node_b.element)});
+        }
+        continue;
+      }
+      // descend into the larger box
+      if (node_b.element >= 0 || (node_a.element < 0 && extent(node_a.box) >= extent(node_b.box)))
+      {
+        stack.push_back(std::make_pair(a + 1, b));
+        stack.push_back(std::make_pair(node_a.right, b));
+      }
+      else
+      {
+        stack.push_back(std::make_pair(a, b + 1));
+        stack.push_back(std::make_pair(a, node_b.right));
+      }
+    }
+  };
+
+  /// \brief elements whose boxes overlap box, e.g. an obstacle of the environment
+  void queryOverlaps(const BoundingBox &box, std::vector<int> &elements)
+  {
+    elements.clear();
+    if (this->nodes_.empty())
+    {
+      return;
+    }
+    std::vector<int> &stack = this->node_stack_;
+    stack.clear();
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+      const int n = stack.back();
+      stack.pop_back();
+      const Node &node = this->nodes_[n];
+      if (!node.box.overlaps(box))
+      {
+        continue;
+      }
+      if (node.element >= 0)
+      {
+        elements.push_back(node.element);
+      }
+      else
+      {
+        stack.push_back(node.right);
+        stack.push_back(n + 1);
+      }
+    }
+  };
+
+  /// \brief true for pairs of links whose collisions are never reported
+  ///
+  /// These are a link with itself, a link and its parent, whose geometry
+  /// usually touches at the joint, and two links of the same Cluster, which
+  /// are closed into one mechanism by loop constraints.
+  bool isExcludedLinkPair(int a, int b) const
+  {
+    return a == b || this->link_parent_[a] == b || this->link_parent_[b] == a ||
+           (this->link_cluster_[a] >= 0 && this->link_cluster_[a] == this->link_cluster_[b]);
+  };
+
+  /// link index of element e
+  int getElementLink(int e) const { return this->elements_[e].link; };
+  /// the collision geometry, element e is its entry e
+  const GeometryTable &getGeometryTable() const { return this->geometry_; };
+  /// pose of the box bounding element e in its link frame
+  const Pose &getElementOffset(int e) const { return this->elements_[e].offset; };
+  /// half extents of that box, meaningless for unbounded elements
+  const Vector3 &getElementHalfExtent(int e) const { return this->elements_[e].half_extent; };
+  /// false for meshes without bounds, whose box is infinite
+  bool isElementBounded(int e) const { return this->elements_[e].bounded; };
+  /// world box of element e after the last build() or refit()
+  const BoundingBox &getElementBox(int e) const { return this->element_boxes_[e]; };
+  /// box of the whole model after the last build() or refit(), which needs an element
+  const BoundingBox &getRootBox() const { return this->nodes_.front().box; };
+
+  void clear()
+  {
+    this->geometry_.clear();
+    this->elements_.clear();
+    this->element_boxes_.clear();
+    this->nodes_.clear();
+    this->order_.clear();
+    this->centers_.clear();
+    this->link_parent_.clear();
+    this->link_cluster_.clear();
+    this->pair_stack_.clear();
+    this->node_stack_.clear();
+    this->margin = 0.0;
+  };
+
+  /// distance every element box is grown by on all sides, read by build() and refit()
+  double margin;
+
+private:
+  struct Element
+  {
+    int link;
+    /// box center and axes in the link frame
+    Pose offset;
+    Vector3 half_extent;
+    bool bounded;
+  };
+
+  struct Node
+  {
+    BoundingBox box;
+    /// right child of an internal node, the left one is the next node
+    int right;
+    /// element of a leaf, -1 for internal nodes
+    int element;
+  };
+
+  static double extent(const BoundingBox &box)
+  {
+    return (box.upper.x - box.lower.x) + (box.upper.y - box.lower.y) + (box.upper.z - box.lower.z);
+  };
+
+  /// world box of every element, the rotated half extents projected on the world axes
+  void updateElementBoxes(const Pose *link_poses)
+  {
+    const double infinity = std::numeric_limits<double>::infinity();
+    for (std::size_t e = 0; e < this->elements_.size(); ++e)
+    {
+      const Element &element = this->elements_[e];
+      BoundingBox &box = this->element_boxes_[e];
+      if (!element.bounded)
+      {
+        box.lower = Vector3(-infinity, -infinity, -infinity);
+        box.upper = Vector3(infinity, infinity, infinity);
+        continue;
+      }
+      const Pose pose = link_poses[element.link] * element.offset;
+      double m[9];
+      spatial::rotationMatrix(pose.rotation, m);
+      const Vector3 &h = element.half_extent;
+      const Vector3 half(std::fabs(m[0]) * h.x + std::fabs(m[1]) * h.y + std::fabs(m[2]) * h.z + this->margin,
+                         std::fabs(m[3]) * h.x + std::fabs(m[4]) * h.y + std::fabs(m[5]) * h.z + this->margin,
+                         std::fabs(m[6]) * h.x + std::fabs(m[7]) * h.y + std::fabs(m[8]) * h.z + this->margin);
+      box.lower = pose.position - half;
+      box.upper = pose.position + half;
+    }
+  };
+
+  /// node over order_[begin .. end), split at the median center
+  int buildNode(int begin, int end)
+  {
+    const int index = static_cast<int>(this->nodes_.size());
+    this->nodes_.push_back(Node());
+    if (end - begin == 1)
+    {
+      this->nodes_[index].right = -1;
+      this->nodes_[index].element = this->order_[begin];
+      return index;
+    }
+    const std::vector<Vector3> &centers = this->centers_;
+    auto center = [&centers](int e, int axis)
+    {
+      return axis == 0 ? centers[e].x : axis == 1 ? centers[e].y : centers[e].z;
+    };
+    double lower[3], upper[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      lower[axis] = upper[axis] = center(this->order_[begin], axis);
+      for (int k = begin + 1; k < end; ++k)
+      {
+        const double c = center(this->order_[k], axis);
+        lower[axis] = std::min(lower[axis], c);
+        upper[axis] = std::max(upper[axis], c);
+      }
+    }
+    int axis = 0;
+    for (int a = 1; a < 3; ++a)
+    {
+      if (upper[a] - lower[a] > upper[axis] - lower[axis])
+      {
+        axis = a;
+      }
+    }
+    const int middle = begin + (end - begin) / 2;
+    std::nth_element(this->order_.begin() + begin, this->order_.begin() + middle, this->order_.begin() + end,
+                     [&center, axis](int a, int b) { return center(a, axis) < center(b, axis); });
+    this->buildNode(begin, middle);
+    const int right = this->buildNode(middle, end);
+    this->nodes_[index].right = right;
+    this->nodes_[index].element = -1;
+    return index;
+  };
+
+  /// children follow their parents, so one backward pass visits them first
+  void refitNodes()
+  {
+    for (std::size_t n = this->nodes_.size(); n-- > 0;)
+    {
+      Node &node = this->nodes_[n];
+      if (node.element >= 0)
+      {
+        node.box = this->element_boxes_[node.element];
+        continue;
+      }
+      const BoundingBox &left = this->nodes_[n + 1].box;
+      const BoundingBox &right = this->nodes_[node.right].box;
+      node.box.lower = Vector3(std::min(left.lower.x, right.lower.x), std::min(left.lower.y, right.lower.y),
+                               std::min(left.lower.z, right.lower.z));
+      node.box.upper = Vector3(std::max(left.upper.x, right.upper.x), std::max(left.upper.y, right.upper.y),
+                               std::max(left.upper.z, right.upper.z));
+    }
+  };
+
+  GeometryTable geometry_;
+  std::vector<Element> elements_;
+  std::vector<BoundingBox> element_boxes_;
+  std::vector<Node> nodes_;
+  /// element permutation and box centers used while building, the
+  /// centers of unbounded elements are the origins of their frames
+  std::vector<int> order_;
+  std::vector<Vector3> centers_;
+  std::vector<int> link_parent_;
+  std::vector<int> link_cluster_;
+  std::vector<std::pair<int, int> > pair_stack_;
+  std::vector<int> node_stack_;
+};
+
+}
+
+#endif
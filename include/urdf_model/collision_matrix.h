@@ -0,0 +1,233 @@
+/* Bit matrix of link pairs whose collisions need not be checked */
+
+#ifndef URDF_INTERFACE_COLLISION_MATRIX_H
+#define URDF_INTERFACE_COLLISION_MATRIX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <urdf_model/compiled_model.h>
+#include <urdf_exception/exception.h>
+
+namespace urdf{
+
+/// \brief Symmetric set of link pairs that are allowed to collide
+///
+/// A pair is allowed when collision checks may skip it, because the links
+/// are adjacent, can never touch or always touch.  Links are CompiledModel
+/// indices and only the pairs a < b are stored, one bit each, so a model
+/// with n links takes n (n - 1) / 16 bytes.
+///
+/// write() stores the link names with the bits and read() maps them back by
+/// name, so a matrix computed once can be loaded at startup by any model
+/// that has the same link names, whatever their order.  The format is
+///
+///   "UACM", uint32 version, uint32 number of links,
+///   per link uint32 name length and name bytes,
+///   the pair bits in pairIndex() order, least significant bit first
+///
+/// with integers in little endian byte order.
+class AllowedCollisionMatrix
+{
+public:
+  AllowedCollisionMatrix() { this->clear(); };
+  explicit AllowedCollisionMatrix(const CompiledModel &model) { this->init(model); };
+
+  std::size_t getNumLinks() const { return this->link_names_.size(); };
+  std::size_t getNumPairs() const { return pairCount(this->getNumLinks()); };
+
+  /// no pair allowed
+  void init(const CompiledModel &model)
+  {
+    this->clear();
+    for (std::size_t i = 0; i < model.link_names.size(); ++i)
+    {
+      this->link_names_.push_back(std::string(model.link_names[i]));
+    }
+    this->bits_.assign((this->getNumPairs() + 63) / 64, 0);
+  };
+
+  static std::size_t pairCount(std::size_t num_links) { return num_links * (num_links - (num_links > 0)) / 2; };
+
+  /// position of the pair a != b among the pairs of num_links links
+  static std::size_t pairIndex(std::size_t num_links, std::size_t a, std::size_t b)
+  {
+    if (a > b)
+    {
+      std::swap(a, b);
+    }
+    return a * num_links - a * (a + 1) / 2 + (b - a - 1);
+  };
+
+  /// false for a == b, a link always has to be checked against others only
+  bool isAllowed(int a, int b) const
+  {
+    if (a == b)
+    {
+      return false;
+    }
+    const std::size_t k = pairIndex(this->getNumLinks(), a, b);
+    return (this->bits_[k / 64] >> (k % 64)) & 1;
+  };
+
+  void setAllowed(int a, int b, bool allowed)
+  {
+    if (a == b)
+    {
+      return;
+    }
+    const std::size_t k = pairIndex(this->getNumLinks(), a, b);
+    const std::uint64_t bit = std::uint64_t(1) << (k % 64);
+    this->bits_[k / 64] = allowed ? this->bits_[k / 64] | bit : this->bits_[k / 64] & ~bit;
+  };
+
+  /// number of allowed pairs
+  std::size_t count() const
+  {
+    std::size_t n = 0;
+    for (std::uint64_t word : this->bits_)
+    {
+      for (; word; word &= word - 1)
+      {
+        ++n;
+      }
+    }
+    return n;
+  };
+
+  void write(std::ostream &out) const
+  {
+    out.write("UACM", 4);
+    writeUint32(out, VERSION);
+    writeUint32(out, static_cast<std::uint32_t>(this->getNumLinks()));
+    for (const std::string &name : this->link_names_)
+    {
+      writeUint32(out, static_cast<std::uint32_t>(name.size()));
+      out.write(name.data(), name.size());
+    }
+    const std::size_t num_pairs = this->getNumPairs();
+    for (std::size_t byte = 0; byte < (num_pairs + 7) / 8; ++byte)
+    {
+      out.put(static_cast<char>(this->bits_[byte / 8] >> (8 * (byte % 8))));
+    }
+    if (!out)
+    {
+      throw std::runtime_error("Failed to write the allowed collision matrix");
+    }
+  };
+
+  /// \brief load a matrix written by write() for the links of model
+  ///
+  /// Pairs with a link of model that the matrix does not name are not
+  /// allowed.  Throws ParseError for malformed input and for links the
+  /// model does not have or names twice.
+  void read(std::istream &in, const CompiledModel &model)
+  {
+    char magic[4];
+    if (!in.read(magic, 4) || std::string(magic, 4) != "UACM")
+    {
+      throw ParseError("Not an allowed collision matrix");
+    }
+    const std::uint32_t version = readUint32(in);
+    if (version != VERSION)
+    {
+      throw ParseError("Unsupported allowed collision matrix version " + std::to_string(version));
+    }
+    const std::uint32_t num_stored = readUint32(in);
+    if (num_stored > model.getNumLinks())
+    {
+      throw ParseError("Allowed collision matrix has " + std::to_string(num_stored) + " links, the model only " +
+                       std::to_string(model.getNumLinks()));
+    }
+    // a longer name cannot be a link of model, checked before allocating for it
+    std::size_t max_length = 0;
+    for (std::size_t l = 0; l < model.getNumLinks(); ++l)
+    {
+      max_length = std::max(max_length, model.link_names[l].size());
+    }
+    std::vector<int> index(num_stored);
+    std::vector<bool> named(model.getNumLinks(), false);
+    std::string name;
+    for (std::uint32_t i = 0; i < num_stored; ++i)
+    {
+      const std::uint32_t length = readUint32(in);
+      if (length > max_length)
+      {
+        throw ParseError("Allowed collision matrix names a link of " + std::to_string(length) +
+                         " characters, longer than any link of the model");
+      }
+      name.resize(length);
+      if (length > 0 && !in.read(&name[0], length))
+      {
+        throw ParseError("Truncated allowed collision matrix");
+      }
+      index[i] = model.getLinkIndex(name);
+      if (index[i] < 0)
+      {
+        throw ParseError("Allowed collision matrix names link [" + name + "] that the model does not have");
+      }
+      if (named[index[i]])
+      {
+        throw ParseError("Allowed collision matrix names link [" + name + "] twice");
+      }
+      named[index[i]] = true;
+    }
+    std::vector<char> bytes((pairCount(num_stored) + 7) / 8);
+    if (!bytes.empty() && !in.read(bytes.data(), bytes.size()))
+    {
+      throw ParseError("Truncated allowed collision matrix");
+    }
+    this->init(model);
+    for (std::uint32_t a = 0; a < num_stored; ++a)
+    {
+      for (std::uint32_t b = a + 1; b < num_stored; ++b)
+      {
+        const std::size_t k = pairIndex(num_stored, a, b);
+        if ((static_cast<unsigned char>(bytes[k / 8]) >> (k % 8)) & 1)
+        {
+          this->setAllowed(index[a], index[b], true);
+        }
+      }
+    }
+  };
+
+  void clear()
+  {
+    this->link_names_.clear();
+    this->bits_.clear();
+  };
+
+private:
+  static const std::uint32_t VERSION = 1;
+
+  static void writeUint32(std::ostream &out, std::uint32_t value)
+  {
+    const char bytes[4] = {static_cast<char>(value), static_cast<char>(value >> 8), static_cast<char>(value >> 16),
+                           static_cast<char>(value >> 24)};
+    out.write(bytes, 4);
+  };
+
+  static std::uint32_t readUint32(std::istream &in)
+  {
+    unsigned char bytes[4];
+    if (!in.read(reinterpret_cast<char *>(bytes), 4))
+    {
+      throw ParseError("Truncated allowed collision matrix");
+    }
+    return std::uint32_t(bytes[0]) | std::uint32_t(bytes[1]) << 8 | std::uint32_t(bytes[2]) << 16 |
+           std::uint32_t(bytes[3]) << 24;
+  };
+
+  std::vector<std::string> link_names_;
+  std::vector<std::uint64_t> bits_;
+};
+
+}
+
+#endif
@@ -39,7 +39,7 @@
 
 #include <stdexcept>
 #include <string>
-#include <vector>
+#include <string_view>
 #include <math.h>
 
 #include <urdf_model/utils.h>
@@ -65,27 +65,24 @@ public:
   bool init(const std::string &vector_str)
   {
     this->clear();
-    std::vector<std::string> pieces;
-    std::vector<float> rgba;
-    urdf::split_string( pieces, vector_str, " ");
-    for (unsigned int i = 0; i < pieces.size(); ++i)
+    float rgba[4];
+    int count = 0;
+    urdf::StringTokenizer tokenizer(vector_str);
+    std::string_view piece_str;
+    while (tokenizer.next(piece_str))
     {
-      if (!pieces[i].empty())
+      // out of range components have always been reported as parse failures
+      double piece;
+      if (!parseDouble(piece_str, piece) || (piece < 0) || (piece > 1))
       {
-        try
-        {
-          double piece = strToDouble(pieces[i].c_str());
-          if ((piece < 0) || (piece > 1))
-            throw ParseError("Component [" + pieces[i] + "] is outside the valid range for colors [0, 1]");
-          rgba.push_back(static_cast<float>(piece));
-        }
-        catch (std::runtime_error &/*e*/) {
-          throw ParseError("Unable to parse component [" + pieces[i] + "] to a double (while parsing a color value)");
-        }
+        throw ParseError("Unable to parse component [" + std::string(piece_str) + "] to a double (while parsing a color value)");
       }
+      if (count < 4)
+        rgba[count] = static_cast<float>(piece);
+      ++count;
     }
 
-    if (rgba.size() != 4)
+    if (count != 4)
     {
       return false;
     }
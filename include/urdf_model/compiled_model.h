@@ -0,0 +1,344 @@
+/* Flat, index based view of a ModelInterface */
+
+#ifndef URDF_INTERFACE_COMPILED_MODEL_H
+#define URDF_INTERFACE_COMPILED_MODEL_H
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <urdf_model/model.h>
+#include <urdf_model/name_index.h>
+#include <urdf_model/types.h>
+#include <urdf_exception/exception.h>
+
+namespace urdf{
+
+/// \brief Contiguous, integer indexed copy of a fully initialized ModelInterface
+///
+/// Links are numbered in depth-first preorder starting at the root (index 0),
+/// so the parent of a link always has a smaller index and a walk over
+/// 0..getNumLinks()-1 visits parents before children.  Joint j is the parent
+/// joint of link j + 1.  Constraints keep the (name) order of
+/// ModelInterface::constraints_ and clusters keep their ids.  Indices of -1
+/// mean "none".
+///
+/// The model must have been through initTree() and initRoot().
+class CompiledModel
+{
+public:
+  CompiledModel() { this->clear(); };
+  explicit CompiledModel(const ModelInterface &model) { this->init(model); };
+
+  std::size_t getNumLinks() const { return this->link_parent.size(); };
+  std::size_t getNumJoints() const { return this->joint_type.size(); };
+  std::size_t getNumConstraints() const { return this->constraint_class.size(); };
+  std::size_t getNumClusters() const { return this->cluster_parent.size(); };
+  /// length of a joint position vector q
+  std::size_t getNumPositions() const { return this->joint_q_offset.back(); };
+  /// length of a joint velocity vector v
+  std::size_t getNumVelocities() const { return this->joint_v_offset.back(); };
+
+  /// \brief number of position coordinates of a Joint::type
+  ///
+  ///   REVOLUTE, CONTINUOUS, PRISMATIC   1, the joint angle or displacement
+  ///   PLANAR                            3, x and y in the plane and the angle about the normal
+  ///   FLOATING                          7, position then quaternion (x, y, z, w)
+  ///   FIXED, UNKNOWN                    0
+  static int jointNumPositions(int type)
+  {
+    switch (type)
+    {
+      case Joint::REVOLUTE: case Joint::CONTINUOUS: case Joint::PRISMATIC: return 1;
+      case Joint::PLANAR: return 3;
+      case Joint::FLOATING: return 7;
+      default: return 0;
+    }
+  };
+
+  /// \brief number of velocity coordinates of a Joint::type
+  ///
+  /// Equal to jointNumPositions() except for FLOATING joints, whose 6
+  /// velocities are the angular then linear velocity of the child link
+  /// expressed in the child link frame.
+  static int jointNumVelocities(int type)
+  {
+    return type == Joint::FLOATING ? 6 : jointNumPositions(type);
+  };
+
+  /// index of the link with the given name, -1 if there is none
+  int getLinkIndex(std::string_view name) const { return this->link_index_.find(name); };
+
+  /// index of the joint with the given name, -1 if there is none
+  int getJointIndex(std::string_view name) const { return this->joint_index_.find(name); };
+
+  /// children of link i are children[child_offsets[i] .. child_offsets[i+1])
+  const int *childrenBegin(int i) const { return this->children.data() + this->child_offsets[i]; };
+  const int *childrenEnd(int i) const { return this->children.data() + this->child_offsets[i + 1]; };
+
+  /// links of cluster c are cluster_links[cluster_link_offsets[c] .. cluster_link_offsets[c+1])
+  const int *clusterLinksBegin(int c) const { return this->cluster_links.data() + this->cluster_link_offsets[c]; };
+  const int *clusterLinksEnd(int c) const { return this->cluster_links.data() + this->cluster_link_offsets[c + 1]; };
+
+  void init(const ModelInterface &model)
+  {
+    this->clear();
+
+    LinkConstSharedPtr root = model.getRoot();
+    if (!root)
+    {
+      throw ParseError("Cannot compile model [" + model.getName() + "]: no root link, call initTree() and initRoot() first");
+    }
+
+    // depth-first preorder, children in the order of Link::child_links
+    std::unordered_map<const Link *, int> index_of;
+    index_of.reserve(model.links_.size());
+    std::vector<std::pair<LinkConstSharedPtr, int> > stack;
+    stack.push_back(std::make_pair(root, -1));
+    while (!stack.empty())
+    {
+      LinkConstSharedPtr link = stack.back().first;
+      const int parent = stack.back().second;
+      stack.pop_back();
+
+      const int index = static_cast<int>(this->link_parent.size());
+      if (!index_of.insert(std::make_pair(link.get(), index)).second)
+      {
+        throw ParseError("Link [" + link->name + "] is reachable from the root along more than one path");
+      }
+      this->link_parent.push_back(parent);
+      this->link_names.push_back(link->name);
+      this->source_links.push_back(link);
+      this->link_inertial.push_back(link->inertial ? *link->inertial : Inertial());
+
+      if (parent >= 0)
+      {
+        if (!link->parent_joint)
+        {
+          throw ParseError("Link [" + link->name + "] has a parent link but no parent joint");
+        }
+        const Joint &joint = *link->parent_joint;
+        this->link_parent_joint.push_back(static_cast<int>(this->joint_type.size()));
+        this->joint_parent.push_back(parent);
+        this->joint_child.push_back(index);
+        this->joint_type.push_back(joint.type);
+        this->joint_axis.push_back(joint.axis);
+        this->joint_origin.push_back(joint.parent_to_joint_origin_transform);
+        this->joint_names.push_back(joint.name);
+        this->source_joints.push_back(link->parent_joint);
+        this->joint_nq.push_back(jointNumPositions(joint.type));
+        this->joint_nv.push_back(jointNumVelocities(joint.type));
+        this->joint_q_offset.push_back(this->joint_q_offset.back() + this->joint_nq.back());
+        this->joint_v_offset.push_back(this->joint_v_offset.back() + this->joint_nv.back());
+      }
+      else
+      {
+        this->link_parent_joint.push_back(-1);
+      }
+
+      for (std::vector<LinkSharedPtr>::const_reverse_iterator child = link->child_links.rbegin();
+           child != link->child_links.rend(); ++child)
+      {
+        stack.push_back(std::make_pair(LinkConstSharedPtr(*child), index));
+      }
+    }
+
+    if (this->getNumLinks() != model.links_.size())
+    {
+      throw ParseError("Cannot compile model [" + model.getName() + "]: " +
+                       std::to_string(model.links_.size() - this->getNumLinks()) +
+                       " links are not connected to the root link [" + root->name + "]");
+    }
+
+    this->link_index_.reserve(this->getNumLinks());
+    for (std::size_t i = 0; i < this->getNumLinks(); ++i)
+    {
+      this->link_index_.insert(this->link_names[i], static_cast<int>(i));
+    }
+    this->joint_index_.reserve(this->getNumJoints());
+    for (std::size_t j = 0; j < this->getNumJoints(); ++j)
+    {
+      this->joint_index_.insert(this->joint_names[j], static_cast<int>(j));
+    }
+
+    // children in CSR form
+    const std::size_t num_links = this->getNumLinks();
+    this->child_offsets.assign(num_links + 1, 0);
+    for (std::size_t i = 1; i < num_links; ++i)
+    {
+      this->child_offsets[this->link_parent[i] + 1]++;
+    }
+    for (std::size_t i = 0; i < num_links; ++i)
+    {
+      this->child_offsets[i + 1] += this->child_offsets[i];
+    }
+    this->children.resize(num_links > 0 ? num_links - 1 : 0);
+    {
+      std::vector<int> fill(this->child_offsets.begin(), this->child_offsets.end() - 1);
+      for (std::size_t i = 1; i < num_links; ++i)
+      {
+        this->children[fill[this->link_parent[i]]++] = static_cast<int>(i);
+      }
+    }
+
+    // preorder numbering makes every subtree a contiguous range
+    this->subtree_end.assign(num_links, 0);
+    for (std::size_t i = num_links; i-- > 0;)
+    {
+      this->subtree_end[i] = std::max(this->subtree_end[i], static_cast<int>(i) + 1);
+      if (i > 0)
+      {
+        this->subtree_end[this->link_parent[i]] = std::max(this->subtree_end[this->link_parent[i]], this->subtree_end[i]);
+      }
+    }
+
+    // constraints
+    for (std::map<std::string, ConstraintSharedPtr>::const_iterator c = model.constraints_.begin();
+         c != model.constraints_.end(); ++c)
+    {
+      const Constraint &constraint = *c->second;
+      this->constraint_class.push_back(constraint.class_type);
+      this->constraint_predecessor.push_back(this->getLinkIndex(constraint.predecessor_link_name));
+      this->constraint_successor.push_back(this->getLinkIndex(constraint.successor_link_name));
+      this->constraint_ancestor.push_back(this->getLinkIndex(constraint.nearest_common_ancestor_name));
+      this->constraint_names.push_back(constraint.name);
+      this->source_constraints.push_back(c->second);
+    }
+
+    // clusters, keeping the ids of ModelInterface::clusters_
+    int num_clusters = 0;
+    for (std::map<int, ClusterSharedPtr>::const_iterator c = model.clusters_.begin(); c != model.clusters_.end(); ++c)
+    {
+      num_clusters = std::max(num_clusters, c->first + 1);
+    }
+    this->cluster_parent.assign(num_clusters, -1);
+    this->cluster_link_offsets.assign(num_clusters + 1, 0);
+    this->link_cluster.assign(num_links, -1);
+    for (std::map<int, ClusterSharedPtr>::const_iterator c = model.clusters_.begin(); c != model.clusters_.end(); ++c)
+    {
+      this->cluster_link_offsets[c->first + 1] = static_cast<int>(c->second->size());
+    }
+    for (int c = 0; c < num_clusters; ++c)
+    {
+      this->cluster_link_offsets[c + 1] += this->cluster_link_offsets[c];
+    }
+    this->cluster_links.resize(this->cluster_link_offsets[num_clusters]);
+    for (std::map<int, ClusterSharedPtr>::const_iterator c = model.clusters_.begin(); c != model.clusters_.end(); ++c)
+    {
+      int *out = this->cluster_links.data() + this->cluster_link_offsets[c->first];
+      for (const LinkSharedPtr &link : *c->second)
+      {
+        const int index = index_of.at(link.get());
+        *out++ = index;
+        this->link_cluster[index] = c->first;
+      }
+    }
+    for (int c = 0; c < num_clusters; ++c)
+    {
+      for (const int *l = this->clusterLinksBegin(c); l != this->clusterLinksEnd(c); ++l)
+      {
+        const int parent = this->link_parent[*l];
+        if (parent >= 0 && this->link_cluster[parent] != c)
+        {
+          this->cluster_parent[c] = this->link_cluster[parent];
+          break;
+        }
+      }
+    }
+  };
+
+  void clear()
+  {
+    this->link_parent.clear();
+    this->link_parent_joint.clear();
+    this->link_cluster.clear();
+    this->link_inertial.clear();
+    this->link_names.clear();
+    this->source_links.clear();
+    this->child_offsets.assign(1, 0);
+    this->children.clear();
+    this->subtree_end.clear();
+    this->joint_parent.clear();
+    this->joint_child.clear();
+    this->joint_type.clear();
+    this->joint_axis.clear();
+    this->joint_origin.clear();
+    this->joint_names.clear();
+    this->source_joints.clear();
+    this->joint_q_offset.assign(1, 0);
+    this->joint_v_offset.assign(1, 0);
+    this->joint_nq.clear();
+    this->joint_nv.clear();
+    this->constraint_class.clear();
+    this->constraint_predecessor.clear();
+    this->constraint_successor.clear();
+    this->constraint_ancestor.clear();
+    this->constraint_names.clear();
+    this->source_constraints.clear();
+    this->cluster_parent.clear();
+    this->cluster_link_offsets.assign(1, 0);
+    this->cluster_links.clear();
+    this->link_index_.clear();
+    this->joint_index_.clear();
+  };
+
+  /// \brief parent link of each link (lambda(i)), -1 for the root
+  std::vector<int> link_parent;
+  /// \brief joint connecting each link to its parent, -1 for the root
+  std::vector<int> link_parent_joint;
+  /// \brief cluster containing each link
+  std::vector<int> link_cluster;
+  /// \brief inertial of each link, all zero for links without one
+  std::vector<Inertial> link_inertial;
+  StringTable link_names;
+  /// \brief the links this model was compiled from
+  std::vector<LinkConstSharedPtr> source_links;
+
+  /// \brief children of every link in compressed sparse row form
+  std::vector<int> child_offsets;
+  std::vector<int> children;
+  /// \brief the subtree rooted at link i is the link range [i, subtree_end[i])
+  std::vector<int> subtree_end;
+
+  std::vector<int> joint_parent;
+  std::vector<int> joint_child;
+  /// \brief Joint::type of each joint
+  std::vector<int> joint_type;
+  std::vector<Vector3> joint_axis;
+  /// \brief transform from parent link frame to joint frame
+  std::vector<Pose> joint_origin;
+  StringTable joint_names;
+  std::vector<JointConstSharedPtr> source_joints;
+  /// \brief first position / velocity coordinate of each joint, with a
+  /// trailing entry holding the total count
+  std::vector<int> joint_q_offset;
+  std::vector<int> joint_v_offset;
+  std::vector<int> joint_nq;
+  std::vector<int> joint_nv;
+
+  /// \brief Constraint::class_type of each constraint
+  std::vector<int> constraint_class;
+  std::vector<int> constraint_predecessor;
+  std::vector<int> constraint_successor;
+  /// \brief nearest common ancestor of the predecessor and successor links
+  std::vector<int> constraint_ancestor;
+  StringTable constraint_names;
+  std::vector<ConstraintConstSharedPtr> source_constraints;
+
+  /// \brief parent cluster of each cluster, -1 for the root cluster
+  std::vector<int> cluster_parent;
+  /// \brief links of every cluster in compressed sparse row form
+  std::vector<int> cluster_link_offsets;
+  std::vector<int> cluster_links;
+
+private:
+  NameIndex link_index_;
+  NameIndex joint_index_;
+};
+
+}
+
+#endif
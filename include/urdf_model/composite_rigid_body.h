@@ -0,0 +1,310 @@
+/* Joint space mass matrix and centroidal quantities from the link inertials */
+
+#ifndef URDF_INTERFACE_COMPOSITE_RIGID_BODY_H
+#define URDF_INTERFACE_COMPOSITE_RIGID_BODY_H
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <urdf_model/compiled_model.h>
+#include <urdf_model/forward_kinematics.h>
+#include <urdf_model/spatial.h>
+
+namespace urdf{
+
+/// \brief Composite rigid body inertias of a CompiledModel
+///
+/// update() computes, for one set of joint positions, the world frame
+/// composite inertia of every subtree and the spatial force F_j = Ic S_j of
+/// every velocity coordinate j, where S_j is its motion subspace column.
+/// Everything else follows from those in a single pass:
+///
+///   computeMassMatrix()                H[j][k] = S_k . F_j
+///   computeCentroidalMomentumMatrix()  A_G, with [k_G; l] = A_G v
+///   getCenterOfMass(), getTotalMass()
+///
+/// H[j][k] is zero unless one of j and k is an ancestor of the other, see
+/// getVelocityParents().  computeMassMatrix() only visits those entries,
+/// which is O(n d) for n coordinates at depth d instead of O(n^2), and
+/// factorize() and solve() keep to the same pattern since an L^T L
+/// factorization in that order has no fill in.
+///
+/// The matrices are those of the spanning tree coordinates; loop and
+/// coupling constraints are not applied.  q and v use the CompiledModel
+/// coordinate layout, every output goes to a caller provided row major
+/// buffer and nothing allocates after init().
+class CompositeRigidBody
+{
+public:
+  CompositeRigidBody() { this->clear(); };
+  explicit CompositeRigidBody(const CompiledModel &model) { this->init(model); };
+
+  std::size_t getNumLinks() const { return this->link_parent_.size(); };
+  std::size_t getNumPositions() const { return this->kinematics_.getNumPositions(); };
+  std::size_t getNumVelocities() const { return this->velocity_parent_.size(); };
+
+  void init(const CompiledModel &model)
+  {
+    this->clear();
+    const int num_links = static_cast<int>(model.getNumLinks());
+    this->kinematics_.init(model);
+    this->link_parent_ = model.link_parent;
+    this->link_inertial_ = model.link_inertial;
+    this->link_joint_type_.assign(num_links, Joint::FIXED);
+    this->link_q_offset_.assign(num_links, 0);
+    this->link_v_offset_.assign(num_links, 0);
+    this->link_nv_.assign(num_links, 0);
+    this->link_axis_.assign(num_links, Vector3());
+    this->link_plane_x_.assign(num_links, Vector3());
+    this->link_plane_y_.assign(num_links, Vector3());
+    this->velocity_parent_.assign(model.getNumVelocities(), -1);
+
+    // last velocity coordinate of the nearest moving joint at or above each link
+    std::vector<int> last_velocity(num_links, -1);
+    for (int i = 1; i < num_links; ++i)
+    {
+      const int joint = model.link_parent_joint[i];
+      const int nv = model.joint_nv[joint];
+      last_velocity[i] = last_velocity[model.link_parent[i]];
+      if (nv == 0)
+      {
+        continue;
+      }
+      this->link_nv_[i] = nv;
+      this->link_q_offset_[i] = model.joint_q_offset[joint];
+      this->link_v_offset_[i] = model.joint_v_offset[joint];
+      this->link_joint_type_[i] = model.joint_type[joint];
+      if (this->link_joint_type_[i] != Joint::FLOATING)
+      {
+        // ForwardKinematics::init() already rejected zero axes
+        this->link_axis_[i] = model.joint_axis[joint] / model.joint_axis[joint].norm();
+      }
+      if (this->link_joint_type_[i] == Joint::PLANAR)
+      {
+        planarBasis(this->link_axis_[i], this->link_plane_x_[i], this->link_plane_y_[i]);
+      }
+      for (int k = 0; k < nv; ++k)
+      {
+        this->velocity_parent_[this->link_v_offset_[i] + k] = k == 0 ? last_velocity[i] : this->link_v_offset_[i] + k - 1;
+      }
+      last_velocity[i] = this->link_v_offset_[i] + nv - 1;
+    }
+
+    this->poses_.resize(num_links);
+    this->composite_.assign(36 * num_links, 0.0);
+    this->subspace_.assign(6 * this->getNumVelocities(), 0.0);
+    this->forces_.assign(6 * this->getNumVelocities(), 0.0);
+  };
+
+  /// compute the composite inertias for joint positions q
+  void update(const double *q)
+  {
+    const int num_links = static_cast<int>(this->getNumLinks());
+    if (num_links == 0)
+    {
+      return;
+    }
+    this->kinematics_.compute(q, this->poses_.data());
+
+    Vector3 moment;
+    this->total_mass_ = 0.0;
+    for (int i = 0; i < num_links; ++i)
+    {
+      const Inertial &inertial = this->link_inertial_[i];
+      spatial::worldInertia(inertial, this->poses_[i], this->composite_.data() + 36 * i);
+      this->total_mass_ += inertial.mass;
+      moment += this->poses_[i] * inertial.origin.position * inertial.mass;
+    }
+    this->center_of_mass_ = this->total_mass_ > 0.0 ? moment / this->total_mass_ : Vector3();
+
+    // children follow their parents in preorder, so one reverse pass sums every subtree
+    for (int i = num_links - 1; i > 0; --i)
+    {
+      const double *composite = this->composite_.data() + 36 * i;
+      double *parent = this->composite_.data() + 36 * this->link_parent_[i];
+      for (int e = 0; e < 36; ++e)
+      {
+        parent[e] += composite[e];
+      }
+    }
+
+    for (int i = 1; i < num_links; ++i)
+    {
+      if (this->link_nv_[i] == 0)
+      {
+        continue;
+      }
+      const int offset = this->link_v_offset_[i];
+      spatial::jointSubspace(this->link_joint_type_[i], this->link_axis_[i], this->link_plane_x_[i],
+                             this->link_plane_y_[i], this->poses_[i], q + this->link_q_offset_[i],
+                             this->subspace_.data() + 6 * offset);
+      for (int k = 0; k < this->link_nv_[i]; ++k)
+      {
+        spatial::multiply(this->composite_.data() + 36 * i, this->subspace_.data() + 6 * (offset + k),
+                          this->forces_.data() + 6 * (offset + k));
+      }
+    }
+  };
+
+  /// \brief joint space mass matrix of the last update(), getNumVelocities() squared entries
+  ///
+  /// Entries of coordinates on different branches are set to zero.
+  void computeMassMatrix(double *h) const
+  {
+    const int n = static_cast<int>(this->getNumVelocities());
+    std::fill(h, h + n * n, 0.0);
+    for (int j = 0; j < n; ++j)
+    {
+      const double *force = this->forces_.data() + 6 * j;
+      for (int k = j; k >= 0; k = this->velocity_parent_[k])
+      {
+        const double entry = spatial::dot(this->subspace_.data() + 6 * k, force);
+        h[j * n + k] = entry;
+        h[k * n + j] = entry;
+      }
+    }
+  };
+
+  /// \brief centroidal momentum matrix of the last update(), 6 rows of getNumVelocities() entries
+  ///
+  /// Maps v to the angular momentum about the center of mass followed by the
+  /// linear momentum, both in world coordinates.
+  void computeCentroidalMomentumMatrix(double *a) const
+  {
+    const int n = static_cast<int>(this->getNumVelocities());
+    const Vector3 &c = this->center_of_mass_;
+    for (int j = 0; j < n; ++j)
+    {
+      // F_j is the momentum about the world origin, shift it to the center of mass
+      const double *force = this->forces_.data() + 6 * j;
+      const Vector3 linear(force[3], force[4], force[5]);
+      const Vector3 angular = Vector3(force[0], force[1], force[2]) - c.cross(linear);
+      a[j] = angular.x;
+      a[n + j] = angular.y;
+      a[2 * n + j] = angular.z;
+      a[3 * n + j] = linear.x;
+      a[4 * n + j] = linear.y;
+      a[5 * n + j] = linear.z;
+    }
+  };
+
+  /// \brief parent of each velocity coordinate, -1 for coordinates of joints next to the root
+  ///
+  /// The coordinates of one joint form a chain in index order, the first one
+  /// hangs off the last coordinate of the nearest moving ancestor joint.
+  /// Parents always have smaller indices.
+  const std::vector<int> &getVelocityParents() const { return this->velocity_parent_; };
+
+  /// \brief factorize a matrix from computeMassMatrix() in place as H = L^T L
+  ///
+  /// L is lower triangular with the sparsity of H.  Throws
+  /// std::runtime_error if H is not positive definite, which happens for
+  /// massless subtrees below moving joints.
+  void factorize(double *h) const
+  {
+    const int n = static_cast<int>(this->getNumVelocities());
+    for (int k = n - 1; k >= 0; --k)
+    {
+      if (!(h[k * n + k] > 0.0))
+      {
+        throw std::runtime_error("Mass matrix is not positive definite at velocity coordinate " + std::to_string(k));
+      }
+      const double pivot = std::sqrt(h[k * n + k]);
+      h[k * n + k] = pivot;
+      for (int i = this->velocity_parent_[k]; i >= 0; i = this->velocity_parent_[i])
+      {
+        h[k * n + i] /= pivot;
+      }
+      for (int i = this->velocity_parent_[k]; i >= 0; i = this->velocity_parent_[i])
+      {
+        for (int j = i; j >= 0; j = this->velocity_parent_[j])
+        {
+          h[i * n + j] -= h[k * n + i] * h[k * n + j];
+        }
+      }
+    }
+  };
+
+  /// solve H x = b in place, l from factorize() and x holding b on entry
+  void solve(const double *l, double *x) const
+  {
+    const int n = static_cast<int>(this->getNumVelocities());
+    for (int i = n - 1; i >= 0; --i)
+    {
+      x[i] /= l[i * n + i];
+      for (int j = this->velocity_parent_[i]; j >= 0; j = this->velocity_parent_[j])
+      {
+        x[j] -= l[i * n + j] * x[i];
+      }
+    }
+    for (int i = 0; i < n; ++i)
+    {
+      for (int j = this->velocity_parent_[i]; j >= 0; j = this->velocity_parent_[j])
+      {
+        x[i] -= l[i * n + j] * x[j];
+      }
+      x[i] /= l[i * n + i];
+    }
+  };
+
+  /// total mass of the model
+  double getTotalMass() const { return this->total_mass_; };
+  /// world frame center of mass as of the last update(), the origin for a massless model
+  const Vector3 &getCenterOfMass() const { return this->center_of_mass_; };
+  /// world pose of link i as of the last update()
+  const Pose &getLinkPose(int i) const { return this->poses_[i]; };
+  /// world frame composite inertia of the subtree below link i, 36 row major entries
+  const double *getCompositeInertia(int i) const { return this->composite_.data() + 36 * i; };
+
+  void clear()
+  {
+    this->kinematics_.clear();
+    this->link_parent_.clear();
+    this->link_inertial_.clear();
+    this->link_joint_type_.clear();
+    this->link_q_offset_.clear();
+    this->link_v_offset_.clear();
+    this->link_nv_.clear();
+    this->link_axis_.clear();
+    this->link_plane_x_.clear();
+    this->link_plane_y_.clear();
+    this->velocity_parent_.clear();
+    this->poses_.clear();
+    this->composite_.clear();
+    this->subspace_.clear();
+    this->forces_.clear();
+    this->total_mass_ = 0.0;
+    this->center_of_mass_.clear();
+  };
+
+private:
+  ForwardKinematics kinematics_;
+
+  std::vector<int> link_parent_;
+  std::vector<Inertial> link_inertial_;
+  /// FIXED for links whose parent joint has no velocity coordinates
+  std::vector<int> link_joint_type_;
+  std::vector<int> link_q_offset_;
+  std::vector<int> link_v_offset_;
+  std::vector<int> link_nv_;
+  std::vector<Vector3> link_axis_;
+  std::vector<Vector3> link_plane_x_;
+  std::vector<Vector3> link_plane_y_;
+  std::vector<int> velocity_parent_;
+
+  std::vector<Pose> poses_;
+  /// 6x6 per link
+  std::vector<double> composite_;
+  /// 6 per velocity coordinate
+  std::vector<double> subspace_;
+  std::vector<double> forces_;
+  double total_mass_;
+  Vector3 center_of_mass_;
+};
+
+}
+
+#endif
@@ -101,6 +101,7 @@ public:
     this->predecessor_to_constraint_origin_transform.clear();
     this->successor_to_constraint_origin_transform.clear();
     this->class_type = LOOP;
+    this->type = UNKNOWN;
   };
 };
 
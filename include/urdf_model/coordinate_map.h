@@ -0,0 +1,307 @@
+/* Map between full joint coordinates and the independent ones left by mimic joints and couplings */
+
+#ifndef URDF_INTERFACE_COORDINATE_MAP_H
+#define URDF_INTERFACE_COORDINATE_MAP_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <urdf_model/compiled_model.h>
+#include <urdf_model/constraint.h>
+#include <urdf_model/joint.h>
+#include <urdf_exception/exception.h>
+
+namespace urdf{
+
+/// \brief Linear map from reduced (independent) to full joint coordinates
+///
+/// A joint with a JointMimic follows joint_name as
+///
+///   q = multiplier * q(joint_name) + offset
+///
+/// and a CouplingConstraint makes the parent joint of its successor link
+/// follow that of its predecessor link with q = ratio * q(predecessor).  If
+/// only the successor joint is marked independent the relation is inverted,
+/// q(predecessor) = q(successor) / ratio.  init() composes chains of these
+/// relations down to an independent joint and rejects cycles, joints with
+/// more than one relation and relations on joints without exactly one
+/// coordinate, throwing ParseError.
+///
+/// Every other joint keeps its coordinates in the reduced vectors, in joint
+/// order.  This includes joints that are only determined by loop
+/// constraints, which are not linear; ClusterDynamics resolves those.
+///
+/// Full coordinate k is then multiplier[k] * reduced[source[k]] + offset[k]
+/// for positions and without the offset for velocities, so expansion is one
+/// gather and multiply add per coordinate and needs no name lookups.
+class CoordinateMap
+{
+public:
+  CoordinateMap() { this->clear(); };
+  explicit CoordinateMap(const CompiledModel &model) { this->init(model); };
+
+  std::size_t getNumPositions() const { return this->position_source_.size(); };
+  std::size_t getNumVelocities() const { return this->velocity_source_.size(); };
+  std::size_t getNumReducedPositions() const { return this->reduced_positions_.size(); };
+  std::size_t getNumReducedVelocities() const { return this->reduced_velocities_.size(); };
+
+  void init(const CompiledModel &model)
+  {
+    this->clear();
+    const int num_joints = static_cast<int>(model.getNumJoints());
+
+    auto jointName = [&model](int j) { return std::string(model.joint_names[j]); };
+
+    // the joint each joint directly follows, -1 for none
+    std::vector<int> follows(num_joints, -1);
+    std::vector<double> multiplier(num_joints, 1.0);
+    std::vector<double> offset(num_joints, 0.0);
+    std::vector<std::string> relation(num_joints);
+    auto addRelation = [&](int joint, int source, double m, double o, const std::string &name)
+    {
+      if (model.joint_nq[joint] != 1 || model.joint_nq[source] != 1)
+      {
+        throw ParseError(name + " must relate joints with one coordinate, [" + jointName(joint) +
+                         "] and [" + jointName(source) + "] do not both have one");
+      }
+      if (follows[joint] >= 0)
+      {
+        throw ParseError("Joint [" + jointName(joint) + "] is determined both by " + relation[joint] +
+                         " and by " + name);
+      }
+      follows[joint] = source;
+      multiplier[joint] = m;
+      offset[joint] = o;
+      relation[joint] = name;
+    };
+
+    for (int j = 0; j < num_joints; ++j)
+    {
+      const JointMimicConstSharedPtr mimic = model.source_joints[j]->mimic;
+      if (!mimic)
+      {
+        continue;
+      }
+      const int source = model.getJointIndex(mimic->joint_name);
+      if (source < 0)
+      {
+        throw ParseError("Joint [" + jointName(j) + "] mimics unknown joint [" + mimic->joint_name + "]");
+      }
+      addRelation(j, source, mimic->multiplier, mimic->offset, "the mimic of joint [" + jointName(j) + "]");
+    }
+    for (std::size_t c = 0; c < model.getNumConstraints(); ++c)
+    {
+      if (model.constraint_class[c] != Constraint::COUPLING)
+      {
+        continue;
+      }
+      const std::string name = "coupling constraint [" + std::string(model.constraint_names[c]) + "]";
+      const CouplingConstraint *coupling = dynamic_cast<const CouplingConstraint *>(model.source_constraints[c].get());
+      if (!coupling)
+      {
+        throw ParseError("Constraint [" + std::string(model.constraint_names[c]) + "] is a coupling constraint but not a CouplingConstraint");
+      }
+      const int predecessor = model.link_parent_joint[model.constraint_predecessor[c]];
+      const int successor = model.link_parent_joint[model.constraint_successor[c]];
+      if (predecessor < 0 || successor < 0)
+      {
+        throw ParseError("The links of " + name + " must not be the root link");
+      }
+      if (!model.source_joints[successor]->independent || model.source_joints[predecessor]->independent)
+      {
+        addRelation(successor, predecessor, coupling->ratio, 0.0, name);
+      }
+      else if (coupling->ratio != 0.0)
+      {
+        addRelation(predecessor, successor, 1.0 / coupling->ratio, 0.0, name);
+      }
+      else
+      {
+        throw ParseError("The predecessor joint of " + name + " cannot follow its successor with a zero ratio");
+      }
+    }
+
+    // compose chains, marking joints on the current chain to find cycles
+    enum { UNVISITED, ON_CHAIN, RESOLVED };
+    std::vector<int> state(num_joints, UNVISITED);
+    this->joint_source_.assign(num_joints, -1);
+    std::vector<int> chain;
+    for (int j = 0; j < num_joints; ++j)
+    {
+      chain.clear();
+      int k = j;
+      while (follows[k] >= 0 && state[k] == UNVISITED)
+      {
+        state[k] = ON_CHAIN;
+        chain.push_back(k);
+        k = follows[k];
+      }
+      if (state[k] == ON_CHAIN)
+      {
+        std::string cycle;
+        for (std::size_t c = std::find(chain.begin(), chain.end(), k) - chain.begin(); c < chain.size(); ++c)
+        {
+          cycle += "[" + jointName(chain[c]) + "] -> ";
+        }
+        throw ParseError("Mimic and coupling relations form a cycle: " + cycle + "[" + jointName(k) + "]");
+      }
+      // k is independent or already resolved, fold the chain back onto it
+      const int root = follows[k] >= 0 ? this->joint_source_[k] : k;
+      for (std::size_t c = chain.size(); c-- > 0;)
+      {
+        const int joint = chain[c];
+        const int next = follows[joint];
+        if (next != root)
+        {
+          offset[joint] += multiplier[joint] * offset[next];
+          multiplier[joint] *= multiplier[next];
+        }
+        this->joint_source_[joint] = root;
+        state[joint] = RESOLVED;
+      }
+    }
+
+    // reduced layout: the coordinates of independent joints in joint order
+    std::vector<int> reduced_q(num_joints, -1), reduced_v(num_joints, -1);
+    for (int j = 0; j < num_joints; ++j)
+    {
+      if (this->joint_source_[j] >= 0)
+      {
+        continue;
+      }
+      reduced_q[j] = static_cast<int>(this->reduced_positions_.size());
+      reduced_v[j] = static_cast<int>(this->reduced_velocities_.size());
+      for (int k = 0; k < model.joint_nq[j]; ++k)
+      {
+        this->reduced_positions_.push_back(model.joint_q_offset[j] + k);
+      }
+      for (int k = 0; k < model.joint_nv[j]; ++k)
+      {
+        this->reduced_velocities_.push_back(model.joint_v_offset[j] + k);
+      }
+    }
+    this->position_source_.resize(model.getNumPositions());
+    this->position_multiplier_.resize(model.getNumPositions());
+    this->position_offset_.resize(model.getNumPositions());
+    this->velocity_source_.resize(model.getNumVelocities());
+    this->velocity_multiplier_.resize(model.getNumVelocities());
+    for (int j = 0; j < num_joints; ++j)
+    {
+      const int root = this->joint_source_[j] >= 0 ? this->joint_source_[j] : j;
+      const bool dependent = root != j;
+      for (int k = 0; k < model.joint_nq[j]; ++k)
+      {
+        const int full = model.joint_q_offset[j] + k;
+        this->position_source_[full] = reduced_q[root] + k;
+        this->position_multiplier_[full] = dependent ? multiplier[j] : 1.0;
+        this->position_offset_[full] = dependent ? offset[j] : 0.0;
+      }
+      for (int k = 0; k < model.joint_nv[j]; ++k)
+      {
+        const int full = model.joint_v_offset[j] + k;
+        this->velocity_source_[full] = reduced_v[root] + k;
+        this->velocity_multiplier_[full] = dependent ? multiplier[j] : 1.0;
+      }
+    }
+  };
+
+  /// full positions, getNumPositions() entries, from reduced ones
+  void expandPositions(const double *reduced, double *full) const
+  {
+    const std::size_t n = this->getNumPositions();
+    const int *source = this->position_source_.data();
+    const double *multiplier = this->position_multiplier_.data();
+    const double *offset = this->position_offset_.data();
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      full[k] = multiplier[k] * reduced[source[k]] + offset[k];
+    }
+  };
+
+  /// full velocities or accelerations, getNumVelocities() entries, from reduced ones
+  void expandVelocities(const double *reduced, double *full) const
+  {
+    const std::size_t n = this->getNumVelocities();
+    const int *source = this->velocity_source_.data();
+    const double *multiplier = this->velocity_multiplier_.data();
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      full[k] = multiplier[k] * reduced[source[k]];
+    }
+  };
+
+  /// the independent entries of full positions, dependent ones are ignored
+  void reducePositions(const double *full, double *reduced) const
+  {
+    const std::size_t n = this->getNumReducedPositions();
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      reduced[k] = full[this->reduced_positions_[k]];
+    }
+  };
+
+  /// the independent entries of full velocities, dependent ones are ignored
+  void reduceVelocities(const double *full, double *reduced) const
+  {
+    const std::size_t n = this->getNumReducedVelocities();
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      reduced[k] = full[this->reduced_velocities_[k]];
+    }
+  };
+
+  /// \brief generalized forces or gradients on the reduced velocities, G^T full
+  ///
+  /// G is the velocity expansion, so this is the chain rule for a gradient
+  /// with respect to full velocities (or, away from FLOATING joints, positions).
+  void reduceForces(const double *full, double *reduced) const
+  {
+    std::fill(reduced, reduced + this->getNumReducedVelocities(), 0.0);
+    const std::size_t n = this->getNumVelocities();
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      reduced[this->velocity_source_[k]] += this->velocity_multiplier_[k] * full[k];
+    }
+  };
+
+  /// independent joint that joint j follows, -1 if j is independent itself
+  int getJointSource(int j) const { return this->joint_source_[j]; };
+
+  /// reduced position index of every full position and its multiplier and offset
+  const std::vector<int> &getPositionSources() const { return this->position_source_; };
+  const std::vector<double> &getPositionMultipliers() const { return this->position_multiplier_; };
+  const std::vector<double> &getPositionOffsets() const { return this->position_offset_; };
+  /// reduced velocity index of every full velocity and its multiplier
+  const std::vector<int> &getVelocitySources() const { return this->velocity_source_; };
+  const std::vector<double> &getVelocityMultipliers() const { return this->velocity_multiplier_; };
+  /// full index of every reduced position and velocity
+  const std::vector<int> &getReducedPositions() const { return this->reduced_positions_; };
+  const std::vector<int> &getReducedVelocities() const { return this->reduced_velocities_; };
+
+  void clear()
+  {
+    this->joint_source_.clear();
+    this->position_source_.clear();
+    this->position_multiplier_.clear();
+    this->position_offset_.clear();
+    this->velocity_source_.clear();
+    this->velocity_multiplier_.clear();
+    this->reduced_positions_.clear();
+    this->reduced_velocities_.clear();
+  };
+
+private:
+  std::vector<int> joint_source_;
+  std::vector<int> position_source_;
+  std::vector<double> position_multiplier_;
+  std::vector<double> position_offset_;
+  std::vector<int> velocity_source_;
+  std::vector<double> velocity_multiplier_;
+  std::vector<int> reduced_positions_;
+  std::vector<int> reduced_velocities_;
+};
+
+}
+
+#endif
@@ -0,0 +1,926 @@
+/* Forward dynamics over the cluster tree of a CompiledModel */
+
+#ifndef URDF_INTERFACE_DYNAMICS_H
+#define URDF_INTERFACE_DYNAMICS_H
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <urdf_model/compiled_model.h>
+#include <urdf_model/constraint.h>
+#include <urdf_model/forward_kinematics.h>
+#include <urdf_model/spatial.h>
+#include <urdf_exception/exception.h>
+
+namespace urdf{
+
+namespace detail{
+
+/// in place Cholesky factorization (lower triangle) of the n x n row major
+/// matrix a, false if a is not positive definite
+inline bool choleskyFactor(double *a, int n)
+{
+  for (int j = 0; j < n; ++j)
+  {
+    double d = a[j * n + j];
+    for (int k = 0; k < j; ++k)
+    {
+      d -= a[j * n + k] * a[j * n + k];
+    }
+    if (!(d > 0.0))
+    {
+      return false;
+    }
+    d = std::sqrt(d);
+    a[j * n + j] = d;
+    for (int i = j + 1; i < n; ++i)
+    {
+      double s = a[i * n + j];
+      for (int k = 0; k < j; ++k)
+      {
+        s -= a[i * n + k] * a[j * n + k];
+      }
+      a[i * n + j] = s / d;
+    }
+  }
+  return true;
+}
+
+/// solve L L^T x = b in place, l from choleskyFactor(), consecutive entries of b are stride apart
+inline void choleskySolve(const double *l, int n, double *b, int stride = 1)
+{
+  for (int i = 0; i < n; ++i)
+  {
+    double s = b[i * stride];
+    for (int k = 0; k < i; ++k)
+    {
+      s -= l[i * n + k] * b[k * stride];
+    }
+    b[i * stride] = s / l[i * n + i];
+  }
+  for (int i = n - 1; i >= 0; --i)
+  {
+    double s = b[i * stride];
+    for (int k = i + 1; k < n; ++k)
+    {
+      s -= l[k * n + i] * b[k * stride];
+    }
+    b[i * stride] = s / l[i * n + i];
+  }
+}
+
+}
+
+/// \brief Forward dynamics of a CompiledModel by articulated body recursion over its clusters
+///
+/// Every cluster (a strongly connected set of links, see
+/// ModelInterface::initTree()) is treated as one body whose motion is given
+/// by the spanning tree coordinates y of its links.  Loop and coupling
+/// constraints inside a cluster restrict y to y' = G u' + g, where u are the
+/// coordinates of the joints marked Joint::independent.  The recursion then
+/// runs over the cluster tree exactly like the articulated body algorithm
+/// over a tree of rigid bodies, with 6n x 6n articulated inertias for
+/// clusters of n links.  Its cost is linear in the number of clusters and
+/// cubic only in the size of each cluster, so a tree costs O(n).
+///
+/// Constraints:
+///   LoopConstraint      the successor's loop frame may only move relative
+///                       to the predecessor's loop frame along the loop
+///                       joint's axis (type REVOLUTE, CONTINUOUS, PRISMATIC,
+///                       PLANAR or FIXED)
+///   CouplingConstraint  velocity of the successor's parent joint = ratio *
+///                       velocity of the predecessor's parent joint, both
+///                       joints having one coordinate
+///
+/// Each constrained cluster needs at least one dependent coordinate per
+/// independent constraint equation; redundant equations (a planar linkage
+/// closed by a spatial revolute loop) are allowed, G is computed through
+/// the normal equations.  All clusters must hang off a single link of their
+/// parent cluster.
+///
+/// q, v, tau and the result use the CompiledModel coordinate layout.  v must
+/// satisfy the constraints; the result is the spanning tree acceleration,
+/// which satisfies them as well.  The root link is fixed in the world.
+///
+/// forwardDynamics() does not allocate, it uses workspace owned by the
+/// object, so one object must not be used by several threads at once.
+class ClusterDynamics
+{
+public:
+  ClusterDynamics() { this->clear(); };
+  explicit ClusterDynamics(const CompiledModel &model) { this->init(model); };
+
+  /// gravitational acceleration in world coordinates, (0, 0, -9.81) by default
+  Vector3 gravity;
+
+  std::size_t getNumLinks() const { return this->link_parent_.size(); };
+  std::size_t getNumPositions() const { return this->kinematics_.getNumPositions(); };
+  std::size_t getNumVelocities() const { return this->num_velocities_; };
+
+  void init(const CompiledModel &model)
+  {
+    this->clear();
+    const int num_links = static_cast<int>(model.getNumLinks());
+    this->kinematics_.init(model);
+    this->num_velocities_ = model.getNumVelocities();
+    this->link_parent_ = model.link_parent;
+    this->link_inertial_ = model.link_inertial;
+    this->link_joint_type_.assign(num_links, Joint::FIXED);
+    this->link_q_offset_.assign(num_links, 0);
+    this->link_v_offset_.assign(num_links, 0);
+    this->link_nv_.assign(num_links, 0);
+    this->link_axis_.assign(num_links, Vector3());
+    this->link_plane_x_.assign(num_links, Vector3());
+    this->link_plane_y_.assign(num_links, Vector3());
+    for (int i = 1; i < num_links; ++i)
+    {
+      const int joint = model.link_parent_joint[i];
+      this->link_nv_[i] = model.joint_nv[joint];
+      this->link_q_offset_[i] = model.joint_q_offset[joint];
+      this->link_v_offset_[i] = model.joint_v_offset[joint];
+      this->link_joint_type_[i] = this->link_nv_[i] > 0 ? model.joint_type[joint] : static_cast<int>(Joint::FIXED);
+      const double norm = model.joint_axis[joint].norm();
+      if (this->link_nv_[i] > 0 && this->link_joint_type_[i] != Joint::FLOATING)
+      {
+        // ForwardKinematics::init() already rejected zero axes
+        this->link_axis_[i] = model.joint_axis[joint] / norm;
+      }
+      if (this->link_joint_type_[i] == Joint::PLANAR)
+      {
+        planarBasis(this->link_axis_[i], this->link_plane_x_[i], this->link_plane_y_[i]);
+      }
+    }
+
+    // clusters ordered parents first; a parent cluster holds the parent of
+    // every entry link, which precedes it in preorder
+    std::vector<int> order;
+    for (std::size_t c = 0; c < model.getNumClusters(); ++c)
+    {
+      if (model.clusterLinksBegin(c) != model.clusterLinksEnd(c))
+      {
+        order.push_back(static_cast<int>(c));
+      }
+    }
+    std::vector<int> first_link(model.getNumClusters(), num_links);
+    for (int c : order)
+    {
+      first_link[c] = *std::min_element(model.clusterLinksBegin(c), model.clusterLinksEnd(c));
+    }
+    std::sort(order.begin(), order.end(), [&first_link](int a, int b) { return first_link[a] < first_link[b]; });
+
+    std::vector<int> cluster_slot(model.getNumClusters(), -1);
+    std::vector<int> local_index(num_links, -1);
+    this->clusters_.resize(order.size());
+    for (std::size_t k = 0; k < order.size(); ++k)
+    {
+      ClusterData &cluster = this->clusters_[k];
+      cluster_slot[order[k]] = static_cast<int>(k);
+      cluster.links.assign(model.clusterLinksBegin(order[k]), model.clusterLinksEnd(order[k]));
+      std::sort(cluster.links.begin(), cluster.links.end());
+      cluster.name = "containing link [" + std::string(model.link_names[cluster.links[0]]) + "]";
+
+      cluster.parent_link = -1;
+      for (std::size_t l = 0; l < cluster.links.size(); ++l)
+      {
+        const int i = cluster.links[l];
+        local_index[i] = static_cast<int>(l);
+        const int parent = this->link_parent_[i];
+        if (parent >= 0 && model.link_cluster[parent] == order[k])
+        {
+          cluster.local_parent.push_back(local_index[parent]);
+        }
+        else
+        {
+          cluster.local_parent.push_back(-1);
+          if (l > 0 && parent != cluster.parent_link)
+          {
+            throw ParseError("Cluster " + cluster.name + " is attached to more than one link of its parent cluster");
+          }
+          cluster.parent_link = parent;
+        }
+        cluster.column.push_back(static_cast<int>(cluster.coordinates.size()));
+        for (int k_v = 0; k_v < this->link_nv_[i]; ++k_v)
+        {
+          const int column = static_cast<int>(cluster.coordinates.size());
+          cluster.coordinates.push_back(this->link_v_offset_[i] + k_v);
+          if (model.source_joints[model.link_parent_joint[i]]->independent)
+          {
+            cluster.independent.push_back(column);
+          }
+          else
+          {
+            cluster.dependent.push_back(column);
+          }
+        }
+      }
+    }
+
+    // constraints
+    for (std::size_t c = 0; c < model.getNumConstraints(); ++c)
+    {
+      const Constraint &constraint = *model.source_constraints[c];
+      const int predecessor = model.constraint_predecessor[c];
+      const int successor = model.constraint_successor[c];
+      if (predecessor < 0 || successor < 0 || model.link_cluster[predecessor] != model.link_cluster[successor])
+      {
+        throw ParseError("Constraint [" + constraint.name + "] does not connect two links of the same cluster");
+      }
+      ClusterData &cluster = this->clusters_[cluster_slot[model.link_cluster[predecessor]]];
+
+      ConstraintData data;
+      data.predecessor = local_index[predecessor];
+      data.successor = local_index[successor];
+      if (constraint.class_type == Constraint::LOOP)
+      {
+        const LoopConstraint *loop = dynamic_cast<const LoopConstraint *>(&constraint);
+        if (!loop)
+        {
+          throw ParseError("Constraint [" + constraint.name + "] is a loop constraint but not a LoopConstraint");
+        }
+        data.type = loop->type;
+        switch (loop->type)
+        {
+          case LoopConstraint::REVOLUTE: case LoopConstraint::CONTINUOUS: case LoopConstraint::PRISMATIC: data.num_rows = 5; break;
+          case LoopConstraint::PLANAR: data.num_rows = 3; break;
+          case LoopConstraint::FIXED: data.num_rows = 6; break;
+          default: throw ParseError("Loop constraint [" + constraint.name + "] has an unknown type");
+        }
+        const double norm = loop->axis.norm();
+        if (loop->type != LoopConstraint::FIXED && !(norm > 0.0))
+        {
+          throw ParseError("Loop constraint [" + constraint.name + "] has a zero axis");
+        }
+        data.axis = loop->type != LoopConstraint::FIXED ? loop->axis / norm : Vector3(1.0, 0.0, 0.0);
+        data.predecessor_origin = loop->predecessor_to_constraint_origin_transform;
+        data.successor_origin = loop->successor_to_constraint_origin_transform;
+      }
+      else if (constraint.class_type == Constraint::COUPLING)
+      {
+        const CouplingConstraint *coupling = dynamic_cast<const CouplingConstraint *>(&constraint);
+        if (!coupling)
+        {
+          throw ParseError("Constraint [" + constraint.name + "] is a coupling constraint but not a CouplingConstraint");
+        }
+        if (this->link_nv_[predecessor] != 1 || this->link_nv_[successor] != 1)
+        {
+          throw ParseError("Coupling constraint [" + constraint.name + "] must connect links whose parent joints have one coordinate");
+        }
+        data.type = -1;
+        data.num_rows = 1;
+        data.ratio = coupling->ratio;
+      }
+      else
+      {
+        throw ParseError("Constraint [" + constraint.name + "] has an unknown class");
+      }
+      cluster.num_rows += data.num_rows;
+      cluster.constraints.push_back(data);
+    }
+
+    for (ClusterData &cluster : this->clusters_)
+    {
+      if (cluster.constraints.empty() && !cluster.dependent.empty())
+      {
+        throw ParseError("Cluster " + cluster.name + " has dependent joint coordinates but no constraints");
+      }
+      if (!cluster.constraints.empty() && cluster.dependent.empty())
+      {
+        throw ParseError("Cluster " + cluster.name + " has constraints but no dependent joint coordinates");
+      }
+      if (cluster.dependent.size() > static_cast<std::size_t>(cluster.num_rows))
+      {
+        throw ParseError("Cluster " + cluster.name + " has more dependent joint coordinates than constraint equations");
+      }
+      cluster.reserve();
+    }
+
+    this->poses_.resize(num_links);
+    this->velocities_.assign(6 * num_links, 0.0);
+    this->accelerations_.assign(6 * num_links, 0.0);
+    this->inertias_.assign(36 * num_links, 0.0);
+    this->bias_forces_.assign(6 * num_links, 0.0);
+  };
+
+  /// \brief Joint accelerations vdot for positions q, velocities v and joint forces tau
+  ///
+  /// f_ext optionally holds one world frame wrench [moment about the world
+  /// origin; force] per link acting on that link.  Throws std::runtime_error
+  /// if a cluster's mass matrix or constraints are singular.
+  void forwardDynamics(const double *q, const double *v, const double *tau, double *vdot,
+                       const double *f_ext = nullptr)
+  {
+    const int num_links = static_cast<int>(this->getNumLinks());
+    if (num_links == 0)
+    {
+      return;
+    }
+    this->kinematics_.compute(q, this->poses_.data());
+
+    for (ClusterData &cluster : this->clusters_)
+    {
+      this->computeVelocities(cluster, q, v, f_ext);
+      this->computeConstraintBasis(cluster);
+    }
+
+    for (std::size_t k = this->clusters_.size(); k-- > 0;)
+    {
+      this->backwardPass(this->clusters_[k], tau);
+    }
+
+    const double base_acceleration[6] = {0.0, 0.0, 0.0, -this->gravity.x, -this->gravity.y, -this->gravity.z};
+    for (ClusterData &cluster : this->clusters_)
+    {
+      const double *parent_acceleration = cluster.parent_link >= 0 ?
+        &this->accelerations_[6 * cluster.parent_link] : base_acceleration;
+      this->forwardPass(cluster, parent_acceleration, vdot);
+    }
+  };
+
+  /// world pose of link i as of the last forwardDynamics()
+  const Pose &getLinkPose(int i) const { return this->poses_[i]; };
+  /// world frame spatial velocity of link i as of the last forwardDynamics()
+  const double *getLinkVelocity(int i) const { return &this->velocities_[6 * i]; };
+
+  void clear()
+  {
+    this->gravity = Vector3(0.0, 0.0, -9.81);
+    this->kinematics_.clear();
+    this->num_velocities_ = 0;
+    this->link_parent_.clear();
+    this->link_inertial_.clear();
+    this->link_joint_type_.clear();
+    this->link_q_offset_.clear();
+    this->link_v_offset_.clear();
+    this->link_nv_.clear();
+    this->link_axis_.clear();
+    this->link_plane_x_.clear();
+    this->link_plane_y_.clear();
+    this->clusters_.clear();
+    this->poses_.clear();
+    this->velocities_.clear();
+    this->accelerations_.clear();
+    this->inertias_.clear();
+    this->bias_forces_.clear();
+  };
+
+private:
+  struct ConstraintData
+  {
+    ConstraintData() : type(0), predecessor(-1), successor(-1), num_rows(0), ratio(1.0) {}
+    /// LoopConstraint::type, -1 for coupling constraints
+    int type;
+    /// positions in ClusterData::links
+    int predecessor;
+    int successor;
+    int num_rows;
+    double ratio;
+    Vector3 axis;
+    Pose predecessor_origin;
+    Pose successor_origin;
+  };
+
+  struct ClusterData
+  {
+    ClusterData() : parent_link(-1), num_rows(0) {}
+
+    /// for error messages
+    std::string name;
+    /// member links in preorder
+    std::vector<int> links;
+    /// position of the parent of every member in links, -1 for entry links
+    std::vector<int> local_parent;
+    /// first column of every member's parent joint
+    std::vector<int> column;
+    /// link all entry links are attached to, -1 for the world
+    int parent_link;
+    /// velocity index of every spanning tree column
+    std::vector<int> coordinates;
+    std::vector<int> independent;
+    std::vector<int> dependent;
+    std::vector<ConstraintData> constraints;
+    int num_rows;
+
+    // workspace, see reserve()
+    std::vector<double> jacobian;
+    std::vector<double> bias;
+    std::vector<double> basis;
+    std::vector<double> basis_bias;
+    std::vector<double> psi;
+    std::vector<double> u_matrix;
+    std::vector<double> d_matrix;
+    std::vector<double> u_vector;
+    std::vector<double> u_sum;
+    std::vector<double> solved;
+    std::vector<double> k_matrix;
+    std::vector<double> k_vector;
+    std::vector<double> normal;
+    std::vector<double> rhs;
+    std::vector<double> ydot;
+    std::vector<double> udot;
+    std::vector<double> scratch;
+
+    std::size_t numColumns() const { return this->coordinates.size(); };
+    std::size_t numIndependent() const { return this->independent.size(); };
+
+    void reserve()
+    {
+      const std::size_t rows = 6 * this->links.size();
+      const std::size_t m = this->numColumns();
+      const std::size_t r = this->numIndependent();
+      const std::size_t d = this->dependent.size();
+      this->jacobian.assign(rows * m, 0.0);          // S, the spanning tree motion subspace
+      this->bias.assign(rows, 0.0);                  // Sdot ydot, then the full velocity product c
+      this->basis.assign(m * r, 0.0);                // G
+      this->basis_bias.assign(m, 0.0);               // g
+      this->psi.assign(rows * r, 0.0);               // S G
+      this->u_matrix.assign(rows * r, 0.0);          // IA S G
+      this->d_matrix.assign(r * r, 0.0);
+      this->u_vector.assign(r, 0.0);
+      this->u_sum.assign(6 * r, 0.0);                // B^T U
+      this->solved.assign(6 * r, 0.0);               // D^-1 U^T B
+      this->k_matrix.assign(this->num_rows * m, 0.0);
+      this->k_vector.assign(this->num_rows, 0.0);
+      this->normal.assign(d * d, 0.0);
+      this->rhs.assign(d * (r + 1), 0.0);
+      this->ydot.assign(m, 0.0);
+      this->udot.assign(r, 0.0);
+      this->scratch.assign(r, 0.0);
+    };
+  };
+
+  /// world frame motion subspace of the parent joint of link i, column k at s + 6 k
+  void motionSubspace(int i, const double *q, double *s) const
+  {
+    spatial::jointSubspace(this->link_joint_type_[i], this->link_axis_[i], this->link_plane_x_[i],
+                           this->link_plane_y_[i], this->poses_[i], q + this->link_q_offset_[i], s);
+  };
+
+  /// spanning tree Jacobians, link velocities, velocity products and rigid body terms
+  void computeVelocities(ClusterData &cluster, const double *q, const double *v, const double *f_ext)
+  {
+    const std::size_t m = cluster.numColumns();
+    for (std::size_t l = 0; l < cluster.links.size(); ++l)
+    {
+      const int i = cluster.links[l];
+      const int local_parent = cluster.local_parent[l];
+      double *jacobian = cluster.jacobian.data() + 6 * l * m;
+      double *bias = cluster.bias.data() + 6 * l;
+      if (local_parent >= 0)
+      {
+        std::copy(cluster.jacobian.data() + 6 * local_parent * m, cluster.jacobian.data() + 6 * (local_parent + 1) * m, jacobian);
+        std::copy(cluster.bias.data() + 6 * local_parent, cluster.bias.data() + 6 * local_parent + 6, bias);
+      }
+      else
+      {
+        std::fill(jacobian, jacobian + 6 * m, 0.0);
+        std::fill(bias, bias + 6, 0.0);
+      }
+
+      double *velocity = &this->velocities_[6 * i];
+      const int parent = this->link_parent_[i];
+      const double zero[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+      const double *parent_velocity = parent >= 0 ? &this->velocities_[6 * parent] : zero;
+      const int nv = this->link_nv_[i];
+      if (nv > 0)
+      {
+        double s[36];
+        this->motionSubspace(i, q, s);
+        double joint_velocity[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+        double translation_velocity[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+        const double *vj = v + this->link_v_offset_[i];
+        for (int k = 0; k < nv; ++k)
+        {
+          for (int r = 0; r < 6; ++r)
+          {
+            jacobian[r * m + cluster.column[l] + k] = s[6 * k + r];
+            joint_velocity[r] += s[6 * k + r] * vj[k];
+          }
+        }
+        for (int r = 0; r < 6; ++r)
+        {
+          velocity[r] = parent_velocity[r] + joint_velocity[r];
+        }
+
+        // Sdot ydot: columns fixed in the child frame change with the child
+        // velocity, those fixed in the parent frame with the parent velocity;
+        // for a column s along the joint motion v_child x s = v_parent x s
+        double product[6];
+        if (this->link_joint_type_[i] == Joint::PLANAR)
+        {
+          for (int r = 0; r < 6; ++r)
+          {
+            translation_velocity[r] = s[r] * vj[0] + s[6 + r] * vj[1];
+          }
+          spatial::crossMotion(parent_velocity, translation_velocity, product);
+          for (int r = 0; r < 6; ++r)
+          {
+            bias[r] += product[r];
+            translation_velocity[r] = s[12 + r] * vj[2];
+          }
+          spatial::crossMotion(velocity, translation_velocity, product);
+        }
+        else
+        {
+          spatial::crossMotion(parent_velocity, joint_velocity, product);
+        }
+        for (int r = 0; r < 6; ++r)
+        {
+          bias[r] += product[r];
+        }
+      }
+      else
+      {
+        std::copy(parent_velocity, parent_velocity + 6, velocity);
+      }
+
+      // rigid body inertia and bias force v x* I v - f_ext
+      double *inertia = &this->inertias_[36 * i];
+      spatial::worldInertia(this->link_inertial_[i], this->poses_[i], inertia);
+      double momentum[6];
+      spatial::multiply(inertia, velocity, momentum);
+      double *bias_force = &this->bias_forces_[6 * i];
+      spatial::crossForce(velocity, momentum, bias_force);
+      if (f_ext)
+      {
+        for (int r = 0; r < 6; ++r)
+        {
+          bias_force[r] -= f_ext[6 * i + r];
+        }
+      }
+    }
+
+    for (std::size_t c = 0; c < m; ++c)
+    {
+      cluster.ydot[c] = v[cluster.coordinates[c]];
+    }
+  };
+
+  /// G, g and from them psi = S G and c = Sdot ydot + S g
+  void computeConstraintBasis(ClusterData &cluster)
+  {
+    const std::size_t m = cluster.numColumns();
+    const std::size_t r = cluster.numIndependent();
+    const std::size_t rows = 6 * cluster.links.size();
+    if (cluster.constraints.empty())
+    {
+      std::copy(cluster.jacobian.begin(), cluster.jacobian.end(), cluster.psi.begin());
+      return;
+    }
+
+    // K y'' = -k
+    std::fill(cluster.k_matrix.begin(), cluster.k_matrix.end(), 0.0);
+    int row = 0;
+    for (const ConstraintData &constraint : cluster.constraints)
+    {
+      double *k_row = cluster.k_matrix.data() + row * m;
+      if (constraint.type < 0)
+      {
+        k_row[cluster.column[constraint.successor]] += 1.0;
+        k_row[cluster.column[constraint.predecessor]] -= constraint.ratio;
+        cluster.k_vector[row] = 0.0;
+        ++row;
+        continue;
+      }
+
+      // wrenches transmitted by the loop joint, in the predecessor's loop frame
+      const int predecessor = cluster.links[constraint.predecessor];
+      const int successor = cluster.links[constraint.successor];
+      const Pose frame = this->poses_[predecessor] * constraint.predecessor_origin;
+      const Vector3 axis = frame.rotation * constraint.axis;
+      Vector3 b1, b2;
+      planarBasis(axis, b1, b2);
+      const Vector3 directions[3] = {axis, b1, b2};
+      double wrenches[36];
+      int num_wrenches = 0;
+      for (int k = 0; k < 3; ++k)
+      {
+        // pure moments [d; 0], except about the axis of a rotating loop joint
+        const bool free = k == 0 && constraint.type != LoopConstraint::PRISMATIC && constraint.type != LoopConstraint::FIXED;
+        if (!free)
+        {
+          double *wrench = wrenches + 6 * num_wrenches++;
+          wrench[0] = directions[k].x; wrench[1] = directions[k].y; wrench[2] = directions[k].z;
+          wrench[3] = wrench[4] = wrench[5] = 0.0;
+        }
+      }
+      for (int k = 0; k < 3; ++k)
+      {
+        // forces through the loop frame origin [p x d; d], except along the
+        // directions a prismatic or planar loop joint translates in
+        const bool free = constraint.type == LoopConstraint::PRISMATIC ? k == 0 :
+                          constraint.type == LoopConstraint::PLANAR ? k > 0 : false;
+        if (!free)
+        {
+          double *wrench = wrenches + 6 * num_wrenches++;
+          const Vector3 moment = frame.position.cross(directions[k]);
+          wrench[0] = moment.x; wrench[1] = moment.y; wrench[2] = moment.z;
+          wrench[3] = directions[k].x; wrench[4] = directions[k].y; wrench[5] = directions[k].z;
+        }
+      }
+
+      const double *jacobian_s = cluster.jacobian.data() + 6 * constraint.successor * m;
+      const double *jacobian_p = cluster.jacobian.data() + 6 * constraint.predecessor * m;
+      double relative_bias[6], product[6];
+      spatial::crossMotion(&this->velocities_[6 * successor], &this->velocities_[6 * predecessor], product);
+      for (int e = 0; e < 6; ++e)
+      {
+        relative_bias[e] = cluster.bias[6 * constraint.successor + e] - cluster.bias[6 * constraint.predecessor + e] + product[e];
+      }
+      for (int w = 0; w < num_wrenches; ++w)
+      {
+        const double *wrench = wrenches + 6 * w;
+        double *k_row = cluster.k_matrix.data() + row * m;
+        for (std::size_t c = 0; c < m; ++c)
+        {
+          double value = 0.0;
+          for (int e = 0; e < 6; ++e)
+          {
+            value += wrench[e] * (jacobian_s[e * m + c] - jacobian_p[e * m + c]);
+          }
+          k_row[c] = value;
+        }
+        cluster.k_vector[row] = spatial::dot(wrench, relative_bias);
+        ++row;
+      }
+    }
+
+    // y'_dep = -(K_d^T K_d)^-1 K_d^T (K_i y'_ind + k)
+    const std::size_t d = cluster.dependent.size();
+    const std::size_t num_rows = static_cast<std::size_t>(cluster.num_rows);
+    for (std::size_t a = 0; a < d; ++a)
+    {
+      const int column_a = cluster.dependent[a];
+      for (std::size_t b = 0; b < d; ++b)
+      {
+        const int column_b = cluster.dependent[b];
+        double value = 0.0;
+        for (std::size_t e = 0; e < num_rows; ++e)
+        {
+          value += cluster.k_matrix[e * m + column_a] * cluster.k_matrix[e * m + column_b];
+        }
+        cluster.normal[a * d + b] = value;
+      }
+      for (std::size_t t = 0; t <= r; ++t)
+      {
+        double value = 0.0;
+        for (std::size_t e = 0; e < num_rows; ++e)
+        {
+          const double rhs = t < r ? cluster.k_matrix[e * m + cluster.independent[t]] : cluster.k_vector[e];
+          value += cluster.k_matrix[e * m + column_a] * rhs;
+        }
+        cluster.rhs[a * (r + 1) + t] = value;
+      }
+    }
+    if (!detail::choleskyFactor(cluster.normal.data(), static_cast<int>(d)))
+    {
+      throw std::runtime_error("Constraints of the cluster " + cluster.name + " are singular in this configuration");
+    }
+    for (std::size_t t = 0; t <= r; ++t)
+    {
+      detail::choleskySolve(cluster.normal.data(), static_cast<int>(d), cluster.rhs.data() + t, static_cast<int>(r + 1));
+    }
+    std::fill(cluster.basis.begin(), cluster.basis.end(), 0.0);
+    std::fill(cluster.basis_bias.begin(), cluster.basis_bias.end(), 0.0);
+    for (std::size_t t = 0; t < r; ++t)
+    {
+      cluster.basis[cluster.independent[t] * r + t] = 1.0;
+    }
+    for (std::size_t a = 0; a < d; ++a)
+    {
+      for (std::size_t t = 0; t < r; ++t)
+      {
+        cluster.basis[cluster.dependent[a] * r + t] = -cluster.rhs[a * (r + 1) + t];
+      }
+      cluster.basis_bias[cluster.dependent[a]] = -cluster.rhs[a * (r + 1) + r];
+    }
+
+    for (std::size_t e = 0; e < rows; ++e)
+    {
+      const double *jacobian_row = cluster.jacobian.data() + e * m;
+      for (std::size_t t = 0; t < r; ++t)
+      {
+        double value = 0.0;
+        for (std::size_t c = 0; c < m; ++c)
+        {
+          value += jacobian_row[c] * cluster.basis[c * r + t];
+        }
+        cluster.psi[e * r + t] = value;
+      }
+      double value = 0.0;
+      for (std::size_t c = 0; c < m; ++c)
+      {
+        value += jacobian_row[c] * cluster.basis_bias[c];
+      }
+      cluster.bias[e] += value;
+    }
+  };
+
+  /// U, D, u and the articulated inertia and bias force passed to the parent link
+  void backwardPass(ClusterData &cluster, const double *tau)
+  {
+    const std::size_t r = cluster.numIndependent();
+    const std::size_t num_members = cluster.links.size();
+
+    std::fill(cluster.d_matrix.begin(), cluster.d_matrix.end(), 0.0);
+    for (std::size_t t = 0; t < r; ++t)
+    {
+      // generalized force on the independent coordinates, G^T tau
+      double value = 0.0;
+      if (cluster.constraints.empty())
+      {
+        value = tau[cluster.coordinates[t]];
+      }
+      else
+      {
+        for (std::size_t c = 0; c < cluster.numColumns(); ++c)
+        {
+          value += cluster.basis[c * r + t] * tau[cluster.coordinates[c]];
+        }
+      }
+      cluster.u_vector[t] = value;
+    }
+
+    for (std::size_t l = 0; l < num_members; ++l)
+    {
+      const int i = cluster.links[l];
+      const double *inertia = &this->inertias_[36 * i];
+      const double *psi = cluster.psi.data() + 6 * l * r;
+      double *u_matrix = cluster.u_matrix.data() + 6 * l * r;
+      for (std::size_t t = 0; t < r; ++t)
+      {
+        double column[6], product[6];
+        for (int e = 0; e < 6; ++e)
+        {
+          column[e] = psi[e * r + t];
+        }
+        spatial::multiply(inertia, column, product);
+        for (int e = 0; e < 6; ++e)
+        {
+          u_matrix[e * r + t] = product[e];
+        }
+        cluster.u_vector[t] -= spatial::dot(column, &this->bias_forces_[6 * i]);
+      }
+      for (std::size_t a = 0; a < r; ++a)
+      {
+        for (std::size_t b = 0; b < r; ++b)
+        {
+          double value = 0.0;
+          for (int e = 0; e < 6; ++e)
+          {
+            value += psi[e * r + a] * u_matrix[e * r + b];
+          }
+          cluster.d_matrix[a * r + b] += value;
+        }
+      }
+    }
+    if (!detail::choleskyFactor(cluster.d_matrix.data(), static_cast<int>(r)))
+    {
+      throw std::runtime_error("Articulated inertia of the cluster " + cluster.name + " is singular");
+    }
+
+    if (cluster.parent_link < 0)
+    {
+      return;
+    }
+
+    // Ia = IA - U D^-1 U^T and pa = pA + Ia c + U D^-1 u, both summed over the
+    // members (B^T x B) and added to the parent link
+    std::fill(cluster.u_sum.begin(), cluster.u_sum.end(), 0.0);
+    double *parent_inertia = &this->inertias_[36 * cluster.parent_link];
+    double *parent_bias = &this->bias_forces_[6 * cluster.parent_link];
+    std::vector<double> &remaining = cluster.scratch;
+    std::copy(cluster.u_vector.begin(), cluster.u_vector.end(), remaining.begin());
+    for (std::size_t l = 0; l < num_members; ++l)
+    {
+      const int i = cluster.links[l];
+      const double *inertia = &this->inertias_[36 * i];
+      const double *c = cluster.bias.data() + 6 * l;
+      const double *u_matrix = cluster.u_matrix.data() + 6 * l * r;
+      double product[6];
+      spatial::multiply(inertia, c, product);
+      for (int e = 0; e < 6; ++e)
+      {
+        parent_bias[e] += this->bias_forces_[6 * i + e] + product[e];
+        for (std::size_t t = 0; t < r; ++t)
+        {
+          cluster.u_sum[e * r + t] += u_matrix[e * r + t];
+          remaining[t] -= u_matrix[e * r + t] * c[e];
+        }
+      }
+      for (int e = 0; e < 36; ++e)
+      {
+        parent_inertia[e] += inertia[e];
+      }
+    }
+    if (r == 0)
+    {
+      return;
+    }
+    for (int e = 0; e < 6; ++e)
+    {
+      for (std::size_t t = 0; t < r; ++t)
+      {
+        cluster.solved[t * 6 + e] = cluster.u_sum[e * r + t];
+      }
+      detail::choleskySolve(cluster.d_matrix.data(), static_cast<int>(r), cluster.solved.data() + e, 6);
+    }
+    detail::choleskySolve(cluster.d_matrix.data(), static_cast<int>(r), remaining.data());
+    for (int a = 0; a < 6; ++a)
+    {
+      for (std::size_t t = 0; t < r; ++t)
+      {
+        parent_bias[a] += cluster.u_sum[a * r + t] * remaining[t];
+      }
+      for (int b = 0; b < 6; ++b)
+      {
+        double value = 0.0;
+        for (std::size_t t = 0; t < r; ++t)
+        {
+          value += cluster.u_sum[a * r + t] * cluster.solved[t * 6 + b];
+        }
+        parent_inertia[6 * a + b] -= value;
+      }
+    }
+  };
+
+  /// accelerations of the members and the joint accelerations of the cluster
+  void forwardPass(ClusterData &cluster, const double *parent_acceleration, double *vdot)
+  {
+    const std::size_t m = cluster.numColumns();
+    const std::size_t r = cluster.numIndependent();
+    std::copy(cluster.u_vector.begin(), cluster.u_vector.end(), cluster.udot.begin());
+    for (std::size_t l = 0; l < cluster.links.size(); ++l)
+    {
+      double *acceleration = &this->accelerations_[6 * cluster.links[l]];
+      const double *u_matrix = cluster.u_matrix.data() + 6 * l * r;
+      for (int e = 0; e < 6; ++e)
+      {
+        acceleration[e] = parent_acceleration[e] + cluster.bias[6 * l + e];
+        for (std::size_t t = 0; t < r; ++t)
+        {
+          cluster.udot[t] -= u_matrix[e * r + t] * acceleration[e];
+        }
+      }
+    }
+    detail::choleskySolve(cluster.d_matrix.data(), static_cast<int>(r), cluster.udot.data());
+    for (std::size_t l = 0; l < cluster.links.size(); ++l)
+    {
+      double *acceleration = &this->accelerations_[6 * cluster.links[l]];
+      const double *psi = cluster.psi.data() + 6 * l * r;
+      for (int e = 0; e < 6; ++e)
+      {
+        for (std::size_t t = 0; t < r; ++t)
+        {
+          acceleration[e] += psi[e * r + t] * cluster.udot[t];
+        }
+      }
+    }
+    for (std::size_t c = 0; c < m; ++c)
+    {
+      double value;
+      if (cluster.constraints.empty())
+      {
+        value = cluster.udot[c];
+      }
+      else
+      {
+        value = cluster.basis_bias[c];
+        for (std::size_t t = 0; t < r; ++t)
+        {
+          value += cluster.basis[c * r + t] * cluster.udot[t];
+        }
+      }
+      vdot[cluster.coordinates[c]] = value;
+    }
+  };
+
+  ForwardKinematics kinematics_;
+  std::size_t num_velocities_;
+
+  std::vector<int> link_parent_;
+  std::vector<Inertial> link_inertial_;
+  /// type of the parent joint, FIXED for joints without coordinates
+  std::vector<int> link_joint_type_;
+  std::vector<int> link_q_offset_;
+  std::vector<int> link_v_offset_;
+  std::vector<int> link_nv_;
+  std::vector<Vector3> link_axis_;
+  std::vector<Vector3> link_plane_x_;
+  std::vector<Vector3> link_plane_y_;
+
+  std::vector<ClusterData> clusters_;
+
+  std::vector<Pose> poses_;
+  std::vector<double> velocities_;
+  std::vector<double> accelerations_;
+  /// articulated inertias and bias forces, rigid body terms until the backward pass
+  std::vector<double> inertias_;
+  std::vector<double> bias_forces_;
+};
+
+}
+
+#endif
@@ -0,0 +1,277 @@
+/* Forward kinematics over a CompiledModel */
+
+#ifndef URDF_INTERFACE_FORWARD_KINEMATICS_H
+#define URDF_INTERFACE_FORWARD_KINEMATICS_H
+
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <urdf_model/compiled_model.h>
+#include <urdf_model/joint.h>
+#include <urdf_model/pose.h>
+#include <urdf_exception/exception.h>
+
+namespace urdf{
+
+/// \brief Unit vectors e1, e2 spanning the plane of a PLANAR joint with unit normal n
+///
+/// (e1, e2, n) is right handed; the x and y coordinates of the joint are
+/// measured along e1 and e2.
+inline void planarBasis(const Vector3 &normal, Vector3 &e1, Vector3 &e2)
+{
+  const Vector3 reference = std::fabs(normal.x) < 0.9 ? Vector3(1.0, 0.0, 0.0) : Vector3(0.0, 1.0, 0.0);
+  e1 = reference - normal * reference.dot(normal);
+  e1 = e1 / e1.norm();
+  e2 = normal.cross(e1);
+}
+
+/// \brief Transform from the joint frame to the child link frame
+///
+/// axis must be a unit vector, e1 and e2 are only used by PLANAR joints (see
+/// planarBasis()) and q points at the CompiledModel::jointNumPositions(type)
+/// positions of the joint.
+inline Pose jointMotion(int type, const Vector3 &axis, const Vector3 &e1, const Vector3 &e2, const double *q)
+{
+  switch (type)
+  {
+    case Joint::REVOLUTE:
+    case Joint::CONTINUOUS:
+    {
+      const double s = std::sin(0.5 * q[0]);
+      return Pose(Vector3(), Rotation(axis.x * s, axis.y * s, axis.z * s, std::cos(0.5 * q[0])));
+    }
+    case Joint::PRISMATIC:
+      return Pose(axis * q[0], Rotation());
+    case Joint::PLANAR:
+    {
+      const double s = std::sin(0.5 * q[2]);
+      return Pose(e1 * q[0] + e2 * q[1], Rotation(axis.x * s, axis.y * s, axis.z * s, std::cos(0.5 * q[2])));
+    }
+    case Joint::FLOATING:
+    {
+      Rotation rotation;
+      rotation.setFromQuaternion(q[3], q[4], q[5], q[6]);
+      return Pose(Vector3(q[0], q[1], q[2]), rotation);
+    }
+    default:
+      return Pose();
+  }
+}
+
+/// \brief World frame poses of all links of a CompiledModel
+///
+/// init() flattens the kinematic tree into one step per link.  Chains of
+/// fixed joints are folded into a single constant transform, so the pose of
+/// link i is
+///
+///   world(i) = world(anchor(i)) * origin(i) * jointMotion(q)
+///
+/// where anchor(i) is the nearest ancestor that is the root or the child of
+/// a moving joint.  Links are in preorder, so update() is one forward pass
+/// over the steps and never allocates.  The root link is at the identity.
+///
+/// updateIncremental() compares q with the positions of the previous update
+/// and only recomputes the subtrees below joints that changed.  Subtrees are
+/// contiguous link ranges (CompiledModel::subtree_end), getDirtyRanges()
+/// reports the ranges that were recomputed so caches downstream of the link
+/// poses can be refreshed lazily.
+///
+/// q is indexed like CompiledModel::joint_q_offset.
+class ForwardKinematics
+{
+public:
+  ForwardKinematics() { this->clear(); };
+  explicit ForwardKinematics(const CompiledModel &model) { this->init(model); };
+
+  std::size_t getNumLinks() const { return this->steps_.size(); };
+  std::size_t getNumPositions() const { return this->num_positions_; };
+
+  void init(const CompiledModel &model)
+  {
+    this->clear();
+    const std::size_t num_links = model.getNumLinks();
+    this->steps_.resize(num_links);
+    this->link_poses_.resize(num_links);
+    this->num_positions_ = model.getNumPositions();
+    this->q_.resize(this->num_positions_);
+    this->subtree_end_ = model.subtree_end;
+
+    // body[i] is the link i is rigidly attached to, offset[i] its pose in that link's frame
+    std::vector<int> body(num_links, 0);
+    std::vector<Pose> offset(num_links);
+    for (std::size_t i = 1; i < num_links; ++i)
+    {
+      const int parent = model.link_parent[i];
+      const int joint = model.link_parent_joint[i];
+      Step &step = this->steps_[i];
+      step.anchor = body[parent];
+      step.origin = offset[parent] * model.joint_origin[joint];
+      step.type = model.joint_nq[joint] > 0 ? model.joint_type[joint] : static_cast<int>(Joint::FIXED);
+      step.q_offset = model.joint_q_offset[joint];
+      step.nq = model.joint_nq[joint];
+
+      if (step.type == Joint::FIXED)
+      {
+        body[i] = step.anchor;
+        offset[i] = step.origin;
+        continue;
+      }
+      body[i] = static_cast<int>(i);
+      if (step.type != Joint::FLOATING)
+      {
+        const double norm = model.joint_axis[joint].norm();
+        if (!(norm > 0.0))
+        {
+          throw ParseError("Joint [" + std::string(model.joint_names[joint]) + "] has a zero axis");
+        }
+        step.axis = model.joint_axis[joint] / norm;
+      }
+      if (step.type == Joint::PLANAR)
+      {
+        planarBasis(step.axis, step.plane_x, step.plane_y);
+      }
+    }
+  };
+
+  /// recompute getLinkPoses() for joint positions q, all links become dirty
+  void update(const double *q)
+  {
+    this->compute(q, this->link_poses_.data());
+    if (this->num_positions_ > 0)
+    {
+      std::memcpy(this->q_.data(), q, this->num_positions_ * sizeof(double));
+    }
+    this->dirty_ranges_.clear();
+    if (!this->steps_.empty())
+    {
+      this->dirty_ranges_.push_back(std::make_pair(0, static_cast<int>(this->steps_.size())));
+    }
+    this->valid_ = true;
+  };
+
+  /// \brief recompute only the links below joints whose positions changed since the last update
+  ///
+  /// Positions are compared bit for bit.  Falls back to update() if there
+  /// was no previous update or after invalidate().  Returns the number of
+  /// links recomputed.
+  std::size_t updateIncremental(const double *q)
+  {
+    if (!this->valid_)
+    {
+      this->update(q);
+      return this->steps_.size();
+    }
+    this->dirty_ranges_.clear();
+    std::size_t num_dirty = 0;
+    const std::size_t num_links = this->steps_.size();
+    for (std::size_t i = 1; i < num_links;)
+    {
+      const Step &step = this->steps_[i];
+      if (step.nq == 0 ||
+          std::memcmp(this->q_.data() + step.q_offset, q + step.q_offset, step.nq * sizeof(double)) == 0)
+      {
+        ++i;
+        continue;
+      }
+      // every joint inside the subtree is covered as well, check them for
+      // the next update and skip past the subtree
+      const int end = this->subtree_end_[i];
+      const int q_begin = step.q_offset;
+      const int q_end = end < static_cast<int>(num_links) ? this->steps_[end].q_offset :
+                        static_cast<int>(this->num_positions_);
+      std::memcpy(this->q_.data() + q_begin, q + q_begin, (q_end - q_begin) * sizeof(double));
+      this->computeRange(q, this->link_poses_.data(), i, end);
+      if (!this->dirty_ranges_.empty() && this->dirty_ranges_.back().second == static_cast<int>(i))
+      {
+        this->dirty_ranges_.back().second = end;
+      }
+      else
+      {
+        this->dirty_ranges_.push_back(std::make_pair(static_cast<int>(i), end));
+      }
+      num_dirty += end - i;
+      i = end;
+    }
+    return num_dirty;
+  };
+
+  /// make the next updateIncremental() recompute every link
+  void invalidate() { this->valid_ = false; };
+
+  /// \brief links recomputed by the last update, as disjoint, ascending [begin, end) ranges
+  const std::vector<std::pair<int, int> > &getDirtyRanges() const { return this->dirty_ranges_; };
+
+  /// write the world pose of every link to out[0 .. getNumLinks())
+  void compute(const double *q, Pose *out) const
+  {
+    if (this->steps_.empty())
+    {
+      return;
+    }
+    out[0] = Pose();
+    this->computeRange(q, out, 1, this->steps_.size());
+  };
+
+  /// world pose of link i as of the last update()
+  const Pose &getLinkPose(int i) const { return this->link_poses_[i]; };
+  const std::vector<Pose> &getLinkPoses() const { return this->link_poses_; };
+
+  void clear()
+  {
+    this->steps_.clear();
+    this->link_poses_.clear();
+    this->num_positions_ = 0;
+    this->q_.clear();
+    this->subtree_end_.clear();
+    this->dirty_ranges_.clear();
+    this->valid_ = false;
+  };
+
+private:
+  struct Step
+  {
+    Step() : anchor(-1), type(Joint::FIXED), q_offset(0), nq(0) {}
+    int anchor;
+    int type;
+    int q_offset;
+    int nq;
+    Pose origin;
+    Vector3 axis;
+    Vector3 plane_x;
+    Vector3 plane_y;
+  };
+
+  /// recompute links [begin, end), their anchors must be up to date
+  void computeRange(const double *q, Pose *out, std::size_t begin, std::size_t end) const
+  {
+    for (std::size_t i = begin; i < end; ++i)
+    {
+      const Step &step = this->steps_[i];
+      if (step.type == Joint::FIXED)
+      {
+        out[i] = out[step.anchor] * step.origin;
+      }
+      else
+      {
+        out[i] = out[step.anchor] * (step.origin *
+                 jointMotion(step.type, step.axis, step.plane_x, step.plane_y, q + step.q_offset));
+      }
+    }
+  };
+
+  std::vector<Step> steps_;
+  std::vector<Pose> link_poses_;
+  std::size_t num_positions_;
+
+  /// positions of the last update
+  std::vector<double> q_;
+  std::vector<int> subtree_end_;
+  std::vector<std::pair<int, int> > dirty_ranges_;
+  bool valid_;
+};
+
+}
+
+#endif
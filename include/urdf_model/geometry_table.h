@@ -0,0 +1,260 @@
+/* Value type geometry and packed per model geometry tables */
+
+#ifndef URDF_INTERFACE_GEOMETRY_TABLE_H
+#define URDF_INTERFACE_GEOMETRY_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include <urdf_model/compiled_model.h>
+#include <urdf_model/link.h>
+#include <urdf_model/name_index.h>
+#include <urdf_model/pose.h>
+#include <urdf_exception/exception.h>
+
+namespace urdf{
+
+struct SphereShape
+{
+  double radius;
+};
+
+struct BoxShape
+{
+  Vector3 dim;
+};
+
+/// along the z axis of its frame
+struct CylinderShape
+{
+  double radius;
+  double length;
+};
+
+struct MeshShape
+{
+  std::string filename;
+  Vector3 scale;
+};
+
+/// \brief Geometry by value, the alternative index is the Geometry type
+typedef std::variant<SphereShape, BoxShape, CylinderShape, MeshShape> Shape;
+
+static_assert(std::is_same<std::variant_alternative_t<Geometry::SPHERE, Shape>, SphereShape>::value &&
+              std::is_same<std::variant_alternative_t<Geometry::BOX, Shape>, BoxShape>::value &&
+              std::is_same<std::variant_alternative_t<Geometry::CYLINDER, Shape>, CylinderShape>::value &&
+              std::is_same<std::variant_alternative_t<Geometry::MESH, Shape>, MeshShape>::value,
+              "Shape alternatives must follow the Geometry types");
+
+/// \brief Shape of a Geometry, throws ParseError if its type does not match its class
+inline Shape toShape(const Geometry &geometry)
+{
+  switch (geometry.type)
+  {
+    case Geometry::SPHERE:
+      if (const Sphere *sphere = dynamic_cast<const Sphere *>(&geometry))
+      {
+        return SphereShape{sphere->radius};
+      }
+      break;
+    case Geometry::BOX:
+      if (const Box *box = dynamic_cast<const Box *>(&geometry))
+      {
+        return BoxShape{box->dim};
+      }
+      break;
+    case Geometry::CYLINDER:
+      if (const Cylinder *cylinder = dynamic_cast<const Cylinder *>(&geometry))
+      {
+        return CylinderShape{cylinder->radius, cylinder->length};
+      }
+      break;
+    case Geometry::MESH:
+      if (const Mesh *mesh = dynamic_cast<const Mesh *>(&geometry))
+      {
+        return MeshShape{mesh->filename, mesh->scale};
+      }
+      break;
+  }
+  throw ParseError("Geometry of type " + std::to_string(static_cast<int>(geometry.type)) +
+                   " is not an instance of the matching class");
+}
+
+/// \brief The visual or collision geometry of a CompiledModel, packed by type
+///
+/// init() takes the elements of every link (Link::collision_array or
+/// Link::visual_array, or the single Link::collision or Link::visual when
+/// the array is empty) and skips those without geometry.  Entries are
+/// grouped by type, spheres first, then boxes, cylinders and meshes, each
+/// group in link order, so entries typeBegin(t) .. typeEnd(t) - 1 all have
+/// type t and their parameters are one contiguous run of the per type
+/// arrays, at index entry - typeBegin(t).
+///
+/// Every Geometry is cast once, in init(); loops over the table only read
+/// plain arrays.  source_geometries keeps the original objects for callers
+/// that need them.
+class GeometryTable
+{
+public:
+  enum Source
+  {
+    COLLISION,
+    VISUAL
+  };
+
+  static const int NUM_TYPES = 4;
+
+  GeometryTable() { this->clear(); };
+  explicit GeometryTable(const CompiledModel &model, Source source = COLLISION) { this->init(model, source); };
+
+  std::size_t size() const { return this->entry_link.size(); };
+
+  int typeBegin(int type) const { return this->type_offsets[type]; };
+  int typeEnd(int type) const { return this->type_offsets[type + 1]; };
+
+  void init(const CompiledModel &model, Source source = COLLISION)
+  {
+    this->clear();
+    struct Element
+    {
+      int type;
+      int link;
+      const Pose *origin;
+      const std::string *name;
+      GeometryConstSharedPtr geometry;
+    };
+    std::vector<Element> elements;
+    auto add = [&elements](int link, const Pose &origin, const std::string &name, const GeometrySharedPtr &geometry)
+    {
+      if (geometry)
+      {
+        elements.push_back(Element{geometry->type, link, &origin, &name, geometry});
+      }
+    };
+    for (std::size_t i = 0; i < model.getNumLinks(); ++i)
+    {
+      const Link &link = *model.source_links[i];
+      const int index = static_cast<int>(i);
+      if (source == COLLISION)
+      {
+        if (link.collision_array.empty() && link.collision)
+        {
+          add(index, link.collision->origin, link.collision->name, link.collision->geometry);
+        }
+        for (const CollisionSharedPtr &collision : link.collision_array)
+        {
+          add(index, collision->origin, collision->name, collision->geometry);
+        }
+      }
+      else
+      {
+        if (link.visual_array.empty() && link.visual)
+        {
+          add(index, link.visual->origin, link.visual->name, link.visual->geometry);
+        }
+        for (const VisualSharedPtr &visual : link.visual_array)
+        {
+          add(index, visual->origin, visual->name, visual->geometry);
+        }
+      }
+    }
+    std::stable_sort(elements.begin(), elements.end(),
+                     [](const Element &a, const Element &b) { return a.type < b.type; });
+
+    this->entry_link.reserve(elements.size());
+    this->entry_origin.reserve(elements.size());
+    this->entry_type.reserve(elements.size());
+    this->source_geometries.reserve(elements.size());
+    for (const Element &element : elements)
+    {
+      const Shape shape = toShape(*element.geometry);
+      this->entry_link.push_back(element.link);
+      this->entry_origin.push_back(*element.origin);
+      this->entry_type.push_back(static_cast<std::uint8_t>(element.type));
+      this->entry_names.push_back(*element.name);
+      this->source_geometries.push_back(element.geometry);
+      this->type_offsets[element.type + 1]++;
+      switch (element.type)
+      {
+        case Geometry::SPHERE:
+          this->sphere_radius.push_back(std::get<SphereShape>(shape).radius);
+          break;
+        case Geometry::BOX:
+          this->box_dim.push_back(std::get<BoxShape>(shape).dim);
+          break;
+        case Geometry::CYLINDER:
+          this->cylinder_radius.push_back(std::get<CylinderShape>(shape).radius);
+          this->cylinder_length.push_back(std::get<CylinderShape>(shape).length);
+          break;
+        case Geometry::MESH:
+          this->mesh_filenames.push_back(std::get<MeshShape>(shape).filename);
+          this->mesh_scale.push_back(std::get<MeshShape>(shape).scale);
+          break;
+      }
+    }
+    for (int type = 0; type < NUM_TYPES; ++type)
+    {
+      this->type_offsets[type + 1] += this->type_offsets[type];
+    }
+  };
+
+  /// shape of entry e by value
+  Shape getShape(std::size_t e) const
+  {
+    const int type = this->entry_type[e];
+    const std::size_t k = e - this->type_offsets[type];
+    switch (type)
+    {
+      case Geometry::SPHERE:
+        return SphereShape{this->sphere_radius[k]};
+      case Geometry::BOX:
+        return BoxShape{this->box_dim[k]};
+      case Geometry::CYLINDER:
+        return CylinderShape{this->cylinder_radius[k], this->cylinder_length[k]};
+      default:
+        return MeshShape{std::string(this->mesh_filenames[k]), this->mesh_scale[k]};
+    }
+  };
+
+  void clear()
+  {
+    this->entry_link.clear();
+    this->entry_origin.clear();
+    this->entry_type.clear();
+    this->entry_names.clear();
+    this->source_geometries.clear();
+    std::fill(this->type_offsets, this->type_offsets + NUM_TYPES + 1, 0);
+    this->sphere_radius.clear();
+    this->box_dim.clear();
+    this->cylinder_radius.clear();
+    this->cylinder_length.clear();
+    this->mesh_filenames.clear();
+    this->mesh_scale.clear();
+  };
+
+  /// link index, origin in the link frame, Geometry type and name of every entry
+  std::vector<int> entry_link;
+  std::vector<Pose> entry_origin;
+  std::vector<std::uint8_t> entry_type;
+  StringTable entry_names;
+  std::vector<GeometryConstSharedPtr> source_geometries;
+
+  /// entries of type t are type_offsets[t] .. type_offsets[t + 1] - 1
+  int type_offsets[NUM_TYPES + 1];
+
+  /// per type parameters, one per entry of that type
+  std::vector<double> sphere_radius;
+  std::vector<Vector3> box_dim;
+  std::vector<double> cylinder_radius;
+  std::vector<double> cylinder_length;
+  StringTable mesh_filenames;
+  std::vector<Vector3> mesh_scale;
+};
+
+}
+
+#endif
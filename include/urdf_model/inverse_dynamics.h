@@ -0,0 +1,635 @@
+/* Recursive Newton-Euler inverse dynamics over a CompiledModel */
+
+#ifndef URDF_INTERFACE_INVERSE_DYNAMICS_H
+#define URDF_INTERFACE_INVERSE_DYNAMICS_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <urdf_model/compiled_model.h>
+#include <urdf_model/forward_kinematics.h>
+#include <urdf_model/joint.h>
+#include <urdf_model/spatial.h>
+
+namespace urdf{
+
+namespace detail{
+
+/// \brief sine and cosine of W angles in a loop the compiler can vectorize
+///
+/// Reduction by multiples of pi/2 in three parts (as in fdlibm) and the
+/// fdlibm kernel polynomials, within an ulp of std::sin and std::cos.  The
+/// reduction is exact for |x| up to 1e6; larger or non finite angles take
+/// std::sin and std::cos.
+template <int W>
+inline void sinCos(const double *x, double *sine, double *cosine)
+{
+  const double two_over_pi = 0.63661977236758134308;
+  const double pio2_1 = 1.57079632673412561417e+00;
+  const double pio2_2 = 6.07710050630396597660e-11;
+  const double pio2_3 = 2.02226624879595063154e-21;
+  // adding and subtracting 1.5 * 2^52 rounds to the nearest integer
+  const double round = 6755399441055744.0;
+  for (int s = 0; s < W; ++s)
+  {
+    const double k = (x[s] * two_over_pi + round) - round;
+    const double r = ((x[s] - k * pio2_1) - k * pio2_2) - k * pio2_3;
+    const double z = r * r;
+    const double sin_r = r + r * z * (-1.66666666666666324348e-01 + z * (8.33333333332248946124e-03 +
+                         z * (-1.98412698298579493134e-04 + z * (2.75573137070700676789e-06 +
+                         z * (-2.50507602534068634195e-08 + z * 1.58969099521155010221e-10)))));
+    const double cos_r = 1.0 - 0.5 * z + z * z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03 +
+                         z * (2.48015872894767294178e-05 + z * (-2.75573143513906633035e-07 +
+                         z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11)))));
+    // quadrant k mod 4 from floor(k / 2) and floor(k / 4)
+    const double odd = k - 2.0 * (((k * 0.5 - 0.25) + round) - round);
+    const double quadrant = k - 4.0 * (((k * 0.25 - 0.375) + round) - round);
+    const double s0 = odd != 0.0 ? cos_r : sin_r;
+    const double c0 = odd != 0.0 ? sin_r : cos_r;
+    sine[s] = quadrant >= 2.0 ? -s0 : s0;
+    cosine[s] = (quadrant == 1.0 || quadrant == 2.0) ? -c0 : c0;
+  }
+  // kept out of the loop above, which would not vectorize with it
+  for (int s = 0; s < W; ++s)
+  {
+    if (!(std::fabs(x[s]) <= 1e6))
+    {
+      sine[s] = std::sin(x[s]);
+      cosine[s] = std::cos(x[s]);
+    }
+  }
+}
+
+}
+
+/// \brief Joint forces for given positions, velocities and accelerations
+///
+/// The recursive Newton-Euler algorithm in link coordinates: velocities and
+/// accelerations are propagated from the root to the leaves, then the link
+/// forces are summed back from the leaves to the root and projected onto
+/// the joint motion subspaces.  Joint friction is
+///
+///   damping * v + friction * sign(v)
+///
+/// per coordinate, from Joint::dynamics.  Loop and coupling constraints are
+/// not applied, the result is for the spanning tree coordinates.  The root
+/// link is fixed in the world.
+///
+/// computeBatch() evaluates many samples in one call.  Samples are taken
+/// BLOCK_SIZE at a time and every quantity of a block is stored as an array
+/// over its samples, so all the arithmetic of a link, joint sines and
+/// cosines included, is a sequence of fixed length loops over samples the
+/// compiler can vectorize.  The vector width is whatever the compiler
+/// targets, build with e.g. -march=native to get more than SSE2.  The link
+/// data needed per block stays in cache for models of a few hundred links.
+///
+/// Nothing allocates after init(), so one object must not be used by several
+/// threads at once.
+class InverseDynamics
+{
+public:
+  static constexpr int BLOCK_SIZE = 16;
+
+  InverseDynamics() { this->clear(); };
+  explicit InverseDynamics(const CompiledModel &model) { this->init(model); };
+
+  /// gravitational acceleration in world coordinates, (0, 0, -9.81) by default
+  Vector3 gravity;
+
+  std::size_t getNumLinks() const { return this->bodies_.size(); };
+  std::size_t getNumPositions() const { return this->num_positions_; };
+  std::size_t getNumVelocities() const { return this->num_velocities_; };
+
+  void init(const CompiledModel &model)
+  {
+    this->clear();
+    const int num_links = static_cast<int>(model.getNumLinks());
+    this->num_positions_ = model.getNumPositions();
+    this->num_velocities_ = model.getNumVelocities();
+    this->bodies_.resize(num_links);
+    for (int i = 0; i < num_links; ++i)
+    {
+      Body &body = this->bodies_[i];
+      const Inertial &inertial = model.link_inertial[i];
+      double inertia[36];
+      spatial::worldInertia(inertial, Pose(), inertia);
+      body.mass = inertial.mass;
+      body.first_moment = inertial.origin.position * inertial.mass;
+      body.rotational[0] = inertia[0];
+      body.rotational[1] = inertia[7];
+      body.rotational[2] = inertia[14];
+      body.rotational[3] = inertia[1];
+      body.rotational[4] = inertia[2];
+      body.rotational[5] = inertia[8];
+      if (i == 0)
+      {
+        continue;
+      }
+
+      const int joint = model.link_parent_joint[i];
+      body.parent = model.link_parent[i];
+      body.type = model.joint_nv[joint] > 0 ? model.joint_type[joint] : static_cast<int>(Joint::FIXED);
+      body.q_offset = model.joint_q_offset[joint];
+      body.v_offset = model.joint_v_offset[joint];
+      spatial::rotationMatrix(model.joint_origin[joint].rotation, body.origin_rotation);
+      body.origin_position = model.joint_origin[joint].position;
+      if (body.type != Joint::FIXED && body.type != Joint::FLOATING)
+      {
+        const double norm = model.joint_axis[joint].norm();
+        if (!(norm > 0.0))
+        {
+          throw ParseError("Joint [" + std::string(model.joint_names[joint]) + "] has a zero axis");
+        }
+        body.axis = model.joint_axis[joint] / norm;
+      }
+      if (body.type == Joint::PLANAR)
+      {
+        planarBasis(body.axis, body.plane_x, body.plane_y);
+      }
+      const JointDynamicsSharedPtr &dynamics = model.source_joints[joint]->dynamics;
+      if (dynamics)
+      {
+        body.damping = dynamics->damping;
+        body.friction = dynamics->friction;
+      }
+    }
+    this->workspace_.assign(num_links * FIELDS * BLOCK_SIZE, 0.0);
+    this->block_input_.assign((this->num_positions_ + 2 * this->num_velocities_) * BLOCK_SIZE, 0.0);
+    this->block_output_.assign(this->num_velocities_ * BLOCK_SIZE, 0.0);
+  };
+
+  /// joint forces tau for one sample, all arrays in the CompiledModel coordinate layout
+  void compute(const double *q, const double *v, const double *a, double *tau)
+  {
+    this->computeBlock<1>(q, v, a, tau);
+  };
+
+  /// \brief joint forces of num_samples samples
+  ///
+  /// Arrays are coordinate major: coordinate k of sample s is at
+  /// k * num_samples + s, in q as in v, a and tau.
+  void computeBatch(std::size_t num_samples, const double *q, const double *v, const double *a, double *tau)
+  {
+    const std::size_t nq = this->num_positions_;
+    const std::size_t nv = this->num_velocities_;
+    double *block_q = this->block_input_.data();
+    double *block_v = block_q + nq * BLOCK_SIZE;
+    double *block_a = block_v + nv * BLOCK_SIZE;
+    double *block_tau = this->block_output_.data();
+    for (std::size_t begin = 0; begin < num_samples; begin += BLOCK_SIZE)
+    {
+      // a short last block repeats its last sample, so every lane holds valid positions
+      const std::size_t count = std::min<std::size_t>(BLOCK_SIZE, num_samples - begin);
+      gatherBlock(q + begin, num_samples, nq, count, block_q);
+      gatherBlock(v + begin, num_samples, nv, count, block_v);
+      gatherBlock(a + begin, num_samples, nv, count, block_a);
+      this->computeBlock<BLOCK_SIZE>(block_q, block_v, block_a, block_tau);
+      for (std::size_t k = 0; k < nv; ++k)
+      {
+        std::copy(block_tau + k * BLOCK_SIZE, block_tau + k * BLOCK_SIZE + count, tau + k * num_samples + begin);
+      }
+    }
+  };
+
+  void clear()
+  {
+    this->gravity = Vector3(0.0, 0.0, -9.81);
+    this->num_positions_ = 0;
+    this->num_velocities_ = 0;
+    this->bodies_.clear();
+    this->workspace_.clear();
+    this->block_input_.clear();
+    this->block_output_.clear();
+  };
+
+private:
+  struct Body
+  {
+    Body() : parent(-1), type(Joint::FIXED), q_offset(0), v_offset(0), origin_rotation{1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0},
+             mass(0.0), rotational{0.0, 0.0, 0.0, 0.0, 0.0, 0.0}, damping(0.0), friction(0.0) {}
+    int parent;
+    /// FIXED for joints without velocity coordinates
+    int type;
+    int q_offset;
+    int v_offset;
+    /// parent joint origin, row major rotation
+    double origin_rotation[9];
+    Vector3 origin_position;
+    Vector3 axis;
+    Vector3 plane_x;
+    Vector3 plane_y;
+    /// inertia about the link origin in link coordinates: mass, mass times
+    /// center of mass and the rotational inertia xx, yy, zz, xy, xz, yz
+    double mass;
+    Vector3 first_moment;
+    double rotational[6];
+    double damping;
+    double friction;
+  };
+
+  /// \brief per link arrays of W samples
+  ///
+  /// The rotation (row major) and translation of the link frame in its
+  /// parent's frame, then the spatial velocity, acceleration and force in
+  /// link coordinates.
+  enum Field { ROTATION = 0, TRANSLATION = 9, VELOCITY = 12, ACCELERATION = 18, FORCE = 24, FIELDS = 30 };
+
+  double *field(int link, int f, int width) { return this->workspace_.data() + (link * FIELDS + f) * width; };
+
+  /// copy count samples of num_rows coordinates into rows of BLOCK_SIZE, repeating the last sample
+  static void gatherBlock(const double *in, std::size_t stride, std::size_t num_rows, std::size_t count, double *out)
+  {
+    for (std::size_t k = 0; k < num_rows; ++k)
+    {
+      const double *row = in + k * stride;
+      std::copy(row, row + count, out + k * BLOCK_SIZE);
+      std::fill(out + k * BLOCK_SIZE + count, out + (k + 1) * BLOCK_SIZE, row[count - 1]);
+    }
+  };
+
+  /// \brief W samples at once, coordinate k of sample s at k * W + s
+  ///
+  /// W is a compile time constant so every loop over samples has a fixed
+  /// trip count, W = 1 keeps the workspace of a single sample compact.
+  template <int W>
+  void computeBlock(const double *q, const double *v, const double *a, double *tau)
+  {
+    const int num_links = static_cast<int>(this->bodies_.size());
+    if (num_links == 0)
+    {
+      return;
+    }
+    // joint motion and joint velocity and acceleration terms of the current link
+    double motion[12 * W];
+    double joint_velocity[6 * W];
+    double joint_acceleration[6 * W];
+
+    double *root_acceleration = this->field(0, ACCELERATION, W);
+    std::fill(root_acceleration, root_acceleration + 3 * W, 0.0);
+    std::fill(root_acceleration + 3 * W, root_acceleration + 4 * W, -this->gravity.x);
+    std::fill(root_acceleration + 4 * W, root_acceleration + 5 * W, -this->gravity.y);
+    std::fill(root_acceleration + 5 * W, root_acceleration + 6 * W, -this->gravity.z);
+    std::fill(this->field(0, VELOCITY, W), this->field(0, VELOCITY, W) + 6 * W, 0.0);
+    std::fill(this->field(0, FORCE, W), this->field(0, FORCE, W) + 6 * W, 0.0);
+
+    for (int i = 1; i < num_links; ++i)
+    {
+      const Body &body = this->bodies_[i];
+      jointTerms<W>(body, q + body.q_offset * W, v + body.v_offset * W, a + body.v_offset * W,
+                    motion, joint_velocity, joint_acceleration);
+
+      // rotation and translation of the link in its parent, R = R0 Rq, r = p0 + R0 tq
+      double *rotation = this->field(i, ROTATION, W);
+      double *translation = this->field(i, TRANSLATION, W);
+      const double *r0 = body.origin_rotation;
+      const double p0[3] = {body.origin_position.x, body.origin_position.y, body.origin_position.z};
+      for (int row = 0; row < 3; ++row)
+      {
+        for (int col = 0; col < 3; ++col)
+        {
+          for (int s = 0; s < W; ++s)
+          {
+            rotation[(3 * row + col) * W + s] = r0[3 * row] * motion[col * W + s] +
+              r0[3 * row + 1] * motion[(3 + col) * W + s] + r0[3 * row + 2] * motion[(6 + col) * W + s];
+          }
+        }
+        for (int s = 0; s < W; ++s)
+        {
+          translation[row * W + s] = p0[row] + r0[3 * row] * motion[9 * W + s] +
+            r0[3 * row + 1] * motion[10 * W + s] + r0[3 * row + 2] * motion[11 * W + s];
+        }
+      }
+
+      double *velocity = this->field(i, VELOCITY, W);
+      double *acceleration = this->field(i, ACCELERATION, W);
+      transformMotion<W>(rotation, translation, this->field(body.parent, VELOCITY, W), velocity);
+      transformMotion<W>(rotation, translation, this->field(body.parent, ACCELERATION, W), acceleration);
+      for (int e = 0; e < 6 * W; ++e)
+      {
+        velocity[e] += joint_velocity[e];
+      }
+      // a = X a_parent + S a_joint + c_joint + v x v_joint
+      addJointAcceleration<W>(velocity, joint_velocity, joint_acceleration, acceleration);
+      bodyForce<W>(body, velocity, acceleration, this->field(i, FORCE, W));
+    }
+
+    for (int i = num_links - 1; i > 0; --i)
+    {
+      const Body &body = this->bodies_[i];
+      const double *force = this->field(i, FORCE, W);
+      projectForce<W>(body, q + body.q_offset * W, v + body.v_offset * W, force, tau + body.v_offset * W);
+      addParentForce<W>(this->field(i, ROTATION, W), this->field(i, TRANSLATION, W), force,
+                        this->field(body.parent, FORCE, W));
+    }
+  };
+
+  /// \brief per joint terms
+  ///
+  /// motion: rotation Rq (row major) and translation tq of the joint,
+  /// joint_velocity: S v, joint_acceleration: S a + c_joint with S in
+  /// link coordinates.
+  template <int W>
+  static void jointTerms(const Body &body, const double *q, const double *v, const double *a,
+                         double *motion, double *joint_velocity, double *joint_acceleration)
+  {
+    std::fill(motion, motion + 12 * W, 0.0);
+    std::fill(joint_velocity, joint_velocity + 6 * W, 0.0);
+    std::fill(joint_acceleration, joint_acceleration + 6 * W, 0.0);
+    const double axis[3] = {body.axis.x, body.axis.y, body.axis.z};
+    switch (body.type)
+    {
+      case Joint::REVOLUTE:
+      case Joint::CONTINUOUS:
+        axisRotation<W>(axis, q, motion);
+        for (int c = 0; c < 3; ++c)
+        {
+          for (int s = 0; s < W; ++s)
+          {
+            joint_velocity[c * W + s] = axis[c] * v[s];
+            joint_acceleration[c * W + s] = axis[c] * a[s];
+          }
+        }
+        break;
+      case Joint::PRISMATIC:
+        for (int c = 0; c < 3; ++c)
+        {
+          std::fill(motion + 4 * c * W, motion + (4 * c + 1) * W, 1.0);
+          for (int s = 0; s < W; ++s)
+          {
+            motion[(9 + c) * W + s] = axis[c] * q[s];
+            joint_velocity[(3 + c) * W + s] = axis[c] * v[s];
+            joint_acceleration[(3 + c) * W + s] = axis[c] * a[s];
+          }
+        }
+        break;
+      case Joint::PLANAR:
+      {
+        const double e1[3] = {body.plane_x.x, body.plane_x.y, body.plane_x.z};
+        const double e2[3] = {body.plane_y.x, body.plane_y.y, body.plane_y.z};
+        const double *angle = q + 2 * W;
+        axisRotation<W>(axis, angle, motion);
+        const double *vx = v, *vy = v + W, *vt = v + 2 * W;
+        const double *ax = a, *ay = a + W, *at = a + 2 * W;
+        for (int s = 0; s < W; ++s)
+        {
+          const double cosine = std::cos(angle[s]), sine = std::sin(angle[s]);
+          // the plane axes in link coordinates are e1, e2 turned back by the angle
+          for (int c = 0; c < 3; ++c)
+          {
+            motion[(9 + c) * W + s] = e1[c] * q[s] + e2[c] * q[W + s];
+            const double d1 = e1[c] * cosine - e2[c] * sine;
+            const double d2 = e2[c] * cosine + e1[c] * sine;
+            joint_velocity[c * W + s] = axis[c] * vt[s];
+            joint_velocity[(3 + c) * W + s] = d1 * vx[s] + d2 * vy[s];
+            joint_acceleration[c * W + s] = axis[c] * at[s];
+            joint_acceleration[(3 + c) * W + s] = d1 * ax[s] + d2 * ay[s];
+          }
+          // and turn with -angle, c_joint = -vt axis x (S v)
+          const double lx = joint_velocity[3 * W + s];
+          const double ly = joint_velocity[4 * W + s];
+          const double lz = joint_velocity[5 * W + s];
+          joint_acceleration[3 * W + s] -= vt[s] * (axis[1] * lz - axis[2] * ly);
+          joint_acceleration[4 * W + s] -= vt[s] * (axis[2] * lx - axis[0] * lz);
+          joint_acceleration[5 * W + s] -= vt[s] * (axis[0] * ly - axis[1] * lx);
+        }
+        break;
+      }
+      case Joint::FLOATING:
+      {
+        // body fixed velocities, S is the identity
+        const double *x = q + 3 * W, *y = q + 4 * W, *z = q + 5 * W, *w = q + 6 * W;
+        for (int s = 0; s < W; ++s)
+        {
+          const double norm = x[s] * x[s] + y[s] * y[s] + z[s] * z[s] + w[s] * w[s];
+          const double k = norm > 0.0 ? 2.0 / norm : 0.0;
+          const double d = norm > 0.0 ? 1.0 : 0.0;
+          motion[0 * W + s] = d - k * (y[s] * y[s] + z[s] * z[s]);
+          motion[1 * W + s] = k * (x[s] * y[s] - z[s] * w[s]);
+          motion[2 * W + s] = k * (x[s] * z[s] + y[s] * w[s]);
+          motion[3 * W + s] = k * (x[s] * y[s] + z[s] * w[s]);
+          motion[4 * W + s] = d - k * (x[s] * x[s] + z[s] * z[s]);
+          motion[5 * W + s] = k * (y[s] * z[s] - x[s] * w[s]);
+          motion[6 * W + s] = k * (x[s] * z[s] - y[s] * w[s]);
+          motion[7 * W + s] = k * (y[s] * z[s] + x[s] * w[s]);
+          motion[8 * W + s] = d - k * (x[s] * x[s] + y[s] * y[s]);
+        }
+        std::copy(q, q + 3 * W, motion + 9 * W);
+        std::copy(v, v + 6 * W, joint_velocity);
+        std::copy(a, a + 6 * W, joint_acceleration);
+        break;
+      }
+      default:
+        for (int c = 0; c < 3; ++c)
+        {
+          std::fill(motion + 4 * c * W, motion + (4 * c + 1) * W, 1.0);
+        }
+        break;
+    }
+  };
+
+  /// row major rotation about the unit axis by angle
+  template <int W>
+  static void axisRotation(const double *axis, const double *angle, double *out)
+  {
+    double cosine[W];
+    double sine[W];
+    detail::sinCos<W>(angle, sine, cosine);
+    const double x = axis[0], y = axis[1], z = axis[2];
+    for (int s = 0; s < W; ++s)
+    {
+      const double c = cosine[s], sn = sine[s], t = 1.0 - c;
+      out[0 * W + s] = t * x * x + c;
+      out[1 * W + s] = t * x * y - sn * z;
+      out[2 * W + s] = t * x * z + sn * y;
+      out[3 * W + s] = t * x * y + sn * z;
+      out[4 * W + s] = t * y * y + c;
+      out[5 * W + s] = t * y * z - sn * x;
+      out[6 * W + s] = t * x * z - sn * y;
+      out[7 * W + s] = t * y * z + sn * x;
+      out[8 * W + s] = t * z * z + c;
+    }
+  };
+
+  /// out = X m, m in parent coordinates, X the transform to the link at (rotation, translation)
+  template <int W>
+  static void transformMotion(const double *rotation, const double *translation, const double *m, double *out)
+  {
+    const double *r = rotation;
+    for (int s = 0; s < W; ++s)
+    {
+      const double wx = m[s], wy = m[W + s], wz = m[2 * W + s];
+      const double rx = translation[s], ry = translation[W + s], rz = translation[2 * W + s];
+      // velocity of the link origin, l + w x r, then both parts turned by R^T
+      const double px = m[3 * W + s] + wy * rz - wz * ry;
+      const double py = m[4 * W + s] + wz * rx - wx * rz;
+      const double pz = m[5 * W + s] + wx * ry - wy * rx;
+      for (int c = 0; c < 3; ++c)
+      {
+        const double r0 = r[c * W + s], r1 = r[(3 + c) * W + s], r2 = r[(6 + c) * W + s];
+        out[c * W + s] = r0 * wx + r1 * wy + r2 * wz;
+        out[(3 + c) * W + s] = r0 * px + r1 * py + r2 * pz;
+      }
+    }
+  };
+
+  /// acceleration += v x joint_velocity + joint_acceleration
+  template <int W>
+  static void addJointAcceleration(const double *velocity, const double *joint_velocity,
+                                   const double *joint_acceleration, double *acceleration)
+  {
+    for (int s = 0; s < W; ++s)
+    {
+      double vs[6], ms[6], out[6];
+      for (int c = 0; c < 6; ++c)
+      {
+        vs[c] = velocity[c * W + s];
+        ms[c] = joint_velocity[c * W + s];
+      }
+      spatial::crossMotion(vs, ms, out);
+      for (int c = 0; c < 6; ++c)
+      {
+        acceleration[c * W + s] += out[c] + joint_acceleration[c * W + s];
+      }
+    }
+  };
+
+  /// force = I a + v x* I v
+  template <int W>
+  static void bodyForce(const Body &body, const double *velocity, const double *acceleration, double *force)
+  {
+    const double m = body.mass;
+    const double hx = body.first_moment.x, hy = body.first_moment.y, hz = body.first_moment.z;
+    const double *i = body.rotational;
+    for (int s = 0; s < W; ++s)
+    {
+      const double wx = velocity[s], wy = velocity[W + s], wz = velocity[2 * W + s];
+      const double lx = velocity[3 * W + s], ly = velocity[4 * W + s], lz = velocity[5 * W + s];
+      const double awx = acceleration[s], awy = acceleration[W + s], awz = acceleration[2 * W + s];
+      const double alx = acceleration[3 * W + s], aly = acceleration[4 * W + s], alz = acceleration[5 * W + s];
+
+      // momentum I v = [Io w + h x l; m l - h x w]
+      const double kx = i[0] * wx + i[3] * wy + i[4] * wz + hy * lz - hz * ly;
+      const double ky = i[3] * wx + i[1] * wy + i[5] * wz + hz * lx - hx * lz;
+      const double kz = i[4] * wx + i[5] * wy + i[2] * wz + hx * ly - hy * lx;
+      const double px = m * lx - (hy * wz - hz * wy);
+      const double py = m * ly - (hz * wx - hx * wz);
+      const double pz = m * lz - (hx * wy - hy * wx);
+
+      // I a + [w x k + l x p; w x p]
+      force[s] = i[0] * awx + i[3] * awy + i[4] * awz + hy * alz - hz * aly +
+                 wy * kz - wz * ky + ly * pz - lz * py;
+      force[W + s] = i[3] * awx + i[1] * awy + i[5] * awz + hz * alx - hx * alz +
+                     wz * kx - wx * kz + lz * px - lx * pz;
+      force[2 * W + s] = i[4] * awx + i[5] * awy + i[2] * awz + hx * aly - hy * alx +
+                         wx * ky - wy * kx + lx * py - ly * px;
+      force[3 * W + s] = m * alx - (hy * awz - hz * awy) + wy * pz - wz * py;
+      force[4 * W + s] = m * aly - (hz * awx - hx * awz) + wz * px - wx * pz;
+      force[5 * W + s] = m * alz - (hx * awy - hy * awx) + wx * py - wy * px;
+    }
+  };
+
+  /// tau = S^T force + damping v + friction sign(v)
+  template <int W>
+  static void projectForce(const Body &body, const double *q, const double *v, const double *force, double *tau)
+  {
+    const double axis[3] = {body.axis.x, body.axis.y, body.axis.z};
+    int nv = 0;
+    switch (body.type)
+    {
+      case Joint::REVOLUTE:
+      case Joint::CONTINUOUS:
+      case Joint::PRISMATIC:
+      {
+        const double *f = body.type == Joint::PRISMATIC ? force + 3 * W : force;
+        for (int s = 0; s < W; ++s)
+        {
+          tau[s] = axis[0] * f[s] + axis[1] * f[W + s] + axis[2] * f[2 * W + s];
+        }
+        nv = 1;
+        break;
+      }
+      case Joint::PLANAR:
+      {
+        const double e1[3] = {body.plane_x.x, body.plane_x.y, body.plane_x.z};
+        const double e2[3] = {body.plane_y.x, body.plane_y.y, body.plane_y.z};
+        const double *angle = q + 2 * W;
+        for (int s = 0; s < W; ++s)
+        {
+          const double c = std::cos(angle[s]), sn = std::sin(angle[s]);
+          double tx = 0.0, ty = 0.0, tt = 0.0;
+          for (int k = 0; k < 3; ++k)
+          {
+            const double f = force[(3 + k) * W + s];
+            tx += (e1[k] * c - e2[k] * sn) * f;
+            ty += (e2[k] * c + e1[k] * sn) * f;
+            tt += axis[k] * force[k * W + s];
+          }
+          tau[s] = tx;
+          tau[W + s] = ty;
+          tau[2 * W + s] = tt;
+        }
+        nv = 3;
+        break;
+      }
+      case Joint::FLOATING:
+        std::copy(force, force + 6 * W, tau);
+        nv = 6;
+        break;
+      default:
+        break;
+    }
+    if (body.damping != 0.0 || body.friction != 0.0)
+    {
+      for (int e = 0; e < nv * W; ++e)
+      {
+        const double sign = v[e] > 0.0 ? 1.0 : (v[e] < 0.0 ? -1.0 : 0.0);
+        tau[e] += body.damping * v[e] + body.friction * sign;
+      }
+    }
+  };
+
+  /// parent += X^T force, the link force expressed in parent coordinates
+  template <int W>
+  static void addParentForce(const double *rotation, const double *translation, const double *force, double *parent)
+  {
+    // parent and force both live in the workspace, staging the sum in a
+    // local array spares the compiler from proving they do not overlap
+    double sum[6 * W];
+    const double *r = rotation;
+    for (int s = 0; s < W; ++s)
+    {
+      const double rx = translation[s], ry = translation[W + s], rz = translation[2 * W + s];
+      double moment[3], linear[3];
+      for (int c = 0; c < 3; ++c)
+      {
+        const double r0 = r[3 * c * W + s], r1 = r[(3 * c + 1) * W + s], r2 = r[(3 * c + 2) * W + s];
+        moment[c] = r0 * force[s] + r1 * force[W + s] + r2 * force[2 * W + s];
+        linear[c] = r0 * force[3 * W + s] + r1 * force[4 * W + s] + r2 * force[5 * W + s];
+      }
+      sum[s] = moment[0] + ry * linear[2] - rz * linear[1];
+      sum[W + s] = moment[1] + rz * linear[0] - rx * linear[2];
+      sum[2 * W + s] = moment[2] + rx * linear[1] - ry * linear[0];
+      sum[3 * W + s] = linear[0];
+      sum[4 * W + s] = linear[1];
+      sum[5 * W + s] = linear[2];
+    }
+    for (int e = 0; e < 6 * W; ++e)
+    {
+      parent[e] += sum[e];
+    }
+  };
+
+  std::size_t num_positions_;
+  std::size_t num_velocities_;
+  std::vector<Body> bodies_;
+  /// FIELDS arrays of up to BLOCK_SIZE samples per link
+  std::vector<double> workspace_;
+  /// q, v and a of one block of computeBatch(), then its tau
+  std::vector<double> block_input_;
+  std::vector<double> block_output_;
+};
+
+}
+
+#endif
@@ -0,0 +1,331 @@
+/* Geometric Jacobians of link points and their time derivatives */
+
+#ifndef URDF_INTERFACE_JACOBIAN_H
+#define URDF_INTERFACE_JACOBIAN_H
+
+#include <algorithm>
+#include <vector>
+
+#include <urdf_model/compiled_model.h>
+#include <urdf_model/forward_kinematics.h>
+#include <urdf_model/spatial.h>
+
+namespace urdf{
+
+/// \brief Geometric Jacobians of points fixed on the links of a CompiledModel
+///
+/// update() computes the link poses, the world frame motion subspace column
+/// of every velocity coordinate and, given joint velocities, the link
+/// velocities and the column derivatives.  The Jacobian of a point p on
+/// link i then maps the joint velocities to
+///
+///   [angular velocity of link i; velocity of p]
+///
+/// in world axes (WORLD) or in the axes of link i (LINK).  Only the
+/// coordinates of the joints between the root and link i can move p; they
+/// are the support of the link, see getSupport(), and every compute
+/// function only visits those.  The derivative J' is the time derivative
+/// of the same matrix along v, so the acceleration of p is J a + J' v.
+///
+/// Dense outputs are 6 row major rows of getNumVelocities() entries with
+/// zeros outside the support.  Sparse outputs hold one column of 6 entries
+/// per support coordinate, in getSupport() order.  Nothing allocates after
+/// init().
+class GeometricJacobian
+{
+public:
+  enum Frame
+  {
+    WORLD,
+    LINK
+  };
+
+  GeometricJacobian() { this->clear(); };
+  explicit GeometricJacobian(const CompiledModel &model) { this->init(model); };
+
+  std::size_t getNumLinks() const { return this->link_parent_.size(); };
+  std::size_t getNumPositions() const { return this->kinematics_.getNumPositions(); };
+  std::size_t getNumVelocities() const { return this->num_velocities_; };
+
+  void init(const CompiledModel &model)
+  {
+    this->clear();
+    const int num_links = static_cast<int>(model.getNumLinks());
+    this->kinematics_.init(model);
+    this->link_parent_ = model.link_parent;
+    this->link_joint_type_.assign(num_links, Joint::FIXED);
+    this->link_q_offset_.assign(num_links, 0);
+    this->link_v_offset_.assign(num_links, 0);
+    this->link_nv_.assign(num_links, 0);
+    this->link_axis_.assign(num_links, Vector3());
+    this->link_plane_x_.assign(num_links, Vector3());
+    this->link_plane_y_.assign(num_links, Vector3());
+    this->num_velocities_ = model.getNumVelocities();
+    for (int i = 1; i < num_links; ++i)
+    {
+      const int joint = model.link_parent_joint[i];
+      const int nv = model.joint_nv[joint];
+      if (nv == 0)
+      {
+        continue;
+      }
+      this->link_nv_[i] = nv;
+      this->link_q_offset_[i] = model.joint_q_offset[joint];
+      this->link_v_offset_[i] = model.joint_v_offset[joint];
+      this->link_joint_type_[i] = model.joint_type[joint];
+      if (this->link_joint_type_[i] != Joint::FLOATING)
+      {
+        // ForwardKinematics::init() already rejected zero axes
+        this->link_axis_[i] = model.joint_axis[joint] / model.joint_axis[joint].norm();
+      }
+      if (this->link_joint_type_[i] == Joint::PLANAR)
+      {
+        planarBasis(this->link_axis_[i], this->link_plane_x_[i], this->link_plane_y_[i]);
+      }
+    }
+
+    // the support of a link is that of its parent followed by its own
+    // coordinates; preorder keeps the coordinates of every path ascending
+    std::vector<int> support_size(num_links, 0);
+    for (int i = 1; i < num_links; ++i)
+    {
+      support_size[i] = support_size[this->link_parent_[i]] + this->link_nv_[i];
+    }
+    this->support_offsets_.assign(num_links + 1, 0);
+    for (int i = 0; i < num_links; ++i)
+    {
+      this->support_offsets_[i + 1] = this->support_offsets_[i] + support_size[i];
+    }
+    this->support_.resize(this->support_offsets_[num_links]);
+    for (int i = 1; i < num_links; ++i)
+    {
+      const int parent = this->link_parent_[i];
+      int *support = this->support_.data() + this->support_offsets_[i];
+      support = std::copy(this->support_.data() + this->support_offsets_[parent],
+                          this->support_.data() + this->support_offsets_[parent + 1], support);
+      for (int k = 0; k < this->link_nv_[i]; ++k)
+      {
+        support[k] = this->link_v_offset_[i] + k;
+      }
+    }
+
+    this->poses_.resize(num_links);
+    this->velocities_.assign(6 * num_links, 0.0);
+    this->subspace_.assign(6 * this->getNumVelocities(), 0.0);
+    this->subspace_derivative_.assign(6 * this->getNumVelocities(), 0.0);
+  };
+
+  /// \brief compute the link poses and subspace columns for joint positions q
+  ///
+  /// v may be null, in which case link velocities and derivatives are zero.
+  void update(const double *q, const double *v = nullptr)
+  {
+    const int num_links = static_cast<int>(this->getNumLinks());
+    if (num_links == 0)
+    {
+      return;
+    }
+    this->kinematics_.compute(q, this->poses_.data());
+    for (int i = 1; i < num_links; ++i)
+    {
+      const double *parent_velocity = this->velocities_.data() + 6 * this->link_parent_[i];
+      double *velocity = this->velocities_.data() + 6 * i;
+      std::copy(parent_velocity, parent_velocity + 6, velocity);
+      const int nv = this->link_nv_[i];
+      if (nv == 0)
+      {
+        continue;
+      }
+      const int offset = this->link_v_offset_[i];
+      double *s = this->subspace_.data() + 6 * offset;
+      spatial::jointSubspace(this->link_joint_type_[i], this->link_axis_[i], this->link_plane_x_[i],
+                             this->link_plane_y_[i], this->poses_[i], q + this->link_q_offset_[i], s);
+      if (v == nullptr)
+      {
+        std::fill(this->subspace_derivative_.data() + 6 * offset, this->subspace_derivative_.data() + 6 * (offset + nv), 0.0);
+        continue;
+      }
+      for (int k = 0; k < nv; ++k)
+      {
+        for (int r = 0; r < 6; ++r)
+        {
+          velocity[r] += s[6 * k + r] * v[offset + k];
+        }
+      }
+      // columns fixed in the child frame turn with the child velocity, the
+      // PLANAR translations are fixed in the parent frame; for a column along
+      // the joint motion both agree
+      for (int k = 0; k < nv; ++k)
+      {
+        const bool parent_fixed = this->link_joint_type_[i] == Joint::PLANAR && k < 2;
+        spatial::crossMotion(parent_fixed ? parent_velocity : velocity, s + 6 * k,
+                             this->subspace_derivative_.data() + 6 * (offset + k));
+      }
+    }
+  };
+
+  /// \brief velocity coordinates that move link i, ascending
+  ///
+  /// getSupportSize(i) entries, the column order of the sparse outputs.
+  const int *getSupport(int i) const { return this->support_.data() + this->support_offsets_[i]; };
+  std::size_t getSupportSize(int i) const
+  {
+    return static_cast<std::size_t>(this->support_offsets_[i + 1] - this->support_offsets_[i]);
+  };
+
+  /// dense Jacobian of point, given in the frame of link, 6 x getNumVelocities() entries
+  void computeJacobian(int link, const Vector3 &point, Frame frame, double *jacobian) const
+  {
+    this->computeDense(link, point, frame, false, jacobian);
+  };
+
+  /// Jacobian of point, given in the frame of link, 6 x getSupportSize(link) column major entries
+  void computeSparseJacobian(int link, const Vector3 &point, Frame frame, double *columns) const
+  {
+    this->computeSparse(link, point, frame, false, columns);
+  };
+
+  /// dense time derivative of the Jacobian, needs an update() with velocities
+  void computeJacobianDerivative(int link, const Vector3 &point, Frame frame, double *jacobian) const
+  {
+    this->computeDense(link, point, frame, true, jacobian);
+  };
+
+  /// sparse time derivative of the Jacobian, needs an update() with velocities
+  void computeSparseJacobianDerivative(int link, const Vector3 &point, Frame frame, double *columns) const
+  {
+    this->computeSparse(link, point, frame, true, columns);
+  };
+
+  /// world pose of link i as of the last update()
+  const Pose &getLinkPose(int i) const { return this->poses_[i]; };
+  /// world frame spatial velocity of link i as of the last update(), [angular; linear at the world origin]
+  const double *getLinkVelocity(int i) const { return this->velocities_.data() + 6 * i; };
+
+  void clear()
+  {
+    this->kinematics_.clear();
+    this->link_parent_.clear();
+    this->link_joint_type_.clear();
+    this->link_q_offset_.clear();
+    this->link_v_offset_.clear();
+    this->link_nv_.clear();
+    this->link_axis_.clear();
+    this->link_plane_x_.clear();
+    this->link_plane_y_.clear();
+    this->num_velocities_ = 0;
+    this->support_offsets_.clear();
+    this->support_.clear();
+    this->poses_.clear();
+    this->velocities_.clear();
+    this->subspace_.clear();
+    this->subspace_derivative_.clear();
+  };
+
+private:
+  void computeDense(int link, const Vector3 &point, Frame frame, bool derivative, double *jacobian) const
+  {
+    const std::size_t n = this->getNumVelocities();
+    std::fill(jacobian, jacobian + 6 * n, 0.0);
+    const int *support = this->getSupport(link);
+    const std::size_t size = this->getSupportSize(link);
+    const PointFrame at = this->pointFrame(link, point);
+    for (std::size_t j = 0; j < size; ++j)
+    {
+      double column[6];
+      this->computeColumn(at, support[j], frame, derivative, column);
+      for (int r = 0; r < 6; ++r)
+      {
+        jacobian[r * n + support[j]] = column[r];
+      }
+    }
+  };
+
+  void computeSparse(int link, const Vector3 &point, Frame frame, bool derivative, double *columns) const
+  {
+    const int *support = this->getSupport(link);
+    const std::size_t size = this->getSupportSize(link);
+    const PointFrame at = this->pointFrame(link, point);
+    for (std::size_t j = 0; j < size; ++j)
+    {
+      this->computeColumn(at, support[j], frame, derivative, columns + 6 * j);
+    }
+  };
+
+  /// world position, velocity and axes of a point on a link
+  struct PointFrame
+  {
+    Vector3 position;
+    Vector3 velocity;
+    Vector3 angular_velocity;
+    Rotation inverse_rotation;
+  };
+
+  PointFrame pointFrame(int link, const Vector3 &point) const
+  {
+    PointFrame at;
+    const Pose &pose = this->poses_[link];
+    const double *velocity = this->velocities_.data() + 6 * link;
+    at.position = pose * point;
+    at.angular_velocity = Vector3(velocity[0], velocity[1], velocity[2]);
+    at.velocity = Vector3(velocity[3], velocity[4], velocity[5]) + at.angular_velocity.cross(at.position);
+    at.inverse_rotation = pose.rotation.GetInverse();
+    return at;
+  };
+
+  /// column k of the Jacobian of the point at, or of its derivative
+  void computeColumn(const PointFrame &at, int k, Frame frame, bool derivative, double *out) const
+  {
+    const double *s = this->subspace_.data() + 6 * k;
+    const Vector3 angular(s[0], s[1], s[2]);
+    const Vector3 linear = Vector3(s[3], s[4], s[5]) + angular.cross(at.position);
+    Vector3 angular_out = angular, linear_out = linear;
+    if (derivative)
+    {
+      const double *sd = this->subspace_derivative_.data() + 6 * k;
+      const Vector3 angular_rate(sd[0], sd[1], sd[2]);
+      angular_out = angular_rate;
+      linear_out = Vector3(sd[3], sd[4], sd[5]) + angular_rate.cross(at.position) + angular.cross(at.velocity);
+      if (frame == LINK)
+      {
+        // d/dt R^T x = R^T (x' - w x x) for link angular velocity w
+        angular_out = angular_out - at.angular_velocity.cross(angular);
+        linear_out = linear_out - at.angular_velocity.cross(linear);
+      }
+    }
+    if (frame == LINK)
+    {
+      angular_out = at.inverse_rotation * angular_out;
+      linear_out = at.inverse_rotation * linear_out;
+    }
+    out[0] = angular_out.x; out[1] = angular_out.y; out[2] = angular_out.z;
+    out[3] = linear_out.x; out[4] = linear_out.y; out[5] = linear_out.z;
+  };
+
+  ForwardKinematics kinematics_;
+
+  std::vector<int> link_parent_;
+  /// FIXED for links whose parent joint has no velocity coordinates
+  std::vector<int> link_joint_type_;
+  std::vector<int> link_q_offset_;
+  std::vector<int> link_v_offset_;
+  std::vector<int> link_nv_;
+  std::vector<Vector3> link_axis_;
+  std::vector<Vector3> link_plane_x_;
+  std::vector<Vector3> link_plane_y_;
+  std::size_t num_velocities_;
+  /// support of link i is support_[support_offsets_[i] .. support_offsets_[i + 1])
+  std::vector<int> support_offsets_;
+  std::vector<int> support_;
+
+  std::vector<Pose> poses_;
+  /// 6 per link
+  std::vector<double> velocities_;
+  /// 6 per velocity coordinate
+  std::vector<double> subspace_;
+  std::vector<double> subspace_derivative_;
+};
+
+}
+
+#endif
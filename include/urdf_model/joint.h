@@ -225,6 +225,7 @@ public:
     this->calibration.reset();
     this->mimic.reset();
     this->type = UNKNOWN;
+    this->independent = true;
   };
 };
 
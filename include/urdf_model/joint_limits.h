@@ -0,0 +1,519 @@
+/* Packed joint limits with batched clamping, safety controller bounds and violation checks */
+
+#ifndef URDF_INTERFACE_JOINT_LIMITS_H
+#define URDF_INTERFACE_JOINT_LIMITS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <urdf_model/compiled_model.h>
+#include <urdf_model/joint.h>
+#include <urdf_model/simd.h>
+
+namespace urdf{
+
+/// \brief JointLimits and JointSafety of every one coordinate joint as one array per field
+///
+/// Entry e describes joint[e] of the CompiledModel, whose position is
+/// q[q_index[e]] and whose velocity is v[v_index[e]].  The batched
+/// functions take and return one value per entry, gather() packs full
+/// joint vectors into that order.
+///
+/// Missing limits are stored as infinities: CONTINUOUS joints and joints
+/// without a JointLimits have lower = -inf and upper = +inf, joints without
+/// a JointLimits also have infinite velocity and effort.  The flags record
+/// where the values came from.  The safety fields are only used for entries
+/// flagged HAS_SAFETY and are zero otherwise.
+class JointLimitTable
+{
+public:
+  enum Flags
+  {
+    CONTINUOUS = 1,
+    HAS_LIMITS = 2,
+    HAS_SAFETY = 4
+  };
+
+  /// bits of the checkViolations() output
+  enum Violation
+  {
+    POSITION_VIOLATION = 1,
+    VELOCITY_VIOLATION = 2,
+    EFFORT_VIOLATION = 4
+  };
+
+  JointLimitTable() { this->clear(); };
+  explicit JointLimitTable(const CompiledModel &model) { this->init(model); };
+
+  std::size_t size() const { return this->joint.size(); };
+
+  /// one entry per REVOLUTE, CONTINUOUS and PRISMATIC joint, in joint order
+  void init(const CompiledModel &model)
+  {
+    this->clear();
+    const double infinity = std::numeric_limits<double>::infinity();
+    for (std::size_t j = 0; j < model.getNumJoints(); ++j)
+    {
+      if (model.joint_nq[j] != 1)
+      {
+        continue;
+      }
+      const Joint &source = *model.source_joints[j];
+      std::uint8_t entry_flags = source.type == Joint::CONTINUOUS ? CONTINUOUS : 0;
+      double limit_lower = -infinity, limit_upper = infinity, limit_velocity = infinity, limit_effort = infinity;
+      if (source.limits)
+      {
+        entry_flags |= HAS_LIMITS;
+        limit_velocity = source.limits->velocity;
+        limit_effort = source.limits->effort;
+        if (source.type != Joint::CONTINUOUS)
+        {
+          limit_lower = source.limits->lower;
+          limit_upper = source.limits->upper;
+        }
+      }
+      double safety_soft_lower = 0.0, safety_soft_upper = 0.0, safety_k_position = 0.0, safety_k_velocity = 0.0;
+      if (source.safety)
+      {
+        entry_flags |= HAS_SAFETY;
+        safety_soft_lower = source.safety->soft_lower_limit;
+        safety_soft_upper = source.safety->soft_upper_limit;
+        safety_k_position = source.safety->k_position;
+        safety_k_velocity = source.safety->k_velocity;
+      }
+      this->joint.push_back(static_cast<int>(j));
+      this->q_index.push_back(model.joint_q_offset[j]);
+      this->v_index.push_back(model.joint_v_offset[j]);
+      this->lower.push_back(limit_lower);
+      this->upper.push_back(limit_upper);
+      this->velocity.push_back(limit_velocity);
+      this->effort.push_back(limit_effort);
+      this->soft_lower.push_back(safety_soft_lower);
+      this->soft_upper.push_back(safety_soft_upper);
+      this->k_position.push_back(safety_k_position);
+      this->k_velocity.push_back(safety_k_velocity);
+      this->flags.push_back(entry_flags);
+    }
+  };
+
+  /// out[e] = full[index[e]], with index q_index or v_index
+  void gather(const std::vector<int> &index, const double *full, double *out) const
+  {
+    for (std::size_t e = 0; e < index.size(); ++e)
+    {
+      out[e] = full[index[e]];
+    }
+  };
+
+  /// positions q clamped to [lower, upper], out may be q; NaN becomes lower
+  void clampPositions(const double *q, double *out) const;
+
+  /// \brief bounds of the safety controller described at JointSafety, at positions q and velocities v
+  ///
+  /// Entries without HAS_SAFETY get [-velocity, velocity] and [-effort, effort].
+  void computeSafetyBounds(const double *q, const double *v,
+                           double *velocity_min, double *velocity_max,
+                           double *effort_min, double *effort_max) const;
+
+  /// effort commands tau saturated by the safety bounds, out may be tau; NaN becomes the lower bound
+  void saturateEfforts(const double *q, const double *v, const double *tau, double *out) const;
+
+  /// \brief Violation bits of every entry against the hard limits, returns the number of entries violating any
+  ///
+  /// NaN inputs count as violations.
+  std::size_t checkViolations(const double *q, const double *v, const double *tau,
+                              std::uint8_t *violations) const;
+
+  void clear()
+  {
+    this->joint.clear();
+    this->q_index.clear();
+    this->v_index.clear();
+    this->lower.clear();
+    this->upper.clear();
+    this->velocity.clear();
+    this->effort.clear();
+    this->soft_lower.clear();
+    this->soft_upper.clear();
+    this->k_position.clear();
+    this->k_velocity.clear();
+    this->flags.clear();
+  };
+
+  /// CompiledModel joint of each entry and its coordinate in q and v
+  std::vector<int> joint;
+  std::vector<int> q_index;
+  std::vector<int> v_index;
+  /// JointLimits
+  std::vector<double> lower;
+  std::vector<double> upper;
+  std::vector<double> velocity;
+  std::vector<double> effort;
+  /// JointSafety
+  std::vector<double> soft_lower;
+  std::vector<double> soft_upper;
+  std::vector<double> k_position;
+  std::vector<double> k_velocity;
+  /// Flags
+  std::vector<std::uint8_t> flags;
+};
+
+namespace detail{
+
+/// safety bounds of entry e at position q and velocity v, the formulas of JointSafety written out
+inline void safetyBoundsEntry(const JointLimitTable &t, std::size_t e, double q, double v,
+                              double &v_min, double &v_max, double &e_min, double &e_max)
+{
+  const bool safety = (t.flags[e] & JointLimitTable::HAS_SAFETY) != 0;
+  v_min = -t.velocity[e];
+  v_max = t.velocity[e];
+  const double position_margin = t.velocity[e] / t.k_position[e];
+  if (safety && (q < t.soft_lower[e] + position_margin || q > t.soft_upper[e] - position_margin))
+  {
+    v_min += t.k_position[e] * (q - t.soft_lower[e]);
+    v_max += t.k_position[e] * (q - t.soft_upper[e]);
+  }
+  e_min = -t.effort[e];
+  e_max = t.effort[e];
+  const double velocity_margin = t.effort[e] / t.k_velocity[e];
+  if (safety && (v < v_min + velocity_margin || v > v_max - velocity_margin))
+  {
+    e_min += t.k_velocity[e] * (v - v_min);
+    e_max += t.k_velocity[e] * (v - v_max);
+  }
+}
+
+inline void safetyBoundsScalar(const JointLimitTable &t, std::size_t begin, std::size_t n,
+                               const double *q, const double *v,
+                               double *velocity_min, double *velocity_max, double *effort_min, double *effort_max)
+{
+  for (std::size_t e = begin; e < n; ++e)
+  {
+    safetyBoundsEntry(t, e, q[e], v[e], velocity_min[e], velocity_max[e], effort_min[e], effort_max[e]);
+  }
+}
+
+inline void saturateEffortsScalar(const JointLimitTable &t, std::size_t begin, std::size_t n,
+                                  const double *q, const double *v, const double *effort, double *out)
+{
+  for (std::size_t e = begin; e < n; ++e)
+  {
+    double v_min, v_max, e_min, e_max;
+    safetyBoundsEntry(t, e, q[e], v[e], v_min, v_max, e_min, e_max);
+    const double raised = effort[e] > e_min ? effort[e] : e_min;
+    out[e] = raised < e_max ? raised : e_max;
+  }
+}
+
+inline void clampPositionsScalar(const JointLimitTable &t, std::size_t begin, std::size_t n, const double *q, double *out)
+{
+  for (std::size_t e = begin; e < n; ++e)
+  {
+    const double raised = q[e] > t.lower[e] ? q[e] : t.lower[e];
+    out[e] = raised < t.upper[e] ? raised : t.upper[e];
+  }
+}
+
+inline std::size_t checkViolationsScalar(const JointLimitTable &t, std::size_t begin, std::size_t n,
+                                         const double *q, const double *v, const double *effort,
+                                         std::uint8_t *violations)
+{
+  std::size_t count = 0;
+  for (std::size_t e = begin; e < n; ++e)
+  {
+    const std::uint8_t bits = (!(q[e] >= t.lower[e] && q[e] <= t.upper[e]) ? JointLimitTable::POSITION_VIOLATION : 0) |
+                              (!(std::abs(v[e]) <= t.velocity[e]) ? JointLimitTable::VELOCITY_VIOLATION : 0) |
+                              (!(std::abs(effort[e]) <= t.effort[e]) ? JointLimitTable::EFFORT_VIOLATION : 0);
+    violations[e] = bits;
+    count += bits != 0;
+  }
+  return count;
+}
+
+#ifdef URDF_SIMD_X86
+
+/// safety bounds of the 4 entries at e, the blends stand in for the branches of the scalar code
+URDF_TARGET_AVX2
+inline void safetyBoundsAvx2(const JointLimitTable &t, std::size_t e, const double *q, const double *v,
+                             __m256d &v_min, __m256d &v_max, __m256d &e_min, __m256d &e_max)
+{
+  std::int32_t packed;
+  std::memcpy(&packed, &t.flags[e], sizeof(packed));
+  const __m256i flag_bits = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packed));
+  const __m256d safety = _mm256_castsi256_pd(_mm256_cmpeq_epi64(
+    _mm256_and_si256(flag_bits, _mm256_set1_epi64x(JointLimitTable::HAS_SAFETY)), _mm256_set1_epi64x(JointLimitTable::HAS_SAFETY)));
+
+  const __m256d position = _mm256_loadu_pd(q + e), speed = _mm256_loadu_pd(v + e);
+  const __m256d velocity = _mm256_loadu_pd(&t.velocity[e]), effort = _mm256_loadu_pd(&t.effort[e]);
+  const __m256d soft_lower = _mm256_loadu_pd(&t.soft_lower[e]), soft_upper = _mm256_loadu_pd(&t.soft_upper[e]);
+  const __m256d k_position = _mm256_loadu_pd(&t.k_position[e]), k_velocity = _mm256_loadu_pd(&t.k_velocity[e]);
+  const __m256d sign = _mm256_set1_pd(-0.0);
+
+  const __m256d position_margin = _mm256_div_pd(velocity, k_position);
+  const __m256d outside_position = _mm256_and_pd(safety, _mm256_or_pd(
+    _mm256_cmp_pd(position, _mm256_add_pd(soft_lower, position_margin), _CMP_LT_OQ),
+    _mm256_cmp_pd(position, _mm256_sub_pd(soft_upper, position_margin), _CMP_GT_OQ)));
+  v_min = _mm256_xor_pd(velocity, sign);
+  v_max = velocity;
+  v_min = _mm256_blendv_pd(v_min, _mm256_add_pd(v_min, _mm256_mul_pd(k_position, _mm256_sub_pd(position, soft_lower))), outside_position);
+  v_max = _mm256_blendv_pd(v_max, _mm256_add_pd(v_max, _mm256_mul_pd(k_position, _mm256_sub_pd(position, soft_upper))), outside_position);
+
+  const __m256d velocity_margin = _mm256_div_pd(effort, k_velocity);
+  const __m256d outside_velocity = _mm256_and_pd(safety, _mm256_or_pd(
+    _mm256_cmp_pd(speed, _mm256_add_pd(v_min, velocity_margin), _CMP_LT_OQ),
+    _mm256_cmp_pd(speed, _mm256_sub_pd(v_max, velocity_margin), _CMP_GT_OQ)));
+  e_min = _mm256_xor_pd(effort, sign);
+  e_max = effort;
+  e_min = _mm256_blendv_pd(e_min, _mm256_add_pd(e_min, _mm256_mul_pd(k_velocity, _mm256_sub_pd(speed, v_min))), outside_velocity);
+  e_max = _mm256_blendv_pd(e_max, _mm256_add_pd(e_max, _mm256_mul_pd(k_velocity, _mm256_sub_pd(speed, v_max))), outside_velocity);
+}
+
+URDF_TARGET_AVX2
+inline void safetyBoundsAvx2(const JointLimitTable &t, std::size_t n, const double *q, const double *v,
+                             double *velocity_min, double *velocity_max, double *effort_min, double *effort_max)
+{
+  std::size_t e = 0;
+  for (; e + 4 <= n; e += 4)
+  {
+    __m256d v_min, v_max, e_min, e_max;
+    safetyBoundsAvx2(t, e, q, v, v_min, v_max, e_min, e_max);
+    _mm256_storeu_pd(velocity_min + e, v_min);
+    _mm256_storeu_pd(velocity_max + e, v_max);
+    _mm256_storeu_pd(effort_min + e, e_min);
+    _mm256_storeu_pd(effort_max + e, e_max);
+  }
+  safetyBoundsScalar(t, e, n, q, v, velocity_min, velocity_max, effort_min, effort_max);
+}
+
+URDF_TARGET_AVX2
+inline void saturateEffortsAvx2(const JointLimitTable &t, std::size_t n, const double *q, const double *v,
+                                const double *effort, double *out)
+{
+  std::size_t e = 0;
+  for (; e + 4 <= n; e += 4)
+  {
+    __m256d v_min, v_max, e_min, e_max;
+    safetyBoundsAvx2(t, e, q, v, v_min, v_max, e_min, e_max);
+    _mm256_storeu_pd(out + e, _mm256_min_pd(_mm256_max_pd(_mm256_loadu_pd(effort + e), e_min), e_max));
+  }
+  saturateEffortsScalar(t, e, n, q, v, effort, out);
+}
+
+URDF_TARGET_AVX2
+inline void clampPositionsAvx2(const JointLimitTable &t, std::size_t n, const double *q, double *out)
+{
+  std::size_t e = 0;
+  for (; e + 4 <= n; e += 4)
+  {
+    const __m256d clamped = _mm256_max_pd(_mm256_loadu_pd(q + e), _mm256_loadu_pd(&t.lower[e]));
+    _mm256_storeu_pd(out + e, _mm256_min_pd(clamped, _mm256_loadu_pd(&t.upper[e])));
+  }
+  clampPositionsScalar(t, e, n, q, out);
+}
+
+URDF_TARGET_AVX2
+inline std::size_t checkViolationsAvx2(const JointLimitTable &t, std::size_t n, const double *q, const double *v,
+                                       const double *effort, std::uint8_t *violations)
+{
+  const __m256d magnitude = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+  std::size_t count = 0;
+  std::size_t e = 0;
+  for (; e + 4 <= n; e += 4)
+  {
+    const __m256d position = _mm256_loadu_pd(q + e);
+    // the ordered comparisons are false for NaN, so NaN is outside
+    const int position_ok = _mm256_movemask_pd(_mm256_and_pd(
+      _mm256_cmp_pd(position, _mm256_loadu_pd(&t.lower[e]), _CMP_GE_OQ),
+      _mm256_cmp_pd(position, _mm256_loadu_pd(&t.upper[e]), _CMP_LE_OQ)));
+    const int velocity_ok = _mm256_movemask_pd(_mm256_cmp_pd(
+      _mm256_and_pd(_mm256_loadu_pd(v + e), magnitude), _mm256_loadu_pd(&t.velocity[e]), _CMP_LE_OQ));
+    const int effort_ok = _mm256_movemask_pd(_mm256_cmp_pd(
+      _mm256_and_pd(_mm256_loadu_pd(effort + e), magnitude), _mm256_loadu_pd(&t.effort[e]), _CMP_LE_OQ));
+    for (int lane = 0; lane < 4; ++lane)
+    {
+      const std::uint8_t bits = ((~position_ok >> lane) & 1) * JointLimitTable::POSITION_VIOLATION |
+                                ((~velocity_ok >> lane) & 1) * JointLimitTable::VELOCITY_VIOLATION |
+                                ((~effort_ok >> lane) & 1) * JointLimitTable::EFFORT_VIOLATION;
+      violations[e + lane] = bits;
+    }
+    count += __builtin_popcount(~(position_ok & velocity_ok & effort_ok) & 0xf);
+  }
+  return count + checkViolationsScalar(t, e, n, q, v, effort, violations);
+}
+
+URDF_TARGET_AVX512
+inline void safetyBoundsAvx512(const JointLimitTable &t, std::size_t e, const double *q, const double *v,
+                               __m512d &v_min, __m512d &v_max, __m512d &e_min, __m512d &e_max)
+{
+  // the zero masked forms with a full mask, as the plain ones make GCC 12 warn about
+  // their undefined pass through operand under -Wall
+  std::uint64_t packed;
+  std::memcpy(&packed, &t.flags[e], sizeof(packed));
+  const __m512i flag_bits = _mm512_maskz_cvtepu8_epi64(0xff, _mm_cvtsi64_si128(static_cast<long long>(packed)));
+  const __mmask8 safety = _mm512_test_epi64_mask(flag_bits, _mm512_set1_epi64(JointLimitTable::HAS_SAFETY));
+
+  const __m512d position = _mm512_loadu_pd(q + e), speed = _mm512_loadu_pd(v + e);
+  const __m512d velocity = _mm512_loadu_pd(&t.velocity[e]), effort = _mm512_loadu_pd(&t.effort[e]);
+  const __m512d soft_lower = _mm512_loadu_pd(&t.soft_lower[e]), soft_upper = _mm512_loadu_pd(&t.soft_upper[e]);
+  const __m512d k_position = _mm512_loadu_pd(&t.k_position[e]), k_velocity = _mm512_loadu_pd(&t.k_velocity[e]);
+  const __m512i sign = _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ULL));
+
+  const __m512d position_margin = _mm512_div_pd(velocity, k_position);
+  const __mmask8 outside_position = safety &
+    (_mm512_cmp_pd_mask(position, _mm512_add_pd(soft_lower, position_margin), _CMP_LT_OQ) |
+     _mm512_cmp_pd_mask(position, _mm512_sub_pd(soft_upper, position_margin), _CMP_GT_OQ));
+  v_min = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(velocity), sign));
+  v_max = velocity;
+  v_min = _mm512_mask_add_pd(v_min, outside_position, v_min, _mm512_mul_pd(k_position, _mm512_sub_pd(position, soft_lower)));
+  v_max = _mm512_mask_add_pd(v_max, outside_position, v_max, _mm512_mul_pd(k_position, _mm512_sub_pd(position, soft_upper)));
+
+  const __m512d velocity_margin = _mm512_div_pd(effort, k_velocity);
+  const __mmask8 outside_velocity = safety &
+    (_mm512_cmp_pd_mask(speed, _mm512_add_pd(v_min, velocity_margin), _CMP_LT_OQ) |
+     _mm512_cmp_pd_mask(speed, _mm512_sub_pd(v_max, velocity_margin), _CMP_GT_OQ));
+  e_min = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(effort), sign));
+  e_max = effort;
+  e_min = _mm512_mask_add_pd(e_min, outside_velocity, e_min, _mm512_mul_pd(k_velocity, _mm512_sub_pd(speed, v_min)));
+  e_max = _mm512_mask_add_pd(e_max, outside_velocity, e_max, _mm512_mul_pd(k_velocity, _mm512_sub_pd(speed, v_max)));
+}
+
+URDF_TARGET_AVX512
+inline void safetyBoundsAvx512(const JointLimitTable &t, std::size_t n, const double *q, const double *v,
+                               double *velocity_min, double *velocity_max, double *effort_min, double *effort_max)
+{
+  std::size_t e = 0;
+  for (; e + 8 <= n; e += 8)
+  {
+    __m512d v_min, v_max, e_min, e_max;
+    safetyBoundsAvx512(t, e, q, v, v_min, v_max, e_min, e_max);
+    _mm512_storeu_pd(velocity_min + e, v_min);
+    _mm512_storeu_pd(velocity_max + e, v_max);
+    _mm512_storeu_pd(effort_min + e, e_min);
+    _mm512_storeu_pd(effort_max + e, e_max);
+  }
+  safetyBoundsScalar(t, e, n, q, v, velocity_min, velocity_max, effort_min, effort_max);
+}
+
+URDF_TARGET_AVX512
+inline void saturateEffortsAvx512(const JointLimitTable &t, std::size_t n, const double *q, const double *v,
+                                  const double *effort, double *out)
+{
+  std::size_t e = 0;
+  for (; e + 8 <= n; e += 8)
+  {
+    __m512d v_min, v_max, e_min, e_max;
+    safetyBoundsAvx512(t, e, q, v, v_min, v_max, e_min, e_max);
+    const __m512d raised = _mm512_maskz_max_pd(0xff, _mm512_loadu_pd(effort + e), e_min);
+    _mm512_storeu_pd(out + e, _mm512_maskz_min_pd(0xff, raised, e_max));
+  }
+  saturateEffortsScalar(t, e, n, q, v, effort, out);
+}
+
+URDF_TARGET_AVX512
+inline void clampPositionsAvx512(const JointLimitTable &t, std::size_t n, const double *q, double *out)
+{
+  std::size_t e = 0;
+  for (; e + 8 <= n; e += 8)
+  {
+    const __m512d clamped = _mm512_maskz_max_pd(0xff, _mm512_loadu_pd(q + e), _mm512_loadu_pd(&t.lower[e]));
+    _mm512_storeu_pd(out + e, _mm512_maskz_min_pd(0xff, clamped, _mm512_loadu_pd(&t.upper[e])));
+  }
+  clampPositionsScalar(t, e, n, q, out);
+}
+
+URDF_TARGET_AVX512
+inline std::size_t checkViolationsAvx512(const JointLimitTable &t, std::size_t n, const double *q, const double *v,
+                                         const double *effort, std::uint8_t *violations)
+{
+  std::size_t count = 0;
+  std::size_t e = 0;
+  for (; e + 8 <= n; e += 8)
+  {
+    const __m512d position = _mm512_loadu_pd(q + e);
+    const __mmask8 position_bad = ~(_mm512_cmp_pd_mask(position, _mm512_loadu_pd(&t.lower[e]), _CMP_GE_OQ) &
+                                    _mm512_cmp_pd_mask(position, _mm512_loadu_pd(&t.upper[e]), _CMP_LE_OQ));
+    const __mmask8 velocity_bad = ~_mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_loadu_pd(v + e)),
+                                                      _mm512_loadu_pd(&t.velocity[e]), _CMP_LE_OQ);
+    const __mmask8 effort_bad = ~_mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_loadu_pd(effort + e)),
+                                                    _mm512_loadu_pd(&t.effort[e]), _CMP_LE_OQ);
+    __m512i bits = _mm512_maskz_mov_epi64(position_bad, _mm512_set1_epi64(JointLimitTable::POSITION_VIOLATION));
+    bits = _mm512_or_si512(bits, _mm512_maskz_mov_epi64(velocity_bad, _mm512_set1_epi64(JointLimitTable::VELOCITY_VIOLATION)));
+    bits = _mm512_or_si512(bits, _mm512_maskz_mov_epi64(effort_bad, _mm512_set1_epi64(JointLimitTable::EFFORT_VIOLATION)));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(violations + e), _mm512_maskz_cvtepi64_epi8(0xff, bits));
+    count += __builtin_popcount(static_cast<unsigned>(position_bad | velocity_bad | effort_bad) & 0xffu);
+  }
+  return count + checkViolationsScalar(t, e, n, q, v, effort, violations);
+}
+
+#endif
+
+}
+
+inline void JointLimitTable::clampPositions(const double *q, double *out) const
+{
+#ifdef URDF_SIMD_X86
+  switch (simd::detectLevel())
+  {
+    case simd::AVX512: detail::clampPositionsAvx512(*this, this->size(), q, out); return;
+    case simd::AVX2: detail::clampPositionsAvx2(*this, this->size(), q, out); return;
+    default: break;
+  }
+#endif
+  detail::clampPositionsScalar(*this, 0, this->size(), q, out);
+}
+
+inline void JointLimitTable::computeSafetyBounds(const double *q, const double *v,
+                                                 double *velocity_min, double *velocity_max,
+                                                 double *effort_min, double *effort_max) const
+{
+#ifdef URDF_SIMD_X86
+  switch (simd::detectLevel())
+  {
+    case simd::AVX512:
+      detail::safetyBoundsAvx512(*this, this->size(), q, v, velocity_min, velocity_max, effort_min, effort_max);
+      return;
+    case simd::AVX2:
+      detail::safetyBoundsAvx2(*this, this->size(), q, v, velocity_min, velocity_max, effort_min, effort_max);
+      return;
+    default: break;
+  }
+#endif
+  detail::safetyBoundsScalar(*this, 0, this->size(), q, v, velocity_min, velocity_max, effort_min, effort_max);
+}
+
+inline void JointLimitTable::saturateEfforts(const double *q, const double *v, const double *tau,
+                                             double *out) const
+{
+#ifdef URDF_SIMD_X86
+  switch (simd::detectLevel())
+  {
+    case simd::AVX512: detail::saturateEffortsAvx512(*this, this->size(), q, v, tau, out); return;
+    case simd::AVX2: detail::saturateEffortsAvx2(*this, this->size(), q, v, tau, out); return;
+    default: break;
+  }
+#endif
+  detail::saturateEffortsScalar(*this, 0, this->size(), q, v, tau, out);
+}
+
+inline std::size_t JointLimitTable::checkViolations(const double *q, const double *v, const double *tau,
+                                                    std::uint8_t *violations) const
+{
+#ifdef URDF_SIMD_X86
+  switch (simd::detectLevel())
+  {
+    case simd::AVX512: return detail::checkViolationsAvx512(*this, this->size(), q, v, tau, violations);
+    case simd::AVX2: return detail::checkViolationsAvx2(*this, this->size(), q, v, tau, violations);
+    default: break;
+  }
+#endif
+  return detail::checkViolationsScalar(*this, 0, this->size(), q, v, tau, violations);
+}
+
+}
+
+#endif
@@ -0,0 +1,79 @@
+/* Read only memory mapping of whole files */
+
+#ifndef URDF_INTERFACE_MAPPED_FILE_H
+#define URDF_INTERFACE_MAPPED_FILE_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace urdf{
+
+/// \brief the bytes of a file, mapped read only and 8 byte aligned
+///
+/// The mapping lives as long as the returned pointer or its copies.  An
+/// empty file gives an empty pointer and size 0.  On Windows the file is
+/// read into memory instead.  Throws std::runtime_error if the file cannot
+/// be read.
+inline std::shared_ptr<const char> mapFile(const std::string &filename, std::size_t &size)
+{
+#if defined(_WIN32)
+  std::ifstream in(filename.c_str(), std::ios::binary | std::ios::ate);
+  if (!in)
+  {
+    throw std::runtime_error("Cannot open file [" + filename + "]");
+  }
+  size = static_cast<std::size_t>(in.tellg());
+  if (size == 0)
+  {
+    return std::shared_ptr<const char>();
+  }
+  std::shared_ptr<std::uint64_t> words(new std::uint64_t[(size + 7) / 8], std::default_delete<std::uint64_t[]>());
+  in.seekg(0);
+  if (!in.read(reinterpret_cast<char *>(words.get()), size))
+  {
+    throw std::runtime_error("Cannot read file [" + filename + "]");
+  }
+  return std::shared_ptr<const char>(words, reinterpret_cast<const char *>(words.get()));
+#else
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw std::runtime_error("Cannot open file [" + filename + "]");
+  }
+  struct stat status;
+  if (::fstat(fd, &status) != 0)
+  {
+    ::close(fd);
+    throw std::runtime_error("Cannot read file [" + filename + "]");
+  }
+  size = static_cast<std::size_t>(status.st_size);
+  if (size == 0)
+  {
+    ::close(fd);
+    return std::shared_ptr<const char>();
+  }
+  void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED)
+  {
+    throw std::runtime_error("Cannot map file [" + filename + "]");
+  }
+  const std::size_t length = size;
+  return std::shared_ptr<const char>(static_cast<const char *>(data),
+                                     [length](const char *p) { ::munmap(const_cast<char *>(p), length); });
+#endif
+}
+
+}
+
+#endif
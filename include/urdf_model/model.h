@@ -38,11 +38,16 @@
 #define URDF_INTERFACE_MODEL_H
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <stack>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <algorithm>
 #include <urdf_model/link.h>
 #include <urdf_model/cluster.h>
+#include <urdf_model/name_index.h>
 #include <urdf_model/types.h>
 #include <urdf_exception/exception.h>
 
@@ -51,48 +56,58 @@ namespace urdf {
 class ModelInterface
 {
 public:
+  ModelInterface() = default;
+  ModelInterface(const ModelInterface &) = default;
+  ModelInterface &operator=(const ModelInterface &) = default;
+  ModelInterface(ModelInterface &&) = default;
+  ModelInterface &operator=(ModelInterface &&) = default;
+
+  /// releaseTree() frees deep chains iteratively instead of through recursive shared_ptr teardown
+  ~ModelInterface()
+  {
+    this->clearNameIndex();
+    this->releaseTree();
+  };
+
   LinkConstSharedPtr getRoot(void) const{return this->root_link_;};
   LinkConstSharedPtr getLink(const std::string& name) const
   {
-    LinkConstSharedPtr ptr;
-    if (this->links_.find(name) == this->links_.end())
-      ptr.reset();
-    else
-      ptr = this->links_.find(name)->second;
+    LinkSharedPtr ptr;
+    this->getLink(name, ptr);
     return ptr;
   };
   
   JointConstSharedPtr getJoint(const std::string& name) const
   {
-    JointConstSharedPtr ptr;
-    if (this->joints_.find(name) == this->joints_.end())
-      ptr.reset();
-    else
-      ptr = this->joints_.find(name)->second;
-    return ptr;
+    if (this->name_index_built_)
+    {
+      const int handle = this->joint_index_.find(name);
+      return handle < 0 ? JointConstSharedPtr() : this->joint_handles_[handle];
+    }
+    std::map<std::string, JointSharedPtr>::const_iterator joint = this->joints_.find(name);
+    return joint == this->joints_.end() ? JointConstSharedPtr() : joint->second;
   };
 
   ClusterConstSharedPtr getContainingCluster(const std::string &link_name) const
   {
-    ClusterConstSharedPtr ptr;
-    if (this->containing_cluster_.find(link_name) == this->containing_cluster_.end())
-      ptr.reset();
-    else
+    if (this->name_index_built_)
     {
-      const int i = this->containing_cluster_.find(link_name)->second;
-      ptr = this->clusters_.at(i);
+      const int handle = this->link_index_.find(link_name);
+      return handle < 0 ? ClusterConstSharedPtr() : this->link_cluster_handles_[handle];
     }
-    return ptr;
+    std::map<std::string, int>::const_iterator cluster = this->containing_cluster_.find(link_name);
+    return cluster == this->containing_cluster_.end() ? ClusterConstSharedPtr() : this->clusters_.at(cluster->second);
   };
 
   ConstraintConstSharedPtr getConstraint(const std::string& name) const
   {
-    ConstraintConstSharedPtr ptr;
-    if (this->constraints_.find(name) == this->constraints_.end())
-      ptr.reset();
-    else
-      ptr = this->constraints_.find(name)->second;
-    return ptr;
+    if (this->name_index_built_)
+    {
+      const int handle = this->constraint_index_.find(name);
+      return handle < 0 ? ConstraintConstSharedPtr() : this->constraint_handles_[handle];
+    }
+    std::map<std::string, ConstraintSharedPtr>::const_iterator constraint = this->constraints_.find(name);
+    return constraint == this->constraints_.end() ? ConstraintConstSharedPtr() : constraint->second;
   };
   
   
@@ -108,65 +123,192 @@ public:
   void clear()
   {
     name_.clear();
-    this->links_.clear();
+    this->clearNameIndex();
+    this->releaseTree();
     this->joints_.clear();
+    this->constraints_.clear();
     this->materials_.clear();
-    this->root_link_.reset();
   };
   
   /// non-const getLink()
   void getLink(const std::string& name, LinkSharedPtr &link) const
   {
-    LinkSharedPtr ptr;
-    if (this->links_.find(name) == this->links_.end())
-      ptr.reset();
-    else
-      ptr = this->links_.find(name)->second;
-    link = ptr;
+    if (this->name_index_built_)
+    {
+      const int handle = this->link_index_.find(name);
+      link = handle < 0 ? LinkSharedPtr() : this->link_handles_[handle];
+      return;
+    }
+    std::map<std::string, LinkSharedPtr>::const_iterator it = this->links_.find(name);
+    link = it == this->links_.end() ? LinkSharedPtr() : it->second;
   };
   
   /// non-const getMaterial()
   MaterialSharedPtr getMaterial(const std::string& name) const
   {
-    MaterialSharedPtr ptr;
-    if (this->materials_.find(name) == this->materials_.end())
-      ptr.reset();
-    else
-      ptr = this->materials_.find(name)->second;
-    return ptr;
+    if (this->name_index_built_)
+    {
+      const int handle = this->material_index_.find(name);
+      return handle < 0 ? MaterialSharedPtr() : this->material_handles_[handle];
+    }
+    std::map<std::string, MaterialSharedPtr>::const_iterator material = this->materials_.find(name);
+    return material == this->materials_.end() ? MaterialSharedPtr() : material->second;
+  };
+
+  /// \brief Build hashed name indices for links, joints, constraints and materials
+  ///
+  /// Afterwards the name based getters use a single hashed lookup, and a name
+  /// can be resolved once with get*Handle() into an integer handle that gives
+  /// access to the element with get*ByHandle() without any lookup or
+  /// reference count change.  Handles number the elements in name order and
+  /// stay valid until the next clear() or buildNameIndex().  The index is a
+  /// snapshot: call buildNameIndex() again after modifying links_, joints_,
+  /// constraints_ or materials_.  initTree() refreshes an existing index.
+  void buildNameIndex()
+  {
+    this->link_index_.clear();
+    this->link_index_.reserve(this->links_.size());
+    this->link_handles_.clear();
+    this->link_cluster_handles_.clear();
+    for (std::map<std::string, LinkSharedPtr>::const_iterator link = this->links_.begin(); link != this->links_.end(); link++)
+    {
+      this->link_index_.insert(link->first, static_cast<int>(this->link_handles_.size()));
+      this->link_handles_.push_back(link->second);
+      std::map<std::string, int>::const_iterator cluster = this->containing_cluster_.find(link->first);
+      std::map<int, ClusterSharedPtr>::const_iterator cluster_ptr;
+      if (cluster != this->containing_cluster_.end() &&
+          (cluster_ptr = this->clusters_.find(cluster->second)) != this->clusters_.end())
+        this->link_cluster_handles_.push_back(cluster_ptr->second);
+      else
+        this->link_cluster_handles_.push_back(ClusterSharedPtr());
+    }
+
+    this->joint_index_.clear();
+    this->joint_index_.reserve(this->joints_.size());
+    this->joint_handles_.clear();
+    for (std::map<std::string, JointSharedPtr>::const_iterator joint = this->joints_.begin(); joint != this->joints_.end(); joint++)
+    {
+      this->joint_index_.insert(joint->first, static_cast<int>(this->joint_handles_.size()));
+      this->joint_handles_.push_back(joint->second);
+    }
+
+    this->constraint_index_.clear();
+    this->constraint_index_.reserve(this->constraints_.size());
+    this->constraint_handles_.clear();
+    for (std::map<std::string, ConstraintSharedPtr>::const_iterator constraint = this->constraints_.begin(); constraint != this->constraints_.end(); constraint++)
+    {
+      this->constraint_index_.insert(constraint->first, static_cast<int>(this->constraint_handles_.size()));
+      this->constraint_handles_.push_back(constraint->second);
+    }
+
+    this->material_index_.clear();
+    this->material_index_.reserve(this->materials_.size());
+    this->material_handles_.clear();
+    for (std::map<std::string, MaterialSharedPtr>::const_iterator material = this->materials_.begin(); material != this->materials_.end(); material++)
+    {
+      this->material_index_.insert(material->first, static_cast<int>(this->material_handles_.size()));
+      this->material_handles_.push_back(material->second);
+    }
+
+    this->name_index_built_ = true;
+  };
+
+  bool hasNameIndex() const { return this->name_index_built_; };
+
+  /// handle of the named link, -1 if there is none.  Requires buildNameIndex()
+  int getLinkHandle(std::string_view name) const { return this->link_index_.find(name); };
+  /// handle of the named joint, -1 if there is none.  Requires buildNameIndex()
+  int getJointHandle(std::string_view name) const { return this->joint_index_.find(name); };
+  /// handle of the named constraint, -1 if there is none.  Requires buildNameIndex()
+  int getConstraintHandle(std::string_view name) const { return this->constraint_index_.find(name); };
+  /// handle of the named material, -1 if there is none.  Requires buildNameIndex()
+  int getMaterialHandle(std::string_view name) const { return this->material_index_.find(name); };
+
+  const LinkSharedPtr &getLinkByHandle(int handle) const { return this->link_handles_[handle]; };
+  const JointSharedPtr &getJointByHandle(int handle) const { return this->joint_handles_[handle]; };
+  const ConstraintSharedPtr &getConstraintByHandle(int handle) const { return this->constraint_handles_[handle]; };
+  const MaterialSharedPtr &getMaterialByHandle(int handle) const { return this->material_handles_[handle]; };
+  /// cluster containing the link with the given handle, empty before initTree()
+  const ClusterSharedPtr &getContainingClusterByHandle(int link_handle) const { return this->link_cluster_handles_[link_handle]; };
+
+  /// \brief Nearest common ancestor of two links
+  ///
+  /// Uses the ancestor table built by initTree(), so the query takes
+  /// O(log depth) and does not allocate.  A link counts as its own ancestor.
+  /// Returns an empty pointer if either link is unknown or the links are in
+  /// different trees.
+  LinkConstSharedPtr getNearestCommonAncestor(std::string_view link_a, std::string_view link_b) const
+  {
+    const int a = this->ancestor_index_.find(link_a);
+    const int b = this->ancestor_index_.find(link_b);
+    if (a < 0 || b < 0)
+    {
+      return LinkConstSharedPtr();
+    }
+    int child_a, child_b;
+    const int ancestor = this->nearestCommonAncestor(a, b, child_a, child_b);
+    return ancestor < 0 ? LinkConstSharedPtr() : this->ancestor_links_[ancestor];
   };
 
+  /// \deprecated initTree() now finds clusters itself with an iterative
+  /// Tarjan pass.  Kept for one release for code that ran Kosaraju's
+  /// algorithm with it: pushes the links reachable from link_name through
+  /// child and loop links onto finishing_order, in depth-first finishing order.
+  [[deprecated("initTree() computes the clusters; use getContainingCluster()")]]
   void dfsFirstPass(const std::string &link_name,
                     std::map<std::string, bool> &visited,
                     std::stack<std::string> &finishing_order)
   {
+    // (link name, next edge), the edges being child links followed by loop links
+    std::vector<std::pair<const std::string *, std::size_t> > stack;
     visited[link_name] = true;
-    for (LinkSharedPtr &child : this->links_[link_name]->child_links)
+    stack.push_back(std::make_pair(&link_name, std::size_t(0)));
+    while (!stack.empty())
     {
-      if (visited[child->name]) { continue; }
-      dfsFirstPass(child->name, visited, finishing_order);
-    }
-    for (LinkSharedPtr &loop_link : this->links_[link_name]->loop_links)
-    {
-      if (visited[loop_link->name]) { continue; }
-      dfsFirstPass(loop_link->name, visited, finishing_order);
+      const Link &link = *this->links_[*stack.back().first];
+      const std::size_t next = stack.back().second;
+      if (next < link.child_links.size() + link.loop_links.size())
+      {
+        ++stack.back().second;
+        const LinkSharedPtr &w = next < link.child_links.size() ? link.child_links[next]
+                                                                : link.loop_links[next - link.child_links.size()];
+        if (visited[w->name]) { continue; }
+        visited[w->name] = true;
+        stack.push_back(std::make_pair(&w->name, std::size_t(0)));
+        continue;
+      }
+      finishing_order.push(*stack.back().first);
+      stack.pop_back();
     }
-    finishing_order.push(link_name);
   }
 
+  /// \deprecated see dfsFirstPass(); appends the links reachable from
+  /// link_name in reverse_graph to scc, in depth-first preorder.
+  [[deprecated("initTree() computes the clusters; use getContainingCluster()")]]
   void dfsSecondPass(const std::map<std::string, std::vector<LinkSharedPtr>> &reverse_graph,
                   const std::string &link_name, std::map<std::string, bool> &visited,
                   std::vector<LinkSharedPtr> &scc)
   {
+    std::vector<std::pair<const std::vector<LinkSharedPtr> *, std::size_t> > stack;
     visited[link_name] = true;
     scc.push_back(this->links_[link_name]);
-    for (const LinkSharedPtr &reverse_child : reverse_graph.at(link_name))
+    stack.push_back(std::make_pair(&reverse_graph.at(link_name), std::size_t(0)));
+    while (!stack.empty())
     {
-      if (visited[reverse_child->name]) { continue; }
-      dfsSecondPass(reverse_graph, reverse_child->name, visited, scc);
+      const std::vector<LinkSharedPtr> &reverse_children = *stack.back().first;
+      if (stack.back().second == reverse_children.size())
+      {
+        stack.pop_back();
+        continue;
+      }
+      const LinkSharedPtr &w = reverse_children[stack.back().second++];
+      if (visited[w->name]) { continue; }
+      visited[w->name] = true;
+      scc.push_back(this->links_[w->name]);
+      stack.push_back(std::make_pair(&reverse_graph.at(w->name), std::size_t(0)));
     }
   }
-  
+
   void initTree(std::map<std::string, std::string> &parent_link_tree)
   {
     // loop through all joints, for every link, assign children links and children joints
@@ -211,19 +353,13 @@ public:
       }
     }
 
-    // loop through all constraints, for every link, assign loop links and ancestors
-    auto getSubchain = [](LinkSharedPtr link) -> std::vector<LinkSharedPtr>
-    {
-      std::vector<LinkSharedPtr> subchain;
-      while (link)
-      {
-        subchain.push_back(link);
-        link = link->getParent();
-      }
-      std::reverse(subchain.begin(), subchain.end());
-      return subchain;
-    };
+    // Number the links in name order and index their ancestors
+    const int num_links = static_cast<int>(this->links_.size());
+    const std::vector<LinkSharedPtr> &link_at = this->ancestor_links_;
+    std::unordered_map<const Link *, int> index_of;
+    this->indexAncestors(index_of);
 
+    // loop through all constraints, for every link, assign loop links and ancestors
     for (std::map<std::string, ConstraintSharedPtr>::iterator constraint = this->constraints_.begin();constraint != this->constraints_.end(); constraint++)
     {
       std::string predecessor_link_name = constraint->second->successor_link_name;
@@ -247,103 +383,199 @@ public:
         {
           throw ParseError("predecessor link [" + predecessor_link_name + "] of constraint [" + constraint->first + "] not found.  This is not valid according to the URDF spec. Every link you refer to from a constraint needs to be explicitly defined in the robot description. To fix this problem you can either remove this constraint [" + constraint->first + "] from your urdf file, or add \"<link name=\"" + predecessor_link_name + "\" />\" to your urdf file.");
         }
+        if (predecessor_link == successor_link)
+        {
+          throw ParseError("Constraint [" + constraint->first + "] connects link [" + predecessor_link_name + "] to itself");
+        }
 
         // set constraint for predecessor link
         predecessor_link->constraints.push_back(constraint->second);
 
-        // set loop links
-        std::vector<LinkSharedPtr> predecessor_subchain = getSubchain(predecessor_link);
-        std::vector<LinkSharedPtr> successor_subchain = getSubchain(successor_link);
-
-        LinkSharedPtr ancestor;
-        std::vector<LinkSharedPtr>::iterator predecessor_it = predecessor_subchain.begin();
-        std::vector<LinkSharedPtr>::iterator successor_it = successor_subchain.begin();
-        while (predecessor_it != predecessor_subchain.end() &&
-               successor_it != successor_subchain.end() &&
-               *predecessor_it == *successor_it)
+        // set loop links: each end is connected to the first link below the
+        // nearest common ancestor on the other end's branch, or to the
+        // ancestor itself if the other end is the ancestor
+        int predecessor_child, successor_child;
+        const int ancestor = this->nearestCommonAncestor(index_of.at(predecessor_link.get()),
+                                                         index_of.at(successor_link.get()),
+                                                         predecessor_child, successor_child);
+        if (ancestor < 0)
         {
-          ancestor = *predecessor_it;
-          predecessor_it++;
-          successor_it++;
+          throw ParseError("Constraint [" + constraint->first + "] connects links [" + predecessor_link_name + "] and [" + successor_link_name + "] which have no common ancestor");
         }
-        constraint->second->nearest_common_ancestor_name = ancestor->name;
-        predecessor_link->loop_links.push_back(*successor_it);
-        successor_link->loop_links.push_back(*predecessor_it);
+        constraint->second->nearest_common_ancestor_name = link_at[ancestor]->name;
+        predecessor_link->loop_links.push_back(link_at[successor_child < 0 ? ancestor : successor_child]);
+        successor_link->loop_links.push_back(link_at[predecessor_child < 0 ? ancestor : predecessor_child]);
 
       }
     }
 
     // Extract strongly connected components
     {
-      std::map<std::string, bool> visited;
-      std::stack<std::string> finishing_order;
-
-      // Build the reverse graph
-      std::map<std::string, std::vector<LinkSharedPtr>> reverse_link_graph;
-      for (std::map<std::string, LinkSharedPtr>::iterator link = this->links_.begin(); link != this->links_.end(); link++)
+      // Build the link graph (child links followed by loop links) and its
+      // reverse in compressed sparse row form.  Edge order matches the order
+      // the clusters have always been discovered in, so cluster ids and
+      // member order are deterministic.
+      std::vector<int> edge_offsets(num_links + 1, 0);
+      std::vector<int> reverse_offsets(num_links + 1, 0);
+      for (int v = 0; v < num_links; ++v)
       {
-        reverse_link_graph[link->second->name] = std::vector<LinkSharedPtr>();
+        edge_offsets[v + 1] = edge_offsets[v] +
+          static_cast<int>(link_at[v]->child_links.size() + link_at[v]->loop_links.size());
       }
-      for (std::map<std::string, LinkSharedPtr>::iterator link = this->links_.begin(); link != this->links_.end(); link++)
+      std::vector<int> edges(edge_offsets[num_links]);
+      for (int v = 0; v < num_links; ++v)
       {
-        for (LinkSharedPtr &child : link->second->child_links)
+        int e = edge_offsets[v];
+        for (const LinkSharedPtr &child : link_at[v]->child_links)
         {
-          reverse_link_graph[child->name].push_back(link->second);
+          edges[e++] = index_of.at(child.get());
         }
-        for (LinkSharedPtr &loop_link : link->second->loop_links)
+        for (const LinkSharedPtr &loop_link : link_at[v]->loop_links)
         {
-          reverse_link_graph[loop_link->name].push_back(link->second);
+          edges[e++] = index_of.at(loop_link.get());
         }
       }
-
-      // First Pass: Calculate finishing times
-      for (std::map<std::string, LinkSharedPtr>::iterator link = this->links_.begin(); link != this->links_.end(); link++)
+      for (int e = 0; e < edge_offsets[num_links]; ++e)
       {
-        if (visited[link->first]) { continue; }
-        dfsFirstPass(link->first, visited, finishing_order);
+        reverse_offsets[edges[e] + 1]++;
       }
-      visited.clear();
-
-      // Second Pass: Find strongly connected components
-      while (!finishing_order.empty())
+      for (int v = 0; v < num_links; ++v)
       {
-        std::string link_name = finishing_order.top();
-        finishing_order.pop();
-
-        if (visited[link_name]) { continue; }
+        reverse_offsets[v + 1] += reverse_offsets[v];
+      }
+      std::vector<int> reverse_edges(edges.size());
+      {
+        std::vector<int> fill(reverse_offsets.begin(), reverse_offsets.end() - 1);
+        for (int v = 0; v < num_links; ++v)
+        {
+          for (int e = edge_offsets[v]; e < edge_offsets[v + 1]; ++e)
+          {
+            reverse_edges[fill[edges[e]]++] = v;
+          }
+        }
+      }
 
-        std::vector<LinkSharedPtr> scc;
-        dfsSecondPass(reverse_link_graph, link_name, visited, scc);
+      // Iterative Tarjan.  Components complete in reverse topological order,
+      // so the cluster id of the k-th completed component is num_sccs - 1 - k.
+      std::vector<int> order(num_links, -1);
+      std::vector<int> lowlink(num_links, 0);
+      std::vector<int> component(num_links, -1);
+      std::vector<bool> on_stack(num_links, false);
+      std::vector<int> tarjan_stack;
+      std::vector<std::pair<int, int> > call_stack;
+      std::vector<int> component_root;
+      int next_order = 0;
+      for (int start = 0; start < num_links; ++start)
+      {
+        if (order[start] >= 0) { continue; }
+        order[start] = lowlink[start] = next_order++;
+        tarjan_stack.push_back(start);
+        on_stack[start] = true;
+        call_stack.push_back(std::make_pair(start, edge_offsets[start]));
+        while (!call_stack.empty())
+        {
+          const int v = call_stack.back().first;
+          if (call_stack.back().second < edge_offsets[v + 1])
+          {
+            const int w = edges[call_stack.back().second++];
+            if (order[w] < 0)
+            {
+              order[w] = lowlink[w] = next_order++;
+              tarjan_stack.push_back(w);
+              on_stack[w] = true;
+              call_stack.push_back(std::make_pair(w, edge_offsets[w]));
+            }
+            else if (on_stack[w])
+            {
+              lowlink[v] = std::min(lowlink[v], order[w]);
+            }
+            continue;
+          }
+
+          call_stack.pop_back();
+          if (lowlink[v] == order[v])
+          {
+            int w;
+            do
+            {
+              w = tarjan_stack.back();
+              tarjan_stack.pop_back();
+              on_stack[w] = false;
+              component[w] = static_cast<int>(component_root.size());
+            } while (w != v);
+            component_root.push_back(v);
+          }
+          if (!call_stack.empty())
+          {
+            const int u = call_stack.back().first;
+            lowlink[u] = std::min(lowlink[u], lowlink[v]);
+          }
+        }
+      }
 
-        // Create a new cluster
+      // Create the clusters.  Members are listed in depth-first preorder of
+      // the reverse graph from the component root.
+      const int num_components = static_cast<int>(component_root.size());
+      const int first_cluster_id = static_cast<int>(this->clusters_.size());
+      std::vector<int> cluster_of(num_links);
+      std::vector<bool> placed(num_links, false);
+      std::vector<std::pair<int, int> > dfs_stack;
+      for (int k = num_components - 1; k >= 0; --k)
+      {
         ClusterSharedPtr cluster;
         cluster.reset(new Cluster());
 
-        size_t cluster_id = this->clusters_.size();
+        const int cluster_id = first_cluster_id + (num_components - 1 - k);
         this->clusters_.insert(std::make_pair(cluster_id, cluster));
 
-        for (LinkSharedPtr &link : scc)
+        const int root = component_root[k];
+        placed[root] = true;
+        dfs_stack.push_back(std::make_pair(root, reverse_offsets[root]));
+        cluster->push_back(link_at[root]);
+        while (!dfs_stack.empty())
         {
-          cluster->push_back(link);
+          const int v = dfs_stack.back().first;
+          if (dfs_stack.back().second == reverse_offsets[v + 1])
+          {
+            dfs_stack.pop_back();
+            continue;
+          }
+          const int w = reverse_edges[dfs_stack.back().second++];
+          if (placed[w] || component[w] != k) { continue; }
+          placed[w] = true;
+          cluster->push_back(link_at[w]);
+          dfs_stack.push_back(std::make_pair(w, reverse_offsets[w]));
+        }
+
+        for (LinkSharedPtr &link : *cluster)
+        {
+          const int v = index_of.at(link.get());
+          cluster_of[v] = cluster_id;
           this->containing_cluster_.insert(std::make_pair(link->name, cluster_id));
         }
       }
 
       // Set parent and child clusters
-      for (std::map<int, ClusterSharedPtr>::iterator cluster = this->clusters_.begin(); cluster != this->clusters_.end(); cluster++)
+      for (int cluster_id = first_cluster_id; cluster_id < first_cluster_id + num_components; ++cluster_id)
       {
-        for (LinkSharedPtr &link : *cluster->second)
+        const ClusterSharedPtr &cluster = this->clusters_[cluster_id];
+        for (LinkSharedPtr &link : *cluster)
         {
           LinkSharedPtr parent_link = link->getParent();
           if (!parent_link) { continue; }
-          int parent_cluster_id = this->containing_cluster_[parent_link->name];
-          if (parent_cluster_id == cluster->first) { continue; }
-          cluster->second->setParent(this->clusters_[parent_cluster_id]);
-          this->clusters_[parent_cluster_id]->child_clusters.push_back(cluster->second);
+          const int parent_cluster_id = cluster_of[index_of.at(parent_link.get())];
+          if (parent_cluster_id == cluster_id) { continue; }
+          cluster->setParent(this->clusters_[parent_cluster_id]);
+          this->clusters_[parent_cluster_id]->child_clusters.push_back(cluster);
           break;
         }
       }
     }
+
+    if (this->name_index_built_)
+    {
+      this->buildNameIndex();
+    }
   }
 
   void initRoot(const std::map<std::string, std::string> &parent_link_tree)
@@ -394,8 +626,241 @@ public:
   /// \brief The root is always a link (the parent of the tree describing the robot)
   LinkSharedPtr root_link_;
 
+  /// \brief Rebuild the table behind getNearestCommonAncestor()
+  ///
+  /// initTree() does this itself.  Only needed for models whose links were
+  /// connected some other way, such as ModelSnapshot::toModel().
+  void initAncestorTable()
+  {
+    std::unordered_map<const Link *, int> index_of;
+    this->indexAncestors(index_of);
+  };
+
+private:
+  /// Number the links in name order into ancestor_links_, fill index_of
+  /// with those numbers and build the ancestor table
+  void indexAncestors(std::unordered_map<const Link *, int> &index_of)
+  {
+    const int num_links = static_cast<int>(this->links_.size());
+    this->ancestor_links_.clear();
+    this->ancestor_links_.reserve(num_links);
+    index_of.clear();
+    index_of.reserve(num_links);
+    this->ancestor_index_.clear();
+    this->ancestor_index_.reserve(num_links);
+    for (std::map<std::string, LinkSharedPtr>::iterator link = this->links_.begin(); link != this->links_.end(); link++)
+    {
+      index_of[link->second.get()] = static_cast<int>(this->ancestor_links_.size());
+      this->ancestor_index_.insert(link->first, static_cast<int>(this->ancestor_links_.size()));
+      this->ancestor_links_.push_back(link->second);
+    }
+    this->buildAncestorTable(index_of);
+  };
+
+  /// Depths and binary lifting table (the 2^k-th ancestor of every link) over
+  /// ancestor_links_
+  void buildAncestorTable(const std::unordered_map<const Link *, int> &index_of)
+  {
+    const int num_links = static_cast<int>(this->ancestor_links_.size());
+    std::vector<int> parent(num_links, -1);
+    this->link_depth_.assign(num_links, -1);
+    std::vector<int> order;
+    order.reserve(num_links);
+    for (int v = 0; v < num_links; ++v)
+    {
+      LinkSharedPtr parent_link = this->ancestor_links_[v]->getParent();
+      if (parent_link)
+      {
+        std::unordered_map<const Link *, int>::const_iterator p = index_of.find(parent_link.get());
+        if (p != index_of.end())
+        {
+          parent[v] = p->second;
+          continue;
+        }
+      }
+      this->link_depth_[v] = 0;
+      order.push_back(v);
+    }
+    int max_depth = 0;
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+      const int v = order[i];
+      for (const LinkSharedPtr &child : this->ancestor_links_[v]->child_links)
+      {
+        const int c = index_of.at(child.get());
+        if (this->link_depth_[c] >= 0 || parent[c] != v) { continue; }
+        this->link_depth_[c] = this->link_depth_[v] + 1;
+        max_depth = std::max(max_depth, this->link_depth_[c]);
+        order.push_back(c);
+      }
+    }
+    // links on a cycle of joints are not reachable from any root
+    for (int v = 0; v < num_links; ++v)
+    {
+      if (this->link_depth_[v] < 0)
+      {
+        this->link_depth_[v] = 0;
+        parent[v] = -1;
+      }
+    }
+
+    this->ancestor_levels_ = 1;
+    while ((1 << this->ancestor_levels_) <= max_depth)
+    {
+      this->ancestor_levels_++;
+    }
+    this->ancestor_table_.resize(static_cast<std::size_t>(this->ancestor_levels_) * num_links);
+    std::copy(parent.begin(), parent.end(), this->ancestor_table_.begin());
+    for (int k = 1; k < this->ancestor_levels_; ++k)
+    {
+      const int *up = this->ancestor_table_.data() + static_cast<std::size_t>(k - 1) * num_links;
+      int *next = this->ancestor_table_.data() + static_cast<std::size_t>(k) * num_links;
+      for (int v = 0; v < num_links; ++v)
+      {
+        next[v] = up[v] < 0 ? -1 : up[up[v]];
+      }
+    }
+  };
+
+  /// ancestor of v that is steps levels up
+  int ancestorAt(int v, int steps) const
+  {
+    const std::size_t num_links = this->ancestor_links_.size();
+    for (int k = 0; steps > 0 && v >= 0; ++k, steps >>= 1)
+    {
+      if (steps & 1)
+      {
+        v = this->ancestor_table_[k * num_links + v];
+      }
+    }
+    return v;
+  };
 
+  /// Nearest common ancestor of a and b, -1 if there is none.  child_a and
+  /// child_b are set to the links right below the ancestor on the way to a
+  /// and b, or -1 if a (respectively b) is the ancestor itself.
+  int nearestCommonAncestor(int a, int b, int &child_a, int &child_b) const
+  {
+    const std::size_t num_links = this->ancestor_links_.size();
+    const int depth_a = this->link_depth_[a];
+    const int depth_b = this->link_depth_[b];
+    if (depth_a > depth_b)
+    {
+      a = this->ancestorAt(a, depth_a - depth_b - 1);
+      if (this->ancestor_table_[a] == b)
+      {
+        child_a = a;
+        child_b = -1;
+        return b;
+      }
+      a = this->ancestor_table_[a];
+    }
+    else if (depth_b > depth_a)
+    {
+      b = this->ancestorAt(b, depth_b - depth_a - 1);
+      if (this->ancestor_table_[b] == a)
+      {
+        child_a = -1;
+        child_b = b;
+        return a;
+      }
+      b = this->ancestor_table_[b];
+    }
+    if (a == b)
+    {
+      child_a = child_b = -1;
+      return a;
+    }
+    for (int k = this->ancestor_levels_ - 1; k >= 0; --k)
+    {
+      const int up_a = this->ancestor_table_[k * num_links + a];
+      const int up_b = this->ancestor_table_[k * num_links + b];
+      if (up_a != up_b)
+      {
+        a = up_a;
+        b = up_b;
+      }
+    }
+    child_a = a;
+    child_b = b;
+    return this->ancestor_table_[a];
+  };
+
+  void clearAncestorTable()
+  {
+    this->ancestor_links_.clear();
+    this->ancestor_index_.clear();
+    this->link_depth_.clear();
+    this->ancestor_table_.clear();
+    this->ancestor_levels_ = 0;
+  };
+
+  /// Drop the links and clusters parents first.  A parent then never holds
+  /// the last reference to its children, so deep chains are not destroyed
+  /// recursively.
+  void releaseTree()
+  {
+    this->clearAncestorTable();
+    for (std::map<int, ClusterSharedPtr>::iterator cluster = this->clusters_.begin(); cluster != this->clusters_.end(); cluster++)
+    {
+      cluster->second.reset();
+    }
+    this->clusters_.clear();
+    this->containing_cluster_.clear();
+
+    std::vector<LinkSharedPtr> order;
+    order.reserve(this->links_.size());
+    for (std::map<std::string, LinkSharedPtr>::iterator link = this->links_.begin(); link != this->links_.end(); link++)
+    {
+      if (!link->second->getParent())
+      {
+        order.push_back(link->second);
+      }
+    }
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+      order.insert(order.end(), order[i]->child_links.begin(), order[i]->child_links.end());
+    }
+    this->root_link_.reset();
+    this->links_.clear();
+    for (LinkSharedPtr &link : order)
+    {
+      link.reset();
+    }
+  };
+
+  void clearNameIndex()
+  {
+    this->name_index_built_ = false;
+    this->link_index_.clear();
+    this->joint_index_.clear();
+    this->constraint_index_.clear();
+    this->material_index_.clear();
+    this->link_handles_.clear();
+    this->link_cluster_handles_.clear();
+    this->joint_handles_.clear();
+    this->constraint_handles_.clear();
+    this->material_handles_.clear();
+  };
 
+  bool name_index_built_ = false;
+  NameIndex link_index_;
+  NameIndex joint_index_;
+  NameIndex constraint_index_;
+  NameIndex material_index_;
+  std::vector<LinkSharedPtr> link_handles_;
+  std::vector<ClusterSharedPtr> link_cluster_handles_;
+  std::vector<JointSharedPtr> joint_handles_;
+  std::vector<ConstraintSharedPtr> constraint_handles_;
+  std::vector<MaterialSharedPtr> material_handles_;
+
+  /// links in name order, indexed like the ancestor table
+  std::vector<LinkSharedPtr> ancestor_links_;
+  NameIndex ancestor_index_;
+  std::vector<int> link_depth_;
+  /// ancestor_table_[k * ancestor_links_.size() + v] is the 2^k-th ancestor of v
+  std::vector<int> ancestor_table_;
+  int ancestor_levels_ = 0;
 };
 
 }
@@ -0,0 +1,1266 @@
+/* Relocatable binary snapshots of initialized models */
+
+#ifndef URDF_INTERFACE_MODEL_SNAPSHOT_H
+#define URDF_INTERFACE_MODEL_SNAPSHOT_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <urdf_model/compiled_model.h>
+#include <urdf_model/geometry_table.h>
+#include <urdf_model/mapped_file.h>
+#include <urdf_model/model.h>
+#include <urdf_model/name_index.h>
+#include <urdf_exception/exception.h>
+
+namespace urdf{
+
+/// \brief Read only, memory mapped image of a model after initTree() and initRoot()
+///
+/// write() stores the links, joints, constraints, clusters, materials and
+/// visual and collision elements of a model as arrays of fixed size records,
+/// followed by open addressing name tables and one block of string bytes.
+/// Records refer to each other by index and to strings by offset, so the
+/// image does not depend on where it is loaded.  open() maps a file and only
+/// validates its header; the records are then read in place through
+/// getLink(), getJoint() and friends, and names are resolved with one hashed
+/// probe through getLinkIndex() and friends.
+///
+/// Links are numbered like CompiledModel, in depth-first preorder from the
+/// root at index 0, and joint j is the parent joint of link j + 1.
+/// Constraints and materials keep the name order of ModelInterface and
+/// clusters keep their ids.  The tree as initTree() built it is stored
+/// alongside: child links, loop links, the constraints of every link,
+/// cluster members in their order, child clusters and the nearest common
+/// ancestor of every constraint.  toModel() rebuilds an equivalent
+/// ModelInterface from it without running initTree().
+///
+/// The file layout is
+///
+///   Header, then 8 byte aligned sections at the offsets the header lists
+///
+/// with integers and doubles in the byte order of the writing machine.
+/// open() rejects files of another byte order or version.  Only the header
+/// is checked on open; verify() checks the checksum and every index and
+/// string reference, call it before reading files from untrusted sources.
+class ModelSnapshot
+{
+public:
+  static const std::uint32_t VERSION = 1;
+  static const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+  /// position of a string in the string section
+  struct StringRef
+  {
+    std::uint32_t offset;
+    std::uint32_t size;
+  };
+
+  enum Section
+  {
+    LINKS,
+    JOINTS,
+    CONSTRAINTS,
+    CLUSTERS,
+    MATERIALS,
+    ELEMENTS,
+    /// link indices referred to by the begin / end ranges of the records
+    CHILDREN,
+    LOOP_LINKS,
+    LINK_CONSTRAINTS,
+    CLUSTER_LINKS,
+    CHILD_CLUSTERS,
+    /// name tables, power of two numbers of NameSlot
+    LINK_NAMES,
+    JOINT_NAMES,
+    CONSTRAINT_NAMES,
+    MATERIAL_NAMES,
+    STRINGS,
+    NUM_SECTIONS
+  };
+
+  struct SectionRecord
+  {
+    std::uint64_t offset;
+    std::uint64_t size;
+  };
+
+  struct Header
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    /// size of the whole file
+    std::uint64_t size;
+    /// FNV-1a of the bytes after the header
+    std::uint64_t checksum;
+    StringRef name;
+    /// materials 0 .. num_model_materials - 1 are ModelInterface::materials_,
+    /// the others belong to single visuals
+    std::uint32_t num_model_materials;
+    std::uint32_t reserved;
+    SectionRecord sections[NUM_SECTIONS];
+  };
+
+  enum LinkFlags
+  {
+    HAS_INERTIAL = 1
+  };
+
+  /// inertia is ixx, ixy, ixz, iyy, iyz, izz
+  struct LinkRecord
+  {
+    StringRef name;
+    std::int32_t parent;
+    std::int32_t parent_joint;
+    std::int32_t cluster;
+    std::uint32_t flags;
+    std::int32_t children_begin, children_end;
+    std::int32_t loop_links_begin, loop_links_end;
+    std::int32_t constraints_begin, constraints_end;
+    std::int32_t elements_begin, elements_end;
+    double inertial_origin[7];
+    double mass;
+    double inertia[6];
+  };
+
+  enum JointFlags
+  {
+    INDEPENDENT = 1,
+    HAS_DYNAMICS = 2,
+    HAS_LIMITS = 4,
+    HAS_SAFETY = 8,
+    HAS_CALIBRATION = 16,
+    HAS_RISING = 32,
+    HAS_FALLING = 64,
+    HAS_MIMIC = 128
+  };
+
+  /// the values of absent optional parts are zero
+  struct JointRecord
+  {
+    StringRef name;
+    StringRef mimic_joint;
+    std::int32_t type;
+    std::int32_t parent;
+    std::int32_t child;
+    std::uint32_t flags;
+    double axis[3];
+    double origin[7];
+    double damping, friction;
+    double lower, upper, effort, velocity;
+    double soft_upper_limit, soft_lower_limit, k_position, k_velocity;
+    double reference_position, rising, falling;
+    double mimic_offset, mimic_multiplier;
+  };
+
+  /// type, axis and the origins are only meaningful for LOOP constraints,
+  /// ratio only for COUPLING constraints
+  struct ConstraintRecord
+  {
+    StringRef name;
+    std::int32_t class_type;
+    std::int32_t type;
+    std::int32_t predecessor;
+    std::int32_t successor;
+    std::int32_t ancestor;
+    std::int32_t reserved;
+    double axis[3];
+    double successor_origin[7];
+    double predecessor_origin[7];
+    double ratio;
+  };
+
+  struct ClusterRecord
+  {
+    StringRef name;
+    std::int32_t parent;
+    std::int32_t links_begin, links_end;
+    std::int32_t children_begin, children_end;
+    std::int32_t reserved;
+  };
+
+  struct MaterialRecord
+  {
+    StringRef name;
+    StringRef texture_filename;
+    float color[4];
+  };
+
+  enum ElementKind
+  {
+    VISUAL,
+    COLLISION
+  };
+
+  /// geometry of an element without one
+  static const std::uint8_t NO_GEOMETRY = 0xff;
+
+  /// \brief a Visual or Collision
+  ///
+  /// size is the radius of a sphere, the dimensions of a box, the radius and
+  /// length of a cylinder and the scale of a mesh.  in_array is 0 for the
+  /// single Link::visual or Link::collision of a link without an array.
+  struct ElementRecord
+  {
+    StringRef name;
+    StringRef material_name;
+    StringRef mesh_filename;
+    std::int32_t link;
+    std::int32_t material;
+    std::uint8_t kind;
+    std::uint8_t geometry;
+    std::uint8_t in_array;
+    std::uint8_t reserved[5];
+    double origin[7];
+    double size[3];
+  };
+
+  /// an empty slot has value -1
+  struct NameSlot
+  {
+    std::uint64_t hash;
+    std::int32_t value;
+    std::int32_t reserved;
+  };
+
+  ModelSnapshot() { this->clear(); };
+  explicit ModelSnapshot(const std::string &filename) { this->open(filename); };
+
+  /// \brief write a snapshot of a model after initTree() and initRoot()
+  ///
+  /// Throws ParseError for models CompiledModel cannot compile and
+  /// std::runtime_error if out fails.
+  static void write(const ModelInterface &model, std::ostream &out)
+  {
+    const std::string image = build(model);
+    out.write(image.data(), image.size());
+    if (!out)
+    {
+      throw std::runtime_error("Failed to write the snapshot of model [" + model.getName() + "]");
+    }
+  };
+
+  static void writeFile(const ModelInterface &model, const std::string &filename)
+  {
+    std::ofstream out(filename.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+      throw std::runtime_error("Cannot create snapshot file [" + filename + "]");
+    }
+    write(model, out);
+  };
+
+  /// \brief map a snapshot file and validate its header
+  ///
+  /// Throws std::runtime_error if the file cannot be read and ParseError if
+  /// it is not a snapshot this version can read.  On Windows the file is
+  /// read into memory instead of mapped.
+  void open(const std::string &filename)
+  {
+    this->clear();
+    std::size_t size = 0;
+    std::shared_ptr<const char> storage = mapFile(filename, size);
+    if (size < sizeof(Header))
+    {
+      throw ParseError("Snapshot file [" + filename + "] is too small");
+    }
+    this->attach(storage.get(), size);
+    this->storage_ = storage;
+  };
+
+  /// \brief use a snapshot in memory without copying it
+  ///
+  /// data must be 8 byte aligned and outlive this object, or the next
+  /// clear(), open() or attach().
+  void attach(const void *data, std::size_t size)
+  {
+    this->clear();
+    if (reinterpret_cast<std::uintptr_t>(data) % 8 != 0)
+    {
+      throw ParseError("Snapshot data must be 8 byte aligned");
+    }
+    if (size < sizeof(Header))
+    {
+      throw ParseError("Snapshot of " + std::to_string(size) + " bytes is too small");
+    }
+    const Header &header = *static_cast<const Header *>(data);
+    if (std::memcmp(header.magic, "URDFSNAP", 8) != 0)
+    {
+      throw ParseError("Not a model snapshot");
+    }
+    if (header.byte_order != BYTE_ORDER_MARK)
+    {
+      throw ParseError("Model snapshot was written on a machine with another byte order");
+    }
+    if (header.version != VERSION)
+    {
+      throw ParseError("Unsupported model snapshot version " + std::to_string(header.version));
+    }
+    if (header.size != size)
+    {
+      throw ParseError("Model snapshot has " + std::to_string(size) + " bytes, its header says " +
+                       std::to_string(header.size));
+    }
+    static const std::size_t record_size[NUM_SECTIONS] = {
+      sizeof(LinkRecord), sizeof(JointRecord), sizeof(ConstraintRecord), sizeof(ClusterRecord),
+      sizeof(MaterialRecord), sizeof(ElementRecord), sizeof(std::int32_t), sizeof(std::int32_t),
+      sizeof(std::int32_t), sizeof(std::int32_t), sizeof(std::int32_t), sizeof(NameSlot),
+      sizeof(NameSlot), sizeof(NameSlot), sizeof(NameSlot), 1};
+    for (int s = 0; s < NUM_SECTIONS; ++s)
+    {
+      const SectionRecord &section = header.sections[s];
+      if (section.offset % 8 != 0 || section.offset < sizeof(Header) || section.offset > size ||
+          section.size > size - section.offset || section.size % record_size[s] != 0)
+      {
+        throw ParseError("Model snapshot section " + std::to_string(s) + " is out of bounds");
+      }
+      this->counts_[s] = static_cast<std::size_t>(section.size / record_size[s]);
+    }
+    for (int s = LINK_NAMES; s <= MATERIAL_NAMES; ++s)
+    {
+      if (this->counts_[s] == 0 || (this->counts_[s] & (this->counts_[s] - 1)) != 0)
+      {
+        throw ParseError("Model snapshot name table " + std::to_string(s) + " is not a power of two");
+      }
+    }
+    if (this->counts_[LINKS] == 0 || this->counts_[JOINTS] + 1 != this->counts_[LINKS] ||
+        header.num_model_materials > this->counts_[MATERIALS])
+    {
+      throw ParseError("Model snapshot has inconsistent counts");
+    }
+    this->data_ = static_cast<const char *>(data);
+    this->size_ = size;
+  };
+
+  bool isOpen() const { return this->data_ != nullptr; };
+
+  /// \brief check the checksum and that every index, enumerator and string is in range
+  ///
+  /// Linear in the size of the snapshot.  Returns false instead of throwing.
+  bool verify() const
+  {
+    if (!this->isOpen() || checksum(this->data_ + sizeof(Header), this->size_ - sizeof(Header)) !=
+                               this->getHeader().checksum)
+    {
+      return false;
+    }
+    const int num_links = static_cast<int>(this->getNumLinks());
+    const int num_joints = static_cast<int>(this->getNumJoints());
+    const int num_constraints = static_cast<int>(this->getNumConstraints());
+    const int num_clusters = static_cast<int>(this->getNumClusters());
+    const int num_materials = static_cast<int>(this->getNumMaterials());
+    auto in = [](int index, int lower, int count) { return index >= lower && index < count; };
+    auto range = [this](int begin, int end, Section s)
+    {
+      return begin >= 0 && begin <= end && static_cast<std::size_t>(end) <= this->counts_[s];
+    };
+    auto indices = [this, &in](Section s, int count)
+    {
+      const std::int32_t *values = this->section<std::int32_t>(s);
+      for (std::size_t k = 0; k < this->counts_[s]; ++k)
+      {
+        if (!in(values[k], 0, count)) return false;
+      }
+      return true;
+    };
+    if (!this->validString(this->getHeader().name) || !indices(CHILDREN, num_links) ||
+        !indices(LOOP_LINKS, num_links) || !indices(LINK_CONSTRAINTS, num_constraints) ||
+        !indices(CLUSTER_LINKS, num_links) || !indices(CHILD_CLUSTERS, num_clusters))
+    {
+      return false;
+    }
+    for (int i = 0; i < num_links; ++i)
+    {
+      const LinkRecord &link = this->getLink(i);
+      // parents precede their children, which the tree rebuild relies on
+      if (!this->validString(link.name) || (i == 0 ? link.parent != -1 || link.parent_joint != -1
+                                                   : !in(link.parent, 0, i) || link.parent_joint != i - 1) ||
+          !in(link.cluster, -1, num_clusters) || !range(link.children_begin, link.children_end, CHILDREN) ||
+          !range(link.loop_links_begin, link.loop_links_end, LOOP_LINKS) ||
+          !range(link.constraints_begin, link.constraints_end, LINK_CONSTRAINTS) ||
+          !range(link.elements_begin, link.elements_end, ELEMENTS))
+      {
+        return false;
+      }
+    }
+    for (int j = 0; j < num_joints; ++j)
+    {
+      const JointRecord &joint = this->getJoint(j);
+      if (!this->validString(joint.name) || !this->validString(joint.mimic_joint) ||
+          !in(joint.parent, 0, num_links) || joint.child != j + 1 ||
+          !in(joint.type, Joint::UNKNOWN, Joint::FIXED + 1))
+      {
+        return false;
+      }
+    }
+    for (int c = 0; c < num_constraints; ++c)
+    {
+      const ConstraintRecord &constraint = this->getConstraint(c);
+      if (!this->validString(constraint.name) || !in(constraint.predecessor, -1, num_links) ||
+          !in(constraint.successor, -1, num_links) || !in(constraint.ancestor, -1, num_links) ||
+          !in(constraint.class_type, Constraint::UNKNOWN, Constraint::COUPLING + 1) ||
+          !in(constraint.type, LoopConstraint::UNKNOWN, LoopConstraint::FIXED + 1))
+      {
+        return false;
+      }
+    }
+    for (int c = 0; c < num_clusters; ++c)
+    {
+      const ClusterRecord &cluster = this->getCluster(c);
+      if (!this->validString(cluster.name) || !in(cluster.parent, -1, num_clusters) ||
+          !range(cluster.links_begin, cluster.links_end, CLUSTER_LINKS) ||
+          !range(cluster.children_begin, cluster.children_end, CHILD_CLUSTERS))
+      {
+        return false;
+      }
+    }
+    for (int m = 0; m < num_materials; ++m)
+    {
+      const MaterialRecord &material = this->getMaterial(m);
+      if (!this->validString(material.name) || !this->validString(material.texture_filename))
+      {
+        return false;
+      }
+    }
+    for (std::size_t e = 0; e < this->getNumElements(); ++e)
+    {
+      const ElementRecord &element = this->getElement(static_cast<int>(e));
+      if (!this->validString(element.name) || !this->validString(element.material_name) ||
+          !this->validString(element.mesh_filename) || !in(element.link, 0, num_links) ||
+          !in(element.material, -1, num_materials) || element.kind > COLLISION ||
+          (element.geometry != NO_GEOMETRY && element.geometry > Geometry::MESH))
+      {
+        return false;
+      }
+    }
+    const int counts[4] = {num_links, num_joints, num_constraints, num_materials};
+    for (int s = LINK_NAMES; s <= MATERIAL_NAMES; ++s)
+    {
+      const NameSlot *slots = this->section<NameSlot>(static_cast<Section>(s));
+      bool has_empty_slot = false;
+      for (std::size_t k = 0; k < this->counts_[s]; ++k)
+      {
+        if (!in(slots[k].value, -1, counts[s - LINK_NAMES]))
+        {
+          return false;
+        }
+        has_empty_slot |= slots[k].value < 0;
+      }
+      // lookups of missing names stop at an empty slot
+      if (!has_empty_slot)
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  const Header &getHeader() const { return *reinterpret_cast<const Header *>(this->data_); };
+  std::string_view getName() const { return this->getString(this->getHeader().name); };
+
+  std::size_t getNumLinks() const { return this->counts_[LINKS]; };
+  std::size_t getNumJoints() const { return this->counts_[JOINTS]; };
+  std::size_t getNumConstraints() const { return this->counts_[CONSTRAINTS]; };
+  std::size_t getNumClusters() const { return this->counts_[CLUSTERS]; };
+  std::size_t getNumMaterials() const { return this->counts_[MATERIALS]; };
+  std::size_t getNumElements() const { return this->counts_[ELEMENTS]; };
+
+  const LinkRecord &getLink(int i) const { return this->section<LinkRecord>(LINKS)[i]; };
+  const JointRecord &getJoint(int j) const { return this->section<JointRecord>(JOINTS)[j]; };
+  const ConstraintRecord &getConstraint(int c) const { return this->section<ConstraintRecord>(CONSTRAINTS)[c]; };
+  const ClusterRecord &getCluster(int c) const { return this->section<ClusterRecord>(CLUSTERS)[c]; };
+  const MaterialRecord &getMaterial(int m) const { return this->section<MaterialRecord>(MATERIALS)[m]; };
+  const ElementRecord &getElement(int e) const { return this->section<ElementRecord>(ELEMENTS)[e]; };
+
+  std::string_view getString(const StringRef &ref) const
+  {
+    return std::string_view(this->section<char>(STRINGS) + ref.offset, ref.size);
+  };
+
+  /// index of the named link, joint, constraint or material, -1 if there is none
+  int getLinkIndex(std::string_view name) const { return this->findName<LinkRecord>(LINK_NAMES, LINKS, name); };
+  int getJointIndex(std::string_view name) const { return this->findName<JointRecord>(JOINT_NAMES, JOINTS, name); };
+  int getConstraintIndex(std::string_view name) const
+  {
+    return this->findName<ConstraintRecord>(CONSTRAINT_NAMES, CONSTRAINTS, name);
+  };
+  int getMaterialIndex(std::string_view name) const
+  {
+    return this->findName<MaterialRecord>(MATERIAL_NAMES, MATERIALS, name);
+  };
+
+  /// the ranges of a LinkRecord or ClusterRecord as pointers into their sections
+  const int *childrenBegin(int i) const { return this->section<std::int32_t>(CHILDREN) + this->getLink(i).children_begin; };
+  const int *childrenEnd(int i) const { return this->section<std::int32_t>(CHILDREN) + this->getLink(i).children_end; };
+  const int *loopLinksBegin(int i) const { return this->section<std::int32_t>(LOOP_LINKS) + this->getLink(i).loop_links_begin; };
+  const int *loopLinksEnd(int i) const { return this->section<std::int32_t>(LOOP_LINKS) + this->getLink(i).loop_links_end; };
+  const int *linkConstraintsBegin(int i) const
+  {
+    return this->section<std::int32_t>(LINK_CONSTRAINTS) + this->getLink(i).constraints_begin;
+  };
+  const int *linkConstraintsEnd(int i) const
+  {
+    return this->section<std::int32_t>(LINK_CONSTRAINTS) + this->getLink(i).constraints_end;
+  };
+  const int *clusterLinksBegin(int c) const { return this->section<std::int32_t>(CLUSTER_LINKS) + this->getCluster(c).links_begin; };
+  const int *clusterLinksEnd(int c) const { return this->section<std::int32_t>(CLUSTER_LINKS) + this->getCluster(c).links_end; };
+  const int *childClustersBegin(int c) const
+  {
+    return this->section<std::int32_t>(CHILD_CLUSTERS) + this->getCluster(c).children_begin;
+  };
+  const int *childClustersEnd(int c) const
+  {
+    return this->section<std::int32_t>(CHILD_CLUSTERS) + this->getCluster(c).children_end;
+  };
+
+  static Pose toPose(const double *p) { return Pose(Vector3(p[0], p[1], p[2]), Rotation(p[3], p[4], p[5], p[6])); };
+
+  /// \brief rebuild the model the snapshot was written from
+  ///
+  /// Fills links_, joints_, constraints_, materials_, clusters_,
+  /// containing_cluster_ and root_link_ and connects the tree as initTree()
+  /// would, then builds the ancestor table.  A link with a visual or
+  /// collision array gets its first element as Link::visual or
+  /// Link::collision.
+  void toModel(ModelInterface &model) const
+  {
+    if (!this->isOpen())
+    {
+      throw ParseError("No model snapshot is open");
+    }
+    model.clear();
+    model.name_ = std::string(this->getName());
+
+    std::vector<MaterialSharedPtr> materials(this->getNumMaterials());
+    for (std::size_t m = 0; m < materials.size(); ++m)
+    {
+      const MaterialRecord &record = this->getMaterial(static_cast<int>(m));
+      materials[m].reset(new Material());
+      materials[m]->name = std::string(this->getString(record.name));
+      materials[m]->texture_filename = std::string(this->getString(record.texture_filename));
+      materials[m]->color.r = record.color[0];
+      materials[m]->color.g = record.color[1];
+      materials[m]->color.b = record.color[2];
+      materials[m]->color.a = record.color[3];
+      if (m < this->getHeader().num_model_materials)
+      {
+        model.materials_.insert(std::make_pair(materials[m]->name, materials[m]));
+      }
+    }
+
+    const std::size_t num_links = this->getNumLinks();
+    std::vector<LinkSharedPtr> links(num_links);
+    for (std::size_t i = 0; i < num_links; ++i)
+    {
+      const LinkRecord &record = this->getLink(static_cast<int>(i));
+      links[i].reset(new Link());
+      Link &link = *links[i];
+      link.name = std::string(this->getString(record.name));
+      if (record.flags & HAS_INERTIAL)
+      {
+        link.inertial.reset(new Inertial());
+        link.inertial->origin = toPose(record.inertial_origin);
+        link.inertial->mass = record.mass;
+        link.inertial->ixx = record.inertia[0];
+        link.inertial->ixy = record.inertia[1];
+        link.inertial->ixz = record.inertia[2];
+        link.inertial->iyy = record.inertia[3];
+        link.inertial->iyz = record.inertia[4];
+        link.inertial->izz = record.inertia[5];
+      }
+      for (int e = record.elements_begin; e < record.elements_end; ++e)
+      {
+        this->addElement(this->getElement(e), materials, link);
+      }
+      model.links_.insert(std::make_pair(link.name, links[i]));
+    }
+
+    std::vector<JointSharedPtr> joints(this->getNumJoints());
+    for (std::size_t j = 0; j < joints.size(); ++j)
+    {
+      joints[j] = this->makeJoint(this->getJoint(static_cast<int>(j)));
+      model.joints_.insert(std::make_pair(joints[j]->name, joints[j]));
+    }
+
+    std::vector<ConstraintSharedPtr> constraints(this->getNumConstraints());
+    for (std::size_t c = 0; c < constraints.size(); ++c)
+    {
+      constraints[c] = this->makeConstraint(this->getConstraint(static_cast<int>(c)));
+      model.constraints_.insert(std::make_pair(constraints[c]->name, constraints[c]));
+    }
+
+    // the tree, children in their original order
+    for (std::size_t i = 0; i < num_links; ++i)
+    {
+      Link &link = *links[i];
+      const LinkRecord &record = this->getLink(static_cast<int>(i));
+      if (record.parent >= 0)
+      {
+        link.setParent(links[record.parent]);
+        link.parent_joint = joints[record.parent_joint];
+      }
+      for (const int *child = this->childrenBegin(static_cast<int>(i)); child != this->childrenEnd(static_cast<int>(i)); ++child)
+      {
+        link.child_links.push_back(links[*child]);
+        link.child_joints.push_back(joints[this->getLink(*child).parent_joint]);
+      }
+      for (const int *loop = this->loopLinksBegin(static_cast<int>(i)); loop != this->loopLinksEnd(static_cast<int>(i)); ++loop)
+      {
+        link.loop_links.push_back(links[*loop]);
+      }
+      for (const int *c = this->linkConstraintsBegin(static_cast<int>(i)); c != this->linkConstraintsEnd(static_cast<int>(i)); ++c)
+      {
+        link.constraints.push_back(constraints[*c]);
+      }
+    }
+
+    const int num_clusters = static_cast<int>(this->getNumClusters());
+    for (int c = 0; c < num_clusters; ++c)
+    {
+      ClusterSharedPtr cluster(new Cluster());
+      cluster->name = std::string(this->getString(this->getCluster(c).name));
+      for (const int *l = this->clusterLinksBegin(c); l != this->clusterLinksEnd(c); ++l)
+      {
+        cluster->push_back(links[*l]);
+        model.containing_cluster_.insert(std::make_pair(links[*l]->name, c));
+      }
+      model.clusters_.insert(std::make_pair(c, cluster));
+    }
+    for (int c = 0; c < num_clusters; ++c)
+    {
+      const ClusterSharedPtr &cluster = model.clusters_[c];
+      if (this->getCluster(c).parent >= 0)
+      {
+        cluster->setParent(model.clusters_[this->getCluster(c).parent]);
+      }
+      for (const int *child = this->childClustersBegin(c); child != this->childClustersEnd(c); ++child)
+      {
+        cluster->child_clusters.push_back(model.clusters_[*child]);
+      }
+    }
+
+    model.root_link_ = links[0];
+    model.initAncestorTable();
+  };
+
+  /// unmap the file, if any
+  void clear()
+  {
+    this->storage_.reset();
+    this->data_ = nullptr;
+    this->size_ = 0;
+    std::fill(this->counts_, this->counts_ + NUM_SECTIONS, 0);
+  };
+
+  /// FNV-1a over bytes, the checksum of the header
+  static std::uint64_t checksum(const char *data, std::size_t size)
+  {
+    return NameIndex::hash(std::string_view(data, size));
+  };
+
+private:
+  template <typename T>
+  const T *section(Section s) const
+  {
+    return reinterpret_cast<const T *>(this->data_ + this->getHeader().sections[s].offset);
+  };
+
+  bool validString(const StringRef &ref) const
+  {
+    return ref.offset <= this->counts_[STRINGS] && ref.size <= this->counts_[STRINGS] - ref.offset;
+  };
+
+  template <typename Record>
+  int findName(Section table, Section records, std::string_view name) const
+  {
+    const NameSlot *slots = this->section<NameSlot>(table);
+    const Record *values = this->section<Record>(records);
+    const std::uint64_t h = NameIndex::hash(name);
+    const std::size_t mask = this->counts_[table] - 1;
+    std::size_t slot = static_cast<std::size_t>(h) & mask;
+    // bounded so a full table in an unverified snapshot cannot loop forever
+    for (std::size_t probe = 0; probe <= mask; ++probe, slot = (slot + 1) & mask)
+    {
+      if (slots[slot].value < 0)
+      {
+        return -1;
+      }
+      if (slots[slot].hash == h && this->getString(values[slots[slot].value].name) == name)
+      {
+        return slots[slot].value;
+      }
+    }
+    return -1;
+  };
+
+  void addElement(const ElementRecord &record, const std::vector<MaterialSharedPtr> &materials, Link &link) const
+  {
+    GeometrySharedPtr geometry;
+    switch (record.geometry)
+    {
+      case Geometry::SPHERE:
+      {
+        SphereSharedPtr sphere(new Sphere());
+        sphere->radius = record.size[0];
+        geometry = sphere;
+        break;
+      }
+      case Geometry::BOX:
+      {
+        BoxSharedPtr box(new Box());
+        box->dim = Vector3(record.size[0], record.size[1], record.size[2]);
+        geometry = box;
+        break;
+      }
+      case Geometry::CYLINDER:
+      {
+        CylinderSharedPtr cylinder(new Cylinder());
+        cylinder->radius = record.size[0];
+        cylinder->length = record.size[1];
+        geometry = cylinder;
+        break;
+      }
+      case Geometry::MESH:
+      {
+        MeshSharedPtr mesh(new Mesh());
+        mesh->filename = std::string(this->getString(record.mesh_filename));
+        mesh->scale = Vector3(record.size[0], record.size[1], record.size[2]);
+        geometry = mesh;
+        break;
+      }
+    }
+    if (record.kind == VISUAL)
+    {
+      VisualSharedPtr visual(new Visual());
+      visual->name = std::string(this->getString(record.name));
+      visual->origin = toPose(record.origin);
+      visual->geometry = geometry;
+      visual->material_name = std::string(this->getString(record.material_name));
+      if (record.material >= 0)
+      {
+        visual->material = materials[record.material];
+      }
+      if (record.in_array)
+      {
+        link.visual_array.push_back(visual);
+      }
+      if (!link.visual)
+      {
+        link.visual = visual;
+      }
+    }
+    else
+    {
+      CollisionSharedPtr collision(new Collision());
+      collision->name = std::string(this->getString(record.name));
+      collision->origin = toPose(record.origin);
+      collision->geometry = geometry;
+      if (record.in_array)
+      {
+        link.collision_array.push_back(collision);
+      }
+      if (!link.collision)
+      {
+        link.collision = collision;
+      }
+    }
+  };
+
+  JointSharedPtr makeJoint(const JointRecord &record) const
+  {
+    JointSharedPtr joint(new Joint());
+    joint->name = std::string(this->getString(record.name));
+    joint->type = static_cast<decltype(joint->type)>(record.type);
+    joint->axis = Vector3(record.axis[0], record.axis[1], record.axis[2]);
+    joint->parent_to_joint_origin_transform = toPose(record.origin);
+    joint->parent_link_name = std::string(this->getString(this->getLink(record.parent).name));
+    joint->child_link_name = std::string(this->getString(this->getLink(record.child).name));
+    joint->independent = (record.flags & INDEPENDENT) != 0;
+    if (record.flags & HAS_DYNAMICS)
+    {
+      joint->dynamics.reset(new JointDynamics());
+      joint->dynamics->damping = record.damping;
+      joint->dynamics->friction = record.friction;
+    }
+    if (record.flags & HAS_LIMITS)
+    {
+      joint->limits.reset(new JointLimits());
+      joint->limits->lower = record.lower;
+      joint->limits->upper = record.upper;
+      joint->limits->effort = record.effort;
+      joint->limits->velocity = record.velocity;
+    }
+    if (record.flags & HAS_SAFETY)
+    {
+      joint->safety.reset(new JointSafety());
+      joint->safety->soft_upper_limit = record.soft_upper_limit;
+      joint->safety->soft_lower_limit = record.soft_lower_limit;
+      joint->safety->k_position = record.k_position;
+      joint->safety->k_velocity = record.k_velocity;
+    }
+    if (record.flags & HAS_CALIBRATION)
+    {
+      joint->calibration.reset(new JointCalibration());
+      joint->calibration->reference_position = record.reference_position;
+      if (record.flags & HAS_RISING)
+      {
+        joint->calibration->rising.reset(new double(record.rising));
+      }
+      if (record.flags & HAS_FALLING)
+      {
+        joint->calibration->falling.reset(new double(record.falling));
+      }
+    }
+    if (record.flags & HAS_MIMIC)
+    {
+      joint->mimic.reset(new JointMimic());
+      joint->mimic->joint_name = std::string(this->getString(record.mimic_joint));
+      joint->mimic->offset = record.mimic_offset;
+      joint->mimic->multiplier = record.mimic_multiplier;
+    }
+    return joint;
+  };
+
+  ConstraintSharedPtr makeConstraint(const ConstraintRecord &record) const
+  {
+    ConstraintSharedPtr constraint;
+    if (record.class_type == Constraint::LOOP)
+    {
+      LoopConstraintSharedPtr loop(new LoopConstraint());
+      loop->type = static_cast<decltype(loop->type)>(record.type);
+      loop->axis = Vector3(record.axis[0], record.axis[1], record.axis[2]);
+      loop->successor_to_constraint_origin_transform = toPose(record.successor_origin);
+      loop->predecessor_to_constraint_origin_transform = toPose(record.predecessor_origin);
+      constraint = loop;
+    }
+    else if (record.class_type == Constraint::COUPLING)
+    {
+      CouplingConstraintSharedPtr coupling(new CouplingConstraint());
+      coupling->ratio = record.ratio;
+      constraint = coupling;
+    }
+    else
+    {
+      constraint.reset(new Constraint());
+    }
+    constraint->name = std::string(this->getString(record.name));
+    auto link_name = [this](int i) { return i < 0 ? std::string() : std::string(this->getString(this->getLink(i).name)); };
+    constraint->predecessor_link_name = link_name(record.predecessor);
+    constraint->successor_link_name = link_name(record.successor);
+    constraint->nearest_common_ancestor_name = link_name(record.ancestor);
+    return constraint;
+  };
+
+  static void fromPose(const Pose &pose, double *p)
+  {
+    p[0] = pose.position.x;
+    p[1] = pose.position.y;
+    p[2] = pose.position.z;
+    p[3] = pose.rotation.x;
+    p[4] = pose.rotation.y;
+    p[5] = pose.rotation.z;
+    p[6] = pose.rotation.w;
+  };
+
+  /// collects the strings of a snapshot while it is written
+  class StringWriter
+  {
+  public:
+    StringRef add(std::string_view value)
+    {
+      if (this->data.size() + value.size() > 0xffffffffu)
+      {
+        throw ParseError("Model snapshot strings exceed 4 GiB");
+      }
+      const StringRef ref = {static_cast<std::uint32_t>(this->data.size()), static_cast<std::uint32_t>(value.size())};
+      this->data.append(value.data(), value.size());
+      return ref;
+    };
+
+    std::string data;
+  };
+
+  /// name table over count records whose i-th name is name(i)
+  template <typename NameOf>
+  static std::vector<NameSlot> buildNameTable(std::size_t count, NameOf name)
+  {
+    std::size_t capacity = 16;
+    while (capacity < 2 * count)
+    {
+      capacity *= 2;
+    }
+    std::vector<NameSlot> slots(capacity, NameSlot{0, -1, 0});
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const std::uint64_t h = NameIndex::hash(name(i));
+      std::size_t slot = static_cast<std::size_t>(h) & (capacity - 1);
+      while (slots[slot].value >= 0)
+      {
+        slot = (slot + 1) & (capacity - 1);
+      }
+      slots[slot].hash = h;
+      slots[slot].value = static_cast<std::int32_t>(i);
+    }
+    return slots;
+  };
+
+  template <typename T>
+  static void appendSection(std::string &image, Header &header, Section s, const T *data, std::size_t count)
+  {
+    image.append((8 - image.size() % 8) % 8, '\0');
+    header.sections[s].offset = image.size();
+    header.sections[s].size = count * sizeof(T);
+    image.append(reinterpret_cast<const char *>(data), count * sizeof(T));
+  };
+
+  template <typename T>
+  static void appendSection(std::string &image, Header &header, Section s, const std::vector<T> &records)
+  {
+    appendSection(image, header, s, records.data(), records.size());
+  };
+
+  static std::string build(const ModelInterface &model)
+  {
+    const CompiledModel compiled(model);
+    if (compiled.getNumJoints() != model.joints_.size())
+    {
+      throw ParseError("Cannot snapshot model [" + model.getName() + "]: " +
+                       std::to_string(model.joints_.size() - compiled.getNumJoints()) +
+                       " joints are not the parent joint of any link");
+    }
+    for (std::size_t c = 0; c < compiled.getNumClusters(); ++c)
+    {
+      if (model.clusters_.find(static_cast<int>(c)) == model.clusters_.end())
+      {
+        throw ParseError("Cannot snapshot model [" + model.getName() + "]: cluster ids are not contiguous");
+      }
+    }
+    const std::size_t num_links = compiled.getNumLinks();
+    std::unordered_map<const Link *, int> link_index;
+    for (std::size_t i = 0; i < num_links; ++i)
+    {
+      link_index[compiled.source_links[i].get()] = static_cast<int>(i);
+    }
+    std::unordered_map<const Constraint *, int> constraint_index;
+    for (std::size_t c = 0; c < compiled.getNumConstraints(); ++c)
+    {
+      constraint_index[compiled.source_constraints[c].get()] = static_cast<int>(c);
+    }
+
+    StringWriter strings;
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "URDFSNAP", 8);
+    header.version = VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.name = strings.add(model.getName());
+
+    // materials of the model first, then those only a visual holds
+    std::vector<MaterialRecord> materials;
+    std::unordered_map<const Material *, int> material_index;
+    auto add_material = [&](const Material &material)
+    {
+      MaterialRecord record;
+      std::memset(&record, 0, sizeof(record));
+      record.name = strings.add(material.name);
+      record.texture_filename = strings.add(material.texture_filename);
+      record.color[0] = material.color.r;
+      record.color[1] = material.color.g;
+      record.color[2] = material.color.b;
+      record.color[3] = material.color.a;
+      material_index[&material] = static_cast<int>(materials.size());
+      materials.push_back(record);
+    };
+    for (std::map<std::string, MaterialSharedPtr>::const_iterator m = model.materials_.begin();
+         m != model.materials_.end(); ++m)
+    {
+      add_material(*m->second);
+    }
+    header.num_model_materials = static_cast<std::uint32_t>(materials.size());
+
+    std::vector<LinkRecord> links(num_links);
+    std::vector<ElementRecord> elements;
+    std::vector<std::int32_t> loop_links, link_constraints;
+    for (std::size_t i = 0; i < num_links; ++i)
+    {
+      const Link &link = *compiled.source_links[i];
+      LinkRecord &record = links[i];
+      std::memset(&record, 0, sizeof(record));
+      record.name = strings.add(link.name);
+      record.parent = compiled.link_parent[i];
+      record.parent_joint = compiled.link_parent_joint[i];
+      record.cluster = compiled.link_cluster[i];
+      record.children_begin = compiled.child_offsets[i];
+      record.children_end = compiled.child_offsets[i + 1];
+      if (link.inertial)
+      {
+        record.flags |= HAS_INERTIAL;
+        fromPose(link.inertial->origin, record.inertial_origin);
+        record.mass = link.inertial->mass;
+        const double inertia[6] = {link.inertial->ixx, link.inertial->ixy, link.inertial->ixz,
+                                   link.inertial->iyy, link.inertial->iyz, link.inertial->izz};
+        std::copy(inertia, inertia + 6, record.inertia);
+      }
+
+      record.loop_links_begin = static_cast<std::int32_t>(loop_links.size());
+      for (const LinkSharedPtr &loop_link : link.loop_links)
+      {
+        loop_links.push_back(link_index.at(loop_link.get()));
+      }
+      record.loop_links_end = static_cast<std::int32_t>(loop_links.size());
+      record.constraints_begin = static_cast<std::int32_t>(link_constraints.size());
+      for (const ConstraintSharedPtr &constraint : link.constraints)
+      {
+        link_constraints.push_back(constraint_index.at(constraint.get()));
+      }
+      record.constraints_end = static_cast<std::int32_t>(link_constraints.size());
+
+      record.elements_begin = static_cast<std::int32_t>(elements.size());
+      auto add_element = [&](const Pose &origin, const std::string &name, const GeometrySharedPtr &geometry,
+                             ElementKind kind, bool in_array) -> ElementRecord &
+      {
+        ElementRecord element;
+        std::memset(&element, 0, sizeof(element));
+        element.name = strings.add(name);
+        element.link = static_cast<std::int32_t>(i);
+        element.material = -1;
+        element.kind = static_cast<std::uint8_t>(kind);
+        element.in_array = in_array;
+        element.geometry = NO_GEOMETRY;
+        fromPose(origin, element.origin);
+        if (geometry)
+        {
+          const Shape shape = toShape(*geometry);
+          element.geometry = static_cast<std::uint8_t>(shape.index());
+          if (const SphereShape *sphere = std::get_if<SphereShape>(&shape))
+          {
+            element.size[0] = sphere->radius;
+          }
+          else if (const BoxShape *box = std::get_if<BoxShape>(&shape))
+          {
+            element.size[0] = box->dim.x;
+            element.size[1] = box->dim.y;
+            element.size[2] = box->dim.z;
+          }
+          else if (const CylinderShape *cylinder = std::get_if<CylinderShape>(&shape))
+          {
+            element.size[0] = cylinder->radius;
+            element.size[1] = cylinder->length;
+          }
+          else if (const MeshShape *mesh = std::get_if<MeshShape>(&shape))
+          {
+            element.mesh_filename = strings.add(mesh->filename);
+            element.size[0] = mesh->scale.x;
+            element.size[1] = mesh->scale.y;
+            element.size[2] = mesh->scale.z;
+          }
+        }
+        elements.push_back(element);
+        return elements.back();
+      };
+      auto add_visual = [&](const Visual &visual, bool in_array)
+      {
+        ElementRecord &element = add_element(visual.origin, visual.name, visual.geometry, VISUAL, in_array);
+        element.material_name = strings.add(visual.material_name);
+        if (visual.material)
+        {
+          std::unordered_map<const Material *, int>::const_iterator m = material_index.find(visual.material.get());
+          if (m == material_index.end())
+          {
+            add_material(*visual.material);
+            m = material_index.find(visual.material.get());
+          }
+          element.material = m->second;
+        }
+      };
+      if (link.visual_array.empty() && link.visual)
+      {
+        add_visual(*link.visual, false);
+      }
+      for (const VisualSharedPtr &visual : link.visual_array)
+      {
+        add_visual(*visual, true);
+      }
+      if (link.collision_array.empty() && link.collision)
+      {
+        add_element(link.collision->origin, link.collision->name, link.collision->geometry, COLLISION, false);
+      }
+      for (const CollisionSharedPtr &collision : link.collision_array)
+      {
+        add_element(collision->origin, collision->name, collision->geometry, COLLISION, true);
+      }
+      record.elements_end = static_cast<std::int32_t>(elements.size());
+    }
+
+    std::vector<JointRecord> joints(compiled.getNumJoints());
+    for (std::size_t j = 0; j < joints.size(); ++j)
+    {
+      const Joint &joint = *compiled.source_joints[j];
+      JointRecord &record = joints[j];
+      std::memset(&record, 0, sizeof(record));
+      record.name = strings.add(joint.name);
+      record.type = joint.type;
+      record.parent = compiled.joint_parent[j];
+      record.child = compiled.joint_child[j];
+      record.flags = joint.independent ? INDEPENDENT : 0;
+      record.axis[0] = joint.axis.x;
+      record.axis[1] = joint.axis.y;
+      record.axis[2] = joint.axis.z;
+      fromPose(joint.parent_to_joint_origin_transform, record.origin);
+      if (joint.dynamics)
+      {
+        record.flags |= HAS_DYNAMICS;
+        record.damping = joint.dynamics->damping;
+        record.friction = joint.dynamics->friction;
+      }
+      if (joint.limits)
+      {
+        record.flags |= HAS_LIMITS;
+        record.lower = joint.limits->lower;
+        record.upper = joint.limits->upper;
+        record.effort = joint.limits->effort;
+        record.velocity = joint.limits->velocity;
+      }
+      if (joint.safety)
+      {
+        record.flags |= HAS_SAFETY;
+        record.soft_upper_limit = joint.safety->soft_upper_limit;
+        record.soft_lower_limit = joint.safety->soft_lower_limit;
+        record.k_position = joint.safety->k_position;
+        record.k_velocity = joint.safety->k_velocity;
+      }
+      if (joint.calibration)
+      {
+        record.flags |= HAS_CALIBRATION;
+        record.reference_position = joint.calibration->reference_position;
+        if (joint.calibration->rising)
+        {
+          record.flags |= HAS_RISING;
+          record.rising = *joint.calibration->rising;
+        }
+        if (joint.calibration->falling)
+        {
+          record.flags |= HAS_FALLING;
+          record.falling = *joint.calibration->falling;
+        }
+      }
+      if (joint.mimic)
+      {
+        record.flags |= HAS_MIMIC;
+        record.mimic_joint = strings.add(joint.mimic->joint_name);
+        record.mimic_offset = joint.mimic->offset;
+        record.mimic_multiplier = joint.mimic->multiplier;
+      }
+    }
+
+    std::vector<ConstraintRecord> constraints(compiled.getNumConstraints());
+    for (std::size_t c = 0; c < constraints.size(); ++c)
+    {
+      const Constraint &constraint = *compiled.source_constraints[c];
+      ConstraintRecord &record = constraints[c];
+      std::memset(&record, 0, sizeof(record));
+      record.name = strings.add(constraint.name);
+      record.class_type = constraint.class_type;
+      record.predecessor = compiled.constraint_predecessor[c];
+      record.successor = compiled.constraint_successor[c];
+      record.ancestor = compiled.constraint_ancestor[c];
+      if (const LoopConstraint *loop = dynamic_cast<const LoopConstraint *>(&constraint))
+      {
+        record.type = loop->type;
+        record.axis[0] = loop->axis.x;
+        record.axis[1] = loop->axis.y;
+        record.axis[2] = loop->axis.z;
+        fromPose(loop->successor_to_constraint_origin_transform, record.successor_origin);
+        fromPose(loop->predecessor_to_constraint_origin_transform, record.predecessor_origin);
+      }
+      if (const CouplingConstraint *coupling = dynamic_cast<const CouplingConstraint *>(&constraint))
+      {
+        record.ratio = coupling->ratio;
+      }
+    }
+
+    // child clusters in id order, the order initTree() links them in
+    const std::size_t num_clusters = compiled.getNumClusters();
+    std::vector<ClusterRecord> clusters(num_clusters);
+    std::vector<std::int32_t> child_clusters;
+    for (std::size_t c = 0; c < num_clusters; ++c)
+    {
+      ClusterRecord &record = clusters[c];
+      std::memset(&record, 0, sizeof(record));
+      record.name = strings.add(model.clusters_.at(static_cast<int>(c))->name);
+      record.parent = compiled.cluster_parent[c];
+      record.links_begin = compiled.cluster_link_offsets[c];
+      record.links_end = compiled.cluster_link_offsets[c + 1];
+      record.children_begin = static_cast<std::int32_t>(child_clusters.size());
+      for (std::size_t child = 0; child < num_clusters; ++child)
+      {
+        if (compiled.cluster_parent[child] == static_cast<int>(c))
+        {
+          child_clusters.push_back(static_cast<std::int32_t>(child));
+        }
+      }
+      record.children_end = static_cast<std::int32_t>(child_clusters.size());
+    }
+
+    auto name_of = [&strings](const StringRef &ref) { return std::string_view(strings.data).substr(ref.offset, ref.size); };
+    const std::vector<NameSlot> link_names =
+      buildNameTable(links.size(), [&](std::size_t i) { return name_of(links[i].name); });
+    const std::vector<NameSlot> joint_names =
+      buildNameTable(joints.size(), [&](std::size_t j) { return name_of(joints[j].name); });
+    const std::vector<NameSlot> constraint_names =
+      buildNameTable(constraints.size(), [&](std::size_t c) { return name_of(constraints[c].name); });
+    const std::vector<NameSlot> material_names =
+      buildNameTable(header.num_model_materials, [&](std::size_t m) { return name_of(materials[m].name); });
+
+    std::string image(sizeof(Header), '\0');
+    appendSection(image, header, LINKS, links);
+    appendSection(image, header, JOINTS, joints);
+    appendSection(image, header, CONSTRAINTS, constraints);
+    appendSection(image, header, CLUSTERS, clusters);
+    appendSection(image, header, MATERIALS, materials);
+    appendSection(image, header, ELEMENTS, elements);
+    appendSection(image, header, CHILDREN, compiled.children.data(), compiled.children.size());
+    appendSection(image, header, LOOP_LINKS, loop_links);
+    appendSection(image, header, LINK_CONSTRAINTS, link_constraints);
+    appendSection(image, header, CLUSTER_LINKS, compiled.cluster_links.data(), compiled.cluster_links.size());
+    appendSection(image, header, CHILD_CLUSTERS, child_clusters);
+    appendSection(image, header, LINK_NAMES, link_names);
+    appendSection(image, header, JOINT_NAMES, joint_names);
+    appendSection(image, header, CONSTRAINT_NAMES, constraint_names);
+    appendSection(image, header, MATERIAL_NAMES, material_names);
+    appendSection(image, header, STRINGS, strings.data.data(), strings.data.size());
+    image.append((8 - image.size() % 8) % 8, '\0');
+    header.size = image.size();
+    header.checksum = checksum(image.data() + sizeof(Header), image.size() - sizeof(Header));
+    std::memcpy(&image[0], &header, sizeof(Header));
+    return image;
+  };
+
+  /// keeps a mapped file alive, empty for attach()
+  std::shared_ptr<const char> storage_;
+  const char *data_;
+  std::size_t size_;
+  std::size_t counts_[NUM_SECTIONS];
+};
+
+static_assert(std::is_trivially_copyable<ModelSnapshot::Header>::value && sizeof(ModelSnapshot::Header) % 8 == 0 &&
+              sizeof(ModelSnapshot::LinkRecord) % 8 == 0 && sizeof(ModelSnapshot::JointRecord) % 8 == 0 &&
+              sizeof(ModelSnapshot::ConstraintRecord) % 8 == 0 && sizeof(ModelSnapshot::ClusterRecord) % 8 == 0 &&
+              sizeof(ModelSnapshot::MaterialRecord) % 8 == 0 && sizeof(ModelSnapshot::ElementRecord) % 8 == 0 &&
+              sizeof(ModelSnapshot::NameSlot) % 8 == 0,
+              "Model snapshot records must keep 8 byte alignment");
+
+}
+
+#endif
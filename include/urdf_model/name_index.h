@@ -0,0 +1,161 @@
+/* Hashed name lookup used by ModelInterface and CompiledModel */
+
+#ifndef URDF_INTERFACE_NAME_INDEX_H
+#define URDF_INTERFACE_NAME_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace urdf{
+
+/// \brief Names stored back to back in a single buffer
+class StringTable
+{
+public:
+  StringTable() { this->clear(); };
+
+  std::size_t size() const { return this->offsets_.size() - 1; };
+
+  std::string_view operator[](std::size_t i) const
+  {
+    return std::string_view(this->data_).substr(this->offsets_[i], this->offsets_[i + 1] - this->offsets_[i]);
+  };
+
+  void push_back(std::string_view name)
+  {
+    this->data_.append(name.data(), name.size());
+    this->offsets_.push_back(static_cast<std::uint32_t>(this->data_.size()));
+  };
+
+  void clear()
+  {
+    this->data_.clear();
+    this->offsets_.assign(1, 0);
+  };
+
+private:
+  std::string data_;
+  std::vector<std::uint32_t> offsets_;
+};
+
+/// \brief Open addressing hash table from names to non-negative integers
+///
+/// Keys are copied into the index, their 64 bit hashes are stored next to
+/// the values so a probe only compares strings when the hashes match.
+/// Lookups take a std::string_view and never allocate.
+class NameIndex
+{
+public:
+  NameIndex() { this->clear(); };
+
+  /// FNV-1a, the same hash is used for insertion and lookup
+  static std::uint64_t hash(std::string_view name)
+  {
+    std::uint64_t h = 14695981039346656037ULL;
+    for (char c : name)
+    {
+      h ^= static_cast<unsigned char>(c);
+      h *= 1099511628211ULL;
+    }
+    return h;
+  };
+
+  std::size_t size() const { return this->values_.size(); };
+
+  /// make room for n names without rehashing
+  void reserve(std::size_t n)
+  {
+    std::size_t capacity = 16;
+    while (capacity < 2 * n)
+    {
+      capacity *= 2;
+    }
+    if (capacity > this->slots_.size())
+    {
+      this->rehash(capacity);
+    }
+  };
+
+  /// add a name, returns false (and keeps the old value) if it is already present
+  bool insert(std::string_view name, int value)
+  {
+    if (2 * (this->size() + 1) > this->slots_.size())
+    {
+      this->rehash(2 * this->slots_.size());
+    }
+    const std::uint64_t h = hash(name);
+    std::size_t slot = this->probe(name, h);
+    if (this->slots_[slot].key >= 0)
+    {
+      return false;
+    }
+    this->slots_[slot].hash = h;
+    this->slots_[slot].key = static_cast<int>(this->keys_.size());
+    this->keys_.push_back(name);
+    this->values_.push_back(value);
+    return true;
+  };
+
+  /// value stored for name, -1 if there is none
+  int find(std::string_view name) const
+  {
+    const Slot &slot = this->slots_[this->probe(name, hash(name))];
+    return slot.key >= 0 ? this->values_[slot.key] : -1;
+  };
+
+  void clear()
+  {
+    this->slots_.assign(16, Slot());
+    this->keys_.clear();
+    this->values_.clear();
+  };
+
+private:
+  struct Slot
+  {
+    Slot() : hash(0), key(-1) {}
+    std::uint64_t hash;
+    int key;
+  };
+
+  /// slot holding name, or the empty slot where it would be inserted
+  std::size_t probe(std::string_view name, std::uint64_t h) const
+  {
+    const std::size_t mask = this->slots_.size() - 1;
+    std::size_t slot = static_cast<std::size_t>(h) & mask;
+    while (this->slots_[slot].key >= 0 &&
+           (this->slots_[slot].hash != h || this->keys_[this->slots_[slot].key] != name))
+    {
+      slot = (slot + 1) & mask;
+    }
+    return slot;
+  };
+
+  void rehash(std::size_t capacity)
+  {
+    this->slots_.assign(capacity, Slot());
+    const std::size_t mask = capacity - 1;
+    for (std::size_t k = 0; k < this->keys_.size(); ++k)
+    {
+      const std::uint64_t h = hash(this->keys_[k]);
+      std::size_t slot = static_cast<std::size_t>(h) & mask;
+      while (this->slots_[slot].key >= 0)
+      {
+        slot = (slot + 1) & mask;
+      }
+      this->slots_[slot].hash = h;
+      this->slots_[slot].key = static_cast<int>(k);
+    }
+  };
+
+  std::vector<Slot> slots_;
+  StringTable keys_;
+  std::vector<int> values_;
+};
+
+}
+
+#endif
@@ -0,0 +1,114 @@
+/* Forward kinematics of many joint configurations across a ThreadPool */
+
+#ifndef URDF_INTERFACE_PARALLEL_KINEMATICS_H
+#define URDF_INTERFACE_PARALLEL_KINEMATICS_H
+
+#include <algorithm>
+#include <vector>
+
+#include <urdf_model/compiled_model.h>
+#include <urdf_model/forward_kinematics.h>
+#include <urdf_model/thread_pool.h>
+
+namespace urdf{
+
+/// \brief Link poses for batches of joint configurations
+///
+/// Configuration c is read from q + c * getNumPositions() and its poses are
+/// written to out + c * (number of output links), so a batch is one pair of
+/// contiguous caller owned arrays.  Configurations are split across the
+/// ThreadPool in grains of grain_size; every configuration is computed by
+/// ForwardKinematics::compute(), so results do not depend on the number of
+/// threads.
+///
+/// The first computeBatch() with a given pool sizes one scratch pose array
+/// per pool thread for the selected link overload, later calls with pools no
+/// larger do not allocate.  A ParallelForwardKinematics must not run two
+/// batches at once.
+class ParallelForwardKinematics
+{
+public:
+  ParallelForwardKinematics() { this->clear(); };
+  explicit ParallelForwardKinematics(const CompiledModel &model) { this->init(model); };
+
+  std::size_t getNumLinks() const { return this->kinematics_.getNumLinks(); };
+  std::size_t getNumPositions() const { return this->kinematics_.getNumPositions(); };
+
+  void init(const CompiledModel &model)
+  {
+    this->clear();
+    this->kinematics_.init(model);
+  };
+
+  /// write the poses of all getNumLinks() links of every configuration
+  void computeBatch(ThreadPool &pool, std::size_t num_configurations, const double *q, Pose *out) const
+  {
+    const std::size_t nq = this->getNumPositions();
+    const std::size_t num_links = this->getNumLinks();
+    const ForwardKinematics &kinematics = this->kinematics_;
+    pool.parallelFor(num_configurations, this->grain_size,
+                     [&kinematics, q, out, nq, num_links](std::size_t, std::size_t begin, std::size_t end)
+    {
+      for (std::size_t c = begin; c < end; ++c)
+      {
+        kinematics.compute(q + c * nq, out + c * num_links);
+      }
+    });
+  };
+
+  /// \brief write the poses of links[0 .. num_selected) of every configuration
+  ///
+  /// For collision checking and end effector queries that only need a few
+  /// links, the full pose set goes to per thread scratch space and only the
+  /// selected links reach out.
+  void computeBatch(ThreadPool &pool, std::size_t num_configurations, const double *q,
+                    const int *links, std::size_t num_selected, Pose *out)
+  {
+    const std::size_t nq = this->getNumPositions();
+    const std::size_t num_links = this->getNumLinks();
+    if (this->scratch_.size() < pool.getNumThreads())
+    {
+      this->scratch_.resize(pool.getNumThreads());
+    }
+    for (std::size_t t = 0; t < pool.getNumThreads(); ++t)
+    {
+      this->scratch_[t].resize(num_links);
+    }
+    const ForwardKinematics &kinematics = this->kinematics_;
+    std::vector<std::vector<Pose> > &scratch = this->scratch_;
+    pool.parallelFor(num_configurations, this->grain_size,
+                     [&kinematics, &scratch, q, links, num_selected, out, nq](std::size_t thread, std::size_t begin,
+                                                                              std::size_t end)
+    {
+      Pose *poses = scratch[thread].data();
+      for (std::size_t c = begin; c < end; ++c)
+      {
+        kinematics.compute(q + c * nq, poses);
+        Pose *selected = out + c * num_selected;
+        for (std::size_t k = 0; k < num_selected; ++k)
+        {
+          selected[k] = poses[links[k]];
+        }
+      }
+    });
+  };
+
+  void clear()
+  {
+    this->kinematics_.clear();
+    this->scratch_.clear();
+    this->grain_size = 64;
+  };
+
+  /// configurations a thread takes from its range at a time
+  std::size_t grain_size;
+
+private:
+  ForwardKinematics kinematics_;
+  /// all link poses of one configuration, per pool thread
+  std::vector<std::vector<Pose> > scratch_;
+};
+
+}
+
+#endif
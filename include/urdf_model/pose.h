@@ -41,6 +41,8 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 #include <urdf_exception/exception.h>
@@ -51,49 +53,92 @@ namespace urdf{
 class Vector3
 {
 public:
-  Vector3(double _x,double _y, double _z) {this->x=_x;this->y=_y;this->z=_z;};
-  Vector3() {this->clear();};
+  constexpr Vector3(double _x,double _y, double _z) noexcept : x(_x), y(_y), z(_z) {};
+  constexpr Vector3() noexcept : x(0.0), y(0.0), z(0.0) {};
   double x;
   double y;
   double z;
 
-  void clear() {this->x=this->y=this->z=0.0;};
+  constexpr void clear() noexcept {this->x=this->y=this->z=0.0;};
   void init(const std::string &vector_str)
   {
     this->clear();
-    std::vector<std::string> pieces;
-    std::vector<double> xyz;
-    urdf::split_string( pieces, vector_str, " ");
-    for (unsigned int i = 0; i < pieces.size(); ++i){
-      if (pieces[i] != ""){
-        try {
-          xyz.push_back(strToDouble(pieces[i].c_str()));
-        } catch(std::runtime_error &) {
-          throw ParseError("Unable to parse component [" + pieces[i] + "] to a double (while parsing a vector value)");
-        }
-      }
-    }
+    double xyz[3];
+    std::string_view bad_token;
+    const int count = urdf::parseDoubles(vector_str, xyz, bad_token);
+    if (count < 0)
+      throw ParseError("Unable to parse component [" + std::string(bad_token) + "] to a double (while parsing a vector value)");
 
-    if (xyz.size() != 3)
-      throw ParseError("Parser found " + std::to_string(xyz.size())  + " elements but 3 expected while parsing vector [" + vector_str + "]");
+    if (count != 3)
+      throw ParseError("Parser found " + std::to_string(count)  + " elements but 3 expected while parsing vector [" + vector_str + "]");
 
     this->x = xyz[0];
     this->y = xyz[1];
     this->z = xyz[2];
   }
 
-  Vector3 operator+(Vector3 vec)
+  constexpr Vector3 operator+(const Vector3 &vec) const noexcept
   {
     return Vector3(this->x+vec.x,this->y+vec.y,this->z+vec.z);
   };
+  constexpr Vector3 operator-(const Vector3 &vec) const noexcept
+  {
+    return Vector3(this->x-vec.x,this->y-vec.y,this->z-vec.z);
+  };
+  constexpr Vector3 operator-() const noexcept
+  {
+    return Vector3(-this->x,-this->y,-this->z);
+  };
+  constexpr Vector3 operator*(double s) const noexcept
+  {
+    return Vector3(this->x*s,this->y*s,this->z*s);
+  };
+  constexpr Vector3 operator/(double s) const noexcept
+  {
+    return Vector3(this->x/s,this->y/s,this->z/s);
+  };
+  constexpr Vector3 &operator+=(const Vector3 &vec) noexcept
+  {
+    this->x += vec.x; this->y += vec.y; this->z += vec.z;
+    return *this;
+  };
+  constexpr Vector3 &operator-=(const Vector3 &vec) noexcept
+  {
+    this->x -= vec.x; this->y -= vec.y; this->z -= vec.z;
+    return *this;
+  };
+  constexpr Vector3 &operator*=(double s) noexcept
+  {
+    this->x *= s; this->y *= s; this->z *= s;
+    return *this;
+  };
+
+  constexpr double dot(const Vector3 &vec) const noexcept
+  {
+    return this->x*vec.x+this->y*vec.y+this->z*vec.z;
+  };
+  constexpr Vector3 cross(const Vector3 &vec) const noexcept
+  {
+    return Vector3(this->y*vec.z-this->z*vec.y,
+                   this->z*vec.x-this->x*vec.z,
+                   this->x*vec.y-this->y*vec.x);
+  };
+  constexpr double squaredNorm() const noexcept { return this->dot(*this); };
+  /// not constexpr, std::sqrt is not constexpr before C++26
+  double norm() const noexcept { return std::sqrt(this->squaredNorm()); };
 };
 
+constexpr Vector3 operator*(double s, const Vector3 &vec) noexcept
+{
+  return vec * s;
+}
+
 class Rotation
 {
 public:
-  Rotation(double _x,double _y, double _z, double _w) {this->x=_x;this->y=_y;this->z=_z;this->w=_w;};
-  Rotation() {this->clear();};
-  void getQuaternion(double &quat_x,double &quat_y,double &quat_z, double &quat_w) const
+  constexpr Rotation(double _x,double _y, double _z, double _w) noexcept : x(_x), y(_y), z(_z), w(_w) {};
+  constexpr Rotation() noexcept : x(0.0), y(0.0), z(0.0), w(1.0) {};
+  constexpr void getQuaternion(double &quat_x,double &quat_y,double &quat_z, double &quat_w) const noexcept
   {
     quat_x = this->x;
     quat_y = this->y;
@@ -164,9 +209,9 @@ public:
     setFromRPY(rpy.x, rpy.y, rpy.z);
   }
 
-  void clear() { this->x=this->y=this->z=0.0;this->w=1.0; }
+  constexpr void clear() noexcept { this->x=this->y=this->z=0.0;this->w=1.0; }
 
-  void normalize()
+  void normalize() noexcept
   {
     const double squared_norm =
       this->x * this->x +
@@ -200,7 +245,7 @@ public:
   };
 
   // Multiplication operator (copied from gazebo)
-  Rotation operator*( const Rotation &qt ) const
+  constexpr Rotation operator*( const Rotation &qt ) const noexcept
   {
     Rotation c;
 
@@ -212,26 +257,26 @@ public:
     return c;
   };
   /// Rotate a vector using the quaternion
-  Vector3 operator*(Vector3 vec) const
+  constexpr Vector3 operator*(const Vector3 &vec) const noexcept
   {
-    Rotation tmp;
-    Vector3 result;
-
-    tmp.w = 0.0;
-    tmp.x = vec.x;
-    tmp.y = vec.y;
-    tmp.z = vec.z;
-
-    tmp = (*this) * (tmp * this->GetInverse());
-
-    result.x = tmp.x;
-    result.y = tmp.y;
-    result.z = tmp.z;
-
-    return result;
+    // Same result as q * v * q^-1 without the two quaternion products:
+    // v' = v + w t + q x t with t = 2 (q x v) / |q|^2
+    const double norm = this->w*this->w+this->x*this->x+this->y*this->y+this->z*this->z;
+    if (norm <= 0.0)
+    {
+      return Vector3(0.0, 0.0, 0.0);
+    }
+    const double s = 2.0 / norm;
+    const double tx = s * (this->y * vec.z - this->z * vec.y);
+    const double ty = s * (this->z * vec.x - this->x * vec.z);
+    const double tz = s * (this->x * vec.y - this->y * vec.x);
+
+    return Vector3(vec.x + this->w * tx + (this->y * tz - this->z * ty),
+                   vec.y + this->w * ty + (this->z * tx - this->x * tz),
+                   vec.z + this->w * tz + (this->x * ty - this->y * tx));
   };
   // Get the inverse of this quaternion
-  Rotation GetInverse() const
+  constexpr Rotation GetInverse() const noexcept
   {
     Rotation q;
 
@@ -254,18 +299,41 @@ public:
 class Pose
 {
 public:
-  Pose() { this->clear(); };
+  constexpr Pose() noexcept : position(), rotation() {};
+  constexpr Pose(const Vector3 &_position, const Rotation &_rotation) noexcept
+    : position(_position), rotation(_rotation) {};
 
   Vector3  position;
   Rotation rotation;
 
-  void clear()
+  constexpr void clear() noexcept
   {
     this->position.clear();
     this->rotation.clear();
   };
+
+  /// Compose transforms: (a * b) maps frame b coordinates to the frame a is expressed in
+  constexpr Pose operator*(const Pose &pose) const noexcept
+  {
+    return Pose(this->position + this->rotation * pose.position, this->rotation * pose.rotation);
+  };
+  /// Transform a point
+  constexpr Vector3 operator*(const Vector3 &vec) const noexcept
+  {
+    return this->position + this->rotation * vec;
+  };
+  constexpr Pose inverse() const noexcept
+  {
+    const Rotation inv = this->rotation.GetInverse();
+    return Pose(-(inv * this->position), inv);
+  };
 };
 
+static_assert(std::is_trivially_copyable<Vector3>::value &&
+              std::is_trivially_copyable<Rotation>::value &&
+              std::is_trivially_copyable<Pose>::value,
+              "pose types must stay trivially copyable");
+
 }
 
 #endif
@@ -0,0 +1,324 @@
+/* Batched structure-of-arrays kernels for Pose, Rotation and Vector3 */
+
+#ifndef URDF_INTERFACE_POSE_BATCH_H
+#define URDF_INTERFACE_POSE_BATCH_H
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include <urdf_model/pose.h>
+#include <urdf_model/simd.h>
+
+namespace urdf{
+
+/// \brief n poses stored as one array per component
+class PoseArray
+{
+public:
+  PoseArray() { this->clear(); };
+  explicit PoseArray(std::size_t n) { this->resize(n); };
+
+  std::vector<double> px, py, pz;
+  std::vector<double> qx, qy, qz, qw;
+
+  std::size_t size() const { return this->px.size(); };
+
+  /// new poses are identities
+  void resize(std::size_t n)
+  {
+    this->px.resize(n, 0.0);
+    this->py.resize(n, 0.0);
+    this->pz.resize(n, 0.0);
+    this->qx.resize(n, 0.0);
+    this->qy.resize(n, 0.0);
+    this->qz.resize(n, 0.0);
+    this->qw.resize(n, 1.0);
+  };
+
+  Pose get(std::size_t i) const
+  {
+    Pose pose;
+    pose.position = Vector3(this->px[i], this->py[i], this->pz[i]);
+    pose.rotation = Rotation(this->qx[i], this->qy[i], this->qz[i], this->qw[i]);
+    return pose;
+  };
+
+  void set(std::size_t i, const Pose &pose)
+  {
+    this->px[i] = pose.position.x;
+    this->py[i] = pose.position.y;
+    this->pz[i] = pose.position.z;
+    this->qx[i] = pose.rotation.x;
+    this->qy[i] = pose.rotation.y;
+    this->qz[i] = pose.rotation.z;
+    this->qw[i] = pose.rotation.w;
+  };
+
+  void clear()
+  {
+    this->resize(0);
+  };
+};
+
+namespace detail{
+
+/// Rotation matrix (row major) and translation applied by transformPoints
+struct AffineTransform
+{
+  explicit AffineTransform(const Pose &pose)
+  {
+    const Rotation &q = pose.rotation;
+    const double norm = q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w;
+    // as in Rotation::operator*(Vector3), q need not be normalized
+    const double s = norm > 0.0 ? 2.0 / norm : 0.0;
+    const double d = norm > 0.0 ? 1.0 : 0.0;
+    m[0] = d - s * (q.y * q.y + q.z * q.z);
+    m[1] = s * (q.x * q.y - q.z * q.w);
+    m[2] = s * (q.x * q.z + q.y * q.w);
+    m[3] = s * (q.x * q.y + q.z * q.w);
+    m[4] = d - s * (q.x * q.x + q.z * q.z);
+    m[5] = s * (q.y * q.z - q.x * q.w);
+    m[6] = s * (q.x * q.z - q.y * q.w);
+    m[7] = s * (q.y * q.z + q.x * q.w);
+    m[8] = d - s * (q.x * q.x + q.y * q.y);
+    t[0] = pose.position.x;
+    t[1] = pose.position.y;
+    t[2] = pose.position.z;
+  }
+
+  double m[9];
+  double t[3];
+};
+
+inline void transformPointsScalar(const AffineTransform &a, std::size_t begin, std::size_t n,
+                                  const double *x, const double *y, const double *z,
+                                  double *out_x, double *out_y, double *out_z)
+{
+  for (std::size_t i = begin; i < n; ++i)
+  {
+    const double vx = x[i], vy = y[i], vz = z[i];
+    out_x[i] = a.m[0] * vx + a.m[1] * vy + a.m[2] * vz + a.t[0];
+    out_y[i] = a.m[3] * vx + a.m[4] * vy + a.m[5] * vz + a.t[1];
+    out_z[i] = a.m[6] * vx + a.m[7] * vy + a.m[8] * vz + a.t[2];
+  }
+}
+
+/// out[i] = a[i] * b[i] for i in [begin, n)
+inline void composePosesScalar(std::size_t begin, std::size_t n, const PoseArray &a, const PoseArray &b, PoseArray &out)
+{
+  for (std::size_t i = begin; i < n; ++i)
+  {
+    out.set(i, a.get(i) * b.get(i));
+  }
+}
+
+#ifdef URDF_SIMD_X86
+
+URDF_TARGET_AVX2
+inline void transformPointsAvx2(const AffineTransform &a, std::size_t n,
+                                const double *x, const double *y, const double *z,
+                                double *out_x, double *out_y, double *out_z)
+{
+  const __m256d m0 = _mm256_set1_pd(a.m[0]), m1 = _mm256_set1_pd(a.m[1]), m2 = _mm256_set1_pd(a.m[2]);
+  const __m256d m3 = _mm256_set1_pd(a.m[3]), m4 = _mm256_set1_pd(a.m[4]), m5 = _mm256_set1_pd(a.m[5]);
+  const __m256d m6 = _mm256_set1_pd(a.m[6]), m7 = _mm256_set1_pd(a.m[7]), m8 = _mm256_set1_pd(a.m[8]);
+  const __m256d t0 = _mm256_set1_pd(a.t[0]), t1 = _mm256_set1_pd(a.t[1]), t2 = _mm256_set1_pd(a.t[2]);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m256d vx = _mm256_loadu_pd(x + i), vy = _mm256_loadu_pd(y + i), vz = _mm256_loadu_pd(z + i);
+    _mm256_storeu_pd(out_x + i, _mm256_fmadd_pd(m0, vx, _mm256_fmadd_pd(m1, vy, _mm256_fmadd_pd(m2, vz, t0))));
+    _mm256_storeu_pd(out_y + i, _mm256_fmadd_pd(m3, vx, _mm256_fmadd_pd(m4, vy, _mm256_fmadd_pd(m5, vz, t1))));
+    _mm256_storeu_pd(out_z + i, _mm256_fmadd_pd(m6, vx, _mm256_fmadd_pd(m7, vy, _mm256_fmadd_pd(m8, vz, t2))));
+  }
+  transformPointsScalar(a, i, n, x, y, z, out_x, out_y, out_z);
+}
+
+URDF_TARGET_AVX512
+inline void transformPointsAvx512(const AffineTransform &a, std::size_t n,
+                                  const double *x, const double *y, const double *z,
+                                  double *out_x, double *out_y, double *out_z)
+{
+  const __m512d m0 = _mm512_set1_pd(a.m[0]), m1 = _mm512_set1_pd(a.m[1]), m2 = _mm512_set1_pd(a.m[2]);
+  const __m512d m3 = _mm512_set1_pd(a.m[3]), m4 = _mm512_set1_pd(a.m[4]), m5 = _mm512_set1_pd(a.m[5]);
+  const __m512d m6 = _mm512_set1_pd(a.m[6]), m7 = _mm512_set1_pd(a.m[7]), m8 = _mm512_set1_pd(a.m[8]);
+  const __m512d t0 = _mm512_set1_pd(a.t[0]), t1 = _mm512_set1_pd(a.t[1]), t2 = _mm512_set1_pd(a.t[2]);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    const __m512d vx = _mm512_loadu_pd(x + i), vy = _mm512_loadu_pd(y + i), vz = _mm512_loadu_pd(z + i);
+    _mm512_storeu_pd(out_x + i, _mm512_fmadd_pd(m0, vx, _mm512_fmadd_pd(m1, vy, _mm512_fmadd_pd(m2, vz, t0))));
+    _mm512_storeu_pd(out_y + i, _mm512_fmadd_pd(m3, vx, _mm512_fmadd_pd(m4, vy, _mm512_fmadd_pd(m5, vz, t1))));
+    _mm512_storeu_pd(out_z + i, _mm512_fmadd_pd(m6, vx, _mm512_fmadd_pd(m7, vy, _mm512_fmadd_pd(m8, vz, t2))));
+  }
+  transformPointsScalar(a, i, n, x, y, z, out_x, out_y, out_z);
+}
+
+URDF_TARGET_AVX2
+inline void composePosesAvx2(std::size_t n, const PoseArray &a, const PoseArray &b, PoseArray &out)
+{
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d two = _mm256_set1_pd(2.0);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m256d ax = _mm256_loadu_pd(&a.qx[i]), ay = _mm256_loadu_pd(&a.qy[i]);
+    const __m256d az = _mm256_loadu_pd(&a.qz[i]), aw = _mm256_loadu_pd(&a.qw[i]);
+    const __m256d bx = _mm256_loadu_pd(&b.qx[i]), by = _mm256_loadu_pd(&b.qy[i]);
+    const __m256d bz = _mm256_loadu_pd(&b.qz[i]), bw = _mm256_loadu_pd(&b.qw[i]);
+    const __m256d vx = _mm256_loadu_pd(&b.px[i]), vy = _mm256_loadu_pd(&b.py[i]), vz = _mm256_loadu_pd(&b.pz[i]);
+
+    // rotate b's position by a's rotation, see Rotation::operator*(Vector3)
+    const __m256d norm = _mm256_fmadd_pd(aw, aw, _mm256_fmadd_pd(az, az, _mm256_fmadd_pd(ay, ay, _mm256_mul_pd(ax, ax))));
+    const __m256d valid = _mm256_cmp_pd(norm, zero, _CMP_GT_OQ);
+    const __m256d s = _mm256_and_pd(valid, _mm256_div_pd(two, norm));
+    const __m256d tx = _mm256_mul_pd(s, _mm256_fmsub_pd(ay, vz, _mm256_mul_pd(az, vy)));
+    const __m256d ty = _mm256_mul_pd(s, _mm256_fmsub_pd(az, vx, _mm256_mul_pd(ax, vz)));
+    const __m256d tz = _mm256_mul_pd(s, _mm256_fmsub_pd(ax, vy, _mm256_mul_pd(ay, vx)));
+    const __m256d rx = _mm256_and_pd(valid, _mm256_add_pd(_mm256_fmadd_pd(aw, tx, vx), _mm256_fmsub_pd(ay, tz, _mm256_mul_pd(az, ty))));
+    const __m256d ry = _mm256_and_pd(valid, _mm256_add_pd(_mm256_fmadd_pd(aw, ty, vy), _mm256_fmsub_pd(az, tx, _mm256_mul_pd(ax, tz))));
+    const __m256d rz = _mm256_and_pd(valid, _mm256_add_pd(_mm256_fmadd_pd(aw, tz, vz), _mm256_fmsub_pd(ax, ty, _mm256_mul_pd(ay, tx))));
+    _mm256_storeu_pd(&out.px[i], _mm256_add_pd(_mm256_loadu_pd(&a.px[i]), rx));
+    _mm256_storeu_pd(&out.py[i], _mm256_add_pd(_mm256_loadu_pd(&a.py[i]), ry));
+    _mm256_storeu_pd(&out.pz[i], _mm256_add_pd(_mm256_loadu_pd(&a.pz[i]), rz));
+
+    // quaternion product, see Rotation::operator*(Rotation)
+    _mm256_storeu_pd(&out.qx[i], _mm256_add_pd(_mm256_fmsub_pd(ay, bz, _mm256_mul_pd(az, by)),
+                                               _mm256_fmadd_pd(aw, bx, _mm256_mul_pd(ax, bw))));
+    _mm256_storeu_pd(&out.qy[i], _mm256_add_pd(_mm256_fmsub_pd(aw, by, _mm256_mul_pd(ax, bz)),
+                                               _mm256_fmadd_pd(ay, bw, _mm256_mul_pd(az, bx))));
+    _mm256_storeu_pd(&out.qz[i], _mm256_sub_pd(_mm256_fmadd_pd(aw, bz, _mm256_mul_pd(ax, by)),
+                                               _mm256_fmsub_pd(ay, bx, _mm256_mul_pd(az, bw))));
+    _mm256_storeu_pd(&out.qw[i], _mm256_sub_pd(_mm256_fmsub_pd(aw, bw, _mm256_mul_pd(ax, bx)),
+                                               _mm256_fmadd_pd(ay, by, _mm256_mul_pd(az, bz))));
+  }
+  composePosesScalar(i, n, a, b, out);
+}
+
+URDF_TARGET_AVX512
+inline void composePosesAvx512(std::size_t n, const PoseArray &a, const PoseArray &b, PoseArray &out)
+{
+  const __m512d zero = _mm512_setzero_pd();
+  const __m512d two = _mm512_set1_pd(2.0);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    const __m512d ax = _mm512_loadu_pd(&a.qx[i]), ay = _mm512_loadu_pd(&a.qy[i]);
+    const __m512d az = _mm512_loadu_pd(&a.qz[i]), aw = _mm512_loadu_pd(&a.qw[i]);
+    const __m512d bx = _mm512_loadu_pd(&b.qx[i]), by = _mm512_loadu_pd(&b.qy[i]);
+    const __m512d bz = _mm512_loadu_pd(&b.qz[i]), bw = _mm512_loadu_pd(&b.qw[i]);
+    const __m512d vx = _mm512_loadu_pd(&b.px[i]), vy = _mm512_loadu_pd(&b.py[i]), vz = _mm512_loadu_pd(&b.pz[i]);
+
+    const __m512d norm = _mm512_fmadd_pd(aw, aw, _mm512_fmadd_pd(az, az, _mm512_fmadd_pd(ay, ay, _mm512_mul_pd(ax, ax))));
+    const __mmask8 valid = _mm512_cmp_pd_mask(norm, zero, _CMP_GT_OQ);
+    const __m512d s = _mm512_maskz_div_pd(valid, two, norm);
+    const __m512d tx = _mm512_mul_pd(s, _mm512_fmsub_pd(ay, vz, _mm512_mul_pd(az, vy)));
+    const __m512d ty = _mm512_mul_pd(s, _mm512_fmsub_pd(az, vx, _mm512_mul_pd(ax, vz)));
+    const __m512d tz = _mm512_mul_pd(s, _mm512_fmsub_pd(ax, vy, _mm512_mul_pd(ay, vx)));
+    const __m512d rx = _mm512_maskz_add_pd(valid, _mm512_fmadd_pd(aw, tx, vx), _mm512_fmsub_pd(ay, tz, _mm512_mul_pd(az, ty)));
+    const __m512d ry = _mm512_maskz_add_pd(valid, _mm512_fmadd_pd(aw, ty, vy), _mm512_fmsub_pd(az, tx, _mm512_mul_pd(ax, tz)));
+    const __m512d rz = _mm512_maskz_add_pd(valid, _mm512_fmadd_pd(aw, tz, vz), _mm512_fmsub_pd(ax, ty, _mm512_mul_pd(ay, tx)));
+    _mm512_storeu_pd(&out.px[i], _mm512_add_pd(_mm512_loadu_pd(&a.px[i]), rx));
+    _mm512_storeu_pd(&out.py[i], _mm512_add_pd(_mm512_loadu_pd(&a.py[i]), ry));
+    _mm512_storeu_pd(&out.pz[i], _mm512_add_pd(_mm512_loadu_pd(&a.pz[i]), rz));
+
+    _mm512_storeu_pd(&out.qx[i], _mm512_add_pd(_mm512_fmsub_pd(ay, bz, _mm512_mul_pd(az, by)),
+                                               _mm512_fmadd_pd(aw, bx, _mm512_mul_pd(ax, bw))));
+    _mm512_storeu_pd(&out.qy[i], _mm512_add_pd(_mm512_fmsub_pd(aw, by, _mm512_mul_pd(ax, bz)),
+                                               _mm512_fmadd_pd(ay, bw, _mm512_mul_pd(az, bx))));
+    _mm512_storeu_pd(&out.qz[i], _mm512_sub_pd(_mm512_fmadd_pd(aw, bz, _mm512_mul_pd(ax, by)),
+                                               _mm512_fmsub_pd(ay, bx, _mm512_mul_pd(az, bw))));
+    _mm512_storeu_pd(&out.qw[i], _mm512_sub_pd(_mm512_fmsub_pd(aw, bw, _mm512_mul_pd(ax, bx)),
+                                               _mm512_fmadd_pd(ay, by, _mm512_mul_pd(az, bz))));
+  }
+  composePosesScalar(i, n, a, b, out);
+}
+
+#endif
+
+}
+
+/// \brief Apply pose to n points: out = R p + t
+///
+/// Inputs and outputs are separate x, y and z arrays of length n; the
+/// outputs may alias the inputs.
+inline void transformPoints(const Pose &pose, std::size_t n,
+                            const double *x, const double *y, const double *z,
+                            double *out_x, double *out_y, double *out_z)
+{
+  const detail::AffineTransform a(pose);
+#ifdef URDF_SIMD_X86
+  switch (simd::detectLevel())
+  {
+    case simd::AVX512: detail::transformPointsAvx512(a, n, x, y, z, out_x, out_y, out_z); return;
+    case simd::AVX2: detail::transformPointsAvx2(a, n, x, y, z, out_x, out_y, out_z); return;
+    default: break;
+  }
+#endif
+  detail::transformPointsScalar(a, 0, n, x, y, z, out_x, out_y, out_z);
+}
+
+/// \brief Rotate n vectors, see transformPoints()
+inline void rotateVectors(const Rotation &rotation, std::size_t n,
+                          const double *x, const double *y, const double *z,
+                          double *out_x, double *out_y, double *out_z)
+{
+  Pose pose;
+  pose.rotation = rotation;
+  transformPoints(pose, n, x, y, z, out_x, out_y, out_z);
+}
+
+/// \brief out[i] = a[i] * b[i], i.e. b[i] expressed in the frame a[i] is expressed in
+///
+/// out is resized to the size of a and may be a or b.  Throws
+/// std::invalid_argument if a and b differ in size.
+inline void composePoses(const PoseArray &a, const PoseArray &b, PoseArray &out)
+{
+  if (a.size() != b.size())
+  {
+    throw std::invalid_argument("composePoses() needs pose arrays of equal size");
+  }
+  const std::size_t n = a.size();
+  out.resize(n);
+#ifdef URDF_SIMD_X86
+  switch (simd::detectLevel())
+  {
+    case simd::AVX512: detail::composePosesAvx512(n, a, b, out); return;
+    case simd::AVX2: detail::composePosesAvx2(n, a, b, out); return;
+    default: break;
+  }
+#endif
+  detail::composePosesScalar(0, n, a, b, out);
+}
+
+/// \brief Convert n roll, pitch, yaw triples to quaternions, see Rotation::setFromRPY()
+///
+/// This is bound by sin/cos, so there is no explicitly vectorized variant;
+/// the loop carries no dependencies and is left to the compiler.
+inline void rpyToQuaternions(std::size_t n, const double *roll, const double *pitch, const double *yaw,
+                             double *qx, double *qy, double *qz, double *qw)
+{
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const double phi = roll[i] / 2.0, the = pitch[i] / 2.0, psi = yaw[i] / 2.0;
+    const double sphi = std::sin(phi), cphi = std::cos(phi);
+    const double sthe = std::sin(the), cthe = std::cos(the);
+    const double spsi = std::sin(psi), cpsi = std::cos(psi);
+    // already normalized up to rounding; normalize anyway like setFromRPY
+    const double x = sphi * cthe * cpsi - cphi * sthe * spsi;
+    const double y = cphi * sthe * cpsi + sphi * cthe * spsi;
+    const double z = cphi * cthe * spsi - sphi * sthe * cpsi;
+    const double w = cphi * cthe * cpsi + sphi * sthe * spsi;
+    const double s = 1.0 / std::sqrt(x * x + y * y + z * z + w * w);
+    qx[i] = x * s;
+    qy[i] = y * s;
+    qz[i] = z * s;
+    qw[i] = w * s;
+  }
+}
+
+}
+
+#endif
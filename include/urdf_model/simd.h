@@ -0,0 +1,52 @@
+/* Runtime selection of vector instruction sets for the batched kernels */
+
+#ifndef URDF_INTERFACE_SIMD_H
+#define URDF_INTERFACE_SIMD_H
+
+// The AVX2 and AVX-512 kernels are compiled with per-function target
+// attributes, so the headers do not need any -m flags and the kernels are
+// only ever called on CPUs that support them.  Define URDF_DISABLE_SIMD to
+// build the scalar code only.
+#if !defined(URDF_DISABLE_SIMD) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define URDF_SIMD_X86 1
+#include <immintrin.h>
+#define URDF_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define URDF_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+namespace urdf{
+
+namespace simd{
+
+enum Level
+{
+  SCALAR, AVX2, AVX512
+};
+
+/// best instruction set supported by the CPU, detected once
+inline Level detectLevel()
+{
+  static const Level level = []() -> Level
+  {
+#ifdef URDF_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+      return AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+      return AVX2;
+    }
+#endif
+    return SCALAR;
+  }();
+  return level;
+}
+
+}
+
+}
+
+#endif
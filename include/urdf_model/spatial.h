@@ -0,0 +1,181 @@
+/* Spatial (6D) vector algebra in world coordinates */
+
+#ifndef URDF_INTERFACE_SPATIAL_H
+#define URDF_INTERFACE_SPATIAL_H
+
+#include <cmath>
+
+#include <urdf_model/joint.h>
+#include <urdf_model/link.h>
+#include <urdf_model/pose.h>
+
+namespace urdf{
+
+/// Spatial motion vectors are 6 doubles [angular; linear], the linear part
+/// being the velocity of the body point at the world origin.  Force vectors
+/// are [moment about the world origin; force].  Spatial inertias are 6x6
+/// row major matrices mapping motion to force vectors.  Everything is
+/// expressed in world coordinates, so velocities and accelerations propagate
+/// down the tree by plain addition.
+namespace spatial{
+
+/// row major rotation matrix of a quaternion, which need not be normalized
+inline void rotationMatrix(const Rotation &q, double *m)
+{
+  const double norm = q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w;
+  const double s = norm > 0.0 ? 2.0 / norm : 0.0;
+  const double d = norm > 0.0 ? 1.0 : 0.0;
+  m[0] = d - s * (q.y * q.y + q.z * q.z);
+  m[1] = s * (q.x * q.y - q.z * q.w);
+  m[2] = s * (q.x * q.z + q.y * q.w);
+  m[3] = s * (q.x * q.y + q.z * q.w);
+  m[4] = d - s * (q.x * q.x + q.z * q.z);
+  m[5] = s * (q.y * q.z - q.x * q.w);
+  m[6] = s * (q.x * q.z - q.y * q.w);
+  m[7] = s * (q.y * q.z + q.x * q.w);
+  m[8] = d - s * (q.x * q.x + q.y * q.y);
+}
+
+/// out = v x m, the derivative of motion vector m moving with velocity v
+inline void crossMotion(const double *v, const double *m, double *out)
+{
+  out[0] = v[1] * m[2] - v[2] * m[1];
+  out[1] = v[2] * m[0] - v[0] * m[2];
+  out[2] = v[0] * m[1] - v[1] * m[0];
+  out[3] = v[1] * m[5] - v[2] * m[4] + v[4] * m[2] - v[5] * m[1];
+  out[4] = v[2] * m[3] - v[0] * m[5] + v[5] * m[0] - v[3] * m[2];
+  out[5] = v[0] * m[4] - v[1] * m[3] + v[3] * m[1] - v[4] * m[0];
+}
+
+/// out = v x* f, the derivative of force vector f moving with velocity v
+inline void crossForce(const double *v, const double *f, double *out)
+{
+  out[0] = v[1] * f[2] - v[2] * f[1] + v[4] * f[5] - v[5] * f[4];
+  out[1] = v[2] * f[0] - v[0] * f[2] + v[5] * f[3] - v[3] * f[5];
+  out[2] = v[0] * f[1] - v[1] * f[0] + v[3] * f[4] - v[4] * f[3];
+  out[3] = v[1] * f[5] - v[2] * f[4];
+  out[4] = v[2] * f[3] - v[0] * f[5];
+  out[5] = v[0] * f[4] - v[1] * f[3];
+}
+
+/// rotation about the unit axis through point: [axis; point x axis]
+inline void rotationAxis(const Vector3 &axis, const Vector3 &point, double *out)
+{
+  const Vector3 moment = point.cross(axis);
+  out[0] = axis.x; out[1] = axis.y; out[2] = axis.z;
+  out[3] = moment.x; out[4] = moment.y; out[5] = moment.z;
+}
+
+/// translation along the unit axis: [0; axis]
+inline void translationAxis(const Vector3 &axis, double *out)
+{
+  out[0] = out[1] = out[2] = 0.0;
+  out[3] = axis.x; out[4] = axis.y; out[5] = axis.z;
+}
+
+/// \brief World frame motion subspace of a joint, column k at out + 6 k
+///
+/// There are CompiledModel::jointNumVelocities(type) columns.  axis, e1 and
+/// e2 are as for jointMotion(), link_pose is the world pose of the child link
+/// and q points at the positions of the joint.  PLANAR joints move along e1,
+/// e2 and turn about axis, FLOATING joints take body fixed angular then
+/// linear velocities.
+inline void jointSubspace(int type, const Vector3 &axis, const Vector3 &e1, const Vector3 &e2,
+                          const Pose &link_pose, const double *q, double *out)
+{
+  const Rotation &rotation = link_pose.rotation;
+  switch (type)
+  {
+    case Joint::REVOLUTE:
+    case Joint::CONTINUOUS:
+      rotationAxis(rotation * axis, link_pose.position, out);
+      break;
+    case Joint::PRISMATIC:
+      translationAxis(rotation * axis, out);
+      break;
+    case Joint::PLANAR:
+    {
+      // the plane axes are fixed in the joint frame, which is the child
+      // frame turned back by the joint angle
+      const double c = std::cos(q[2]), s = std::sin(q[2]);
+      translationAxis(rotation * (e1 * c - e2 * s), out);
+      translationAxis(rotation * (e2 * c + e1 * s), out + 6);
+      rotationAxis(rotation * axis, link_pose.position, out + 12);
+      break;
+    }
+    case Joint::FLOATING:
+    {
+      const Vector3 units[3] = {Vector3(1.0, 0.0, 0.0), Vector3(0.0, 1.0, 0.0), Vector3(0.0, 0.0, 1.0)};
+      for (int k = 0; k < 3; ++k)
+      {
+        rotationAxis(rotation * units[k], link_pose.position, out + 6 * k);
+        translationAxis(rotation * units[k], out + 6 * (3 + k));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/// out = I v for a 6x6 matrix I
+inline void multiply(const double *inertia, const double *v, double *out)
+{
+  for (int r = 0; r < 6; ++r)
+  {
+    const double *row = inertia + 6 * r;
+    out[r] = row[0] * v[0] + row[1] * v[1] + row[2] * v[2] + row[3] * v[3] + row[4] * v[4] + row[5] * v[5];
+  }
+}
+
+inline double dot(const double *a, const double *b)
+{
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3] + a[4] * b[4] + a[5] * b[5];
+}
+
+/// \brief Spatial inertia about the world origin of a link at link_pose
+///
+/// Links without an inertial get an all zero inertia.
+inline void worldInertia(const Inertial &inertial, const Pose &link_pose, double *out)
+{
+  const Pose frame = link_pose * inertial.origin;
+  const Vector3 &c = frame.position;
+  const double m = inertial.mass;
+
+  // rotational inertia about the center of mass in world axes, R I R^T
+  double r[9];
+  rotationMatrix(frame.rotation, r);
+  const double local[9] = {inertial.ixx, inertial.ixy, inertial.ixz,
+                           inertial.ixy, inertial.iyy, inertial.iyz,
+                           inertial.ixz, inertial.iyz, inertial.izz};
+  double ri[9];
+  for (int a = 0; a < 3; ++a)
+  {
+    for (int b = 0; b < 3; ++b)
+    {
+      ri[3 * a + b] = r[3 * a] * local[b] + r[3 * a + 1] * local[3 + b] + r[3 * a + 2] * local[6 + b];
+    }
+  }
+  // [I_c + m cx cx^T, m cx; m cx^T, m 1] with cx the cross product matrix of c
+  const double cx[9] = {0.0, -c.z, c.y,
+                        c.z, 0.0, -c.x,
+                        -c.y, c.x, 0.0};
+  for (int a = 0; a < 3; ++a)
+  {
+    for (int b = 0; b < 3; ++b)
+    {
+      double rotational = ri[3 * a] * r[3 * b] + ri[3 * a + 1] * r[3 * b + 1] + ri[3 * a + 2] * r[3 * b + 2];
+      rotational += m * (cx[3 * a] * cx[3 * b] + cx[3 * a + 1] * cx[3 * b + 1] + cx[3 * a + 2] * cx[3 * b + 2]);
+      out[6 * a + b] = rotational;
+      out[6 * a + 3 + b] = m * cx[3 * a + b];
+      out[6 * (3 + a) + b] = m * cx[3 * b + a];
+      out[6 * (3 + a) + 3 + b] = a == b ? m : 0.0;
+    }
+  }
+}
+
+}
+
+}
+
+#endif
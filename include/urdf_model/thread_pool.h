@@ -0,0 +1,273 @@
+/* Fixed size thread pool with work stealing parallel loops */
+
+#ifndef URDF_INTERFACE_THREAD_POOL_H
+#define URDF_INTERFACE_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace urdf{
+
+/// \brief Worker threads running parallelFor() loops
+///
+/// parallelFor() splits [0, count) into one contiguous range per thread.
+/// Each thread takes grains from the front of its own range; once that is
+/// empty it steals half of what is left of another thread's range from the
+/// back, so threads that finish early keep busy without any central queue.
+/// Ranges are claimed with a compare and swap on a packed (begin, end) word.
+///
+/// The thread calling parallelFor() takes part as thread 0, the workers are
+/// threads 1 .. getNumThreads() - 1.  parallelFor() calls from several
+/// threads at once, or from inside a loop body, are not supported.
+class ThreadPool
+{
+public:
+  /// num_threads counts the calling thread, 0 means std::thread::hardware_concurrency()
+  explicit ThreadPool(std::size_t num_threads = 0)
+  {
+    if (num_threads == 0)
+    {
+      num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    this->ranges_ = std::vector<Range>(num_threads);
+    this->workers_.reserve(num_threads - 1);
+    for (std::size_t t = 1; t < num_threads; ++t)
+    {
+      this->workers_.emplace_back(&ThreadPool::workerLoop, this, t);
+    }
+  };
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->stop_ = true;
+    }
+    this->start_.notify_all();
+    for (std::thread &worker : this->workers_)
+    {
+      worker.join();
+    }
+  };
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  std::size_t getNumThreads() const { return this->ranges_.size(); };
+
+  /// \brief call function(thread, begin, end) on disjoint ranges covering [0, count)
+  ///
+  /// Ranges hold at most grain items except the last of a thread.  thread
+  /// is below getNumThreads() and no two calls with the same thread run at
+  /// once, so it can index per thread scratch space.  The first exception
+  /// thrown by function stops the loop and is rethrown once every thread
+  /// has returned.
+  template <class Function>
+  void parallelFor(std::size_t count, std::size_t grain, Function &&function)
+  {
+    grain = std::max<std::size_t>(grain, 1);
+    // ranges are packed into 32 bit halves
+    const std::size_t max_count = std::size_t(1) << 31;
+    for (std::size_t base = 0; base < count; base += max_count)
+    {
+      const std::size_t part = std::min(count - base, max_count);
+      auto shifted = [&function, base](std::size_t thread, std::size_t begin, std::size_t end)
+      {
+        function(thread, base + begin, base + end);
+      };
+      this->run(part, grain, shifted);
+    }
+  };
+
+private:
+  /// [begin, end) as begin << 32 | end, on its own cache line
+  struct alignas(64) Range
+  {
+    Range() : bounds(0) {}
+    Range(const Range &) : bounds(0) {}
+    std::atomic<std::uint64_t> bounds;
+  };
+
+  static std::uint64_t pack(std::uint64_t begin, std::uint64_t end) { return begin << 32 | end; };
+
+  template <class Function>
+  void run(std::size_t count, std::size_t grain, Function &function)
+  {
+    const std::size_t num_threads = std::min(this->getNumThreads(), (count + grain - 1) / grain);
+    if (num_threads <= 1)
+    {
+      for (std::size_t begin = 0; begin < count; begin += grain)
+      {
+        function(0, begin, std::min(begin + grain, count));
+      }
+      return;
+    }
+    for (std::size_t t = 0; t < num_threads; ++t)
+    {
+      this->ranges_[t].bounds.store(pack(count * t / num_threads, count * (t + 1) / num_threads),
+                                    std::memory_order_relaxed);
+    }
+    this->job_function_ = &ThreadPool::invoke<Function>;
+    this->job_context_ = &function;
+    this->job_grain_ = grain;
+    this->job_num_threads_ = num_threads;
+    this->abort_.store(false, std::memory_order_relaxed);
+    this->exception_ = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->pending_ = num_threads - 1;
+      ++this->generation_;
+    }
+    this->start_.notify_all();
+
+    this->work(0);
+
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->done_.wait(lock, [this] { return this->pending_ == 0; });
+    if (this->exception_)
+    {
+      std::rethrow_exception(this->exception_);
+    }
+  };
+
+  template <class Function>
+  static void invoke(void *context, std::size_t thread, std::size_t begin, std::size_t end)
+  {
+    (*static_cast<Function *>(context))(thread, begin, end);
+  };
+
+  void workerLoop(std::size_t thread)
+  {
+    std::uint64_t seen = 0;
+    for (;;)
+    {
+      {
+        std::unique_lock<std::mutex> lock(this->mutex_);
+        this->start_.wait(lock, [this, seen] { return this->stop_ || this->generation_ != seen; });
+        if (this->stop_)
+        {
+          return;
+        }
+        seen = this->generation_;
+        if (thread >= this->job_num_threads_)
+        {
+          continue;
+        }
+      }
+      this->work(thread);
+      {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        --this->pending_;
+      }
+      this->done_.notify_one();
+    }
+  };
+
+  /// run grains of the own range, then steal until every range is empty
+  void work(std::size_t thread)
+  {
+    std::atomic<std::uint64_t> &own = this->ranges_[thread].bounds;
+    const std::size_t num_threads = this->job_num_threads_;
+    for (;;)
+    {
+      std::size_t begin, end;
+      while (!this->abort_.load(std::memory_order_relaxed) && this->takeFront(own, begin, end))
+      {
+        try
+        {
+          this->job_function_(this->job_context_, thread, begin, end);
+        }
+        catch (...)
+        {
+          std::lock_guard<std::mutex> lock(this->mutex_);
+          if (!this->exception_)
+          {
+            this->exception_ = std::current_exception();
+          }
+          this->abort_.store(true, std::memory_order_relaxed);
+        }
+      }
+      if (this->abort_.load(std::memory_order_relaxed))
+      {
+        return;
+      }
+      bool stolen = false;
+      for (std::size_t k = 1; k < num_threads && !stolen; ++k)
+      {
+        stolen = this->stealBack(this->ranges_[(thread + k) % num_threads].bounds, own);
+      }
+      if (!stolen)
+      {
+        return;
+      }
+    }
+  };
+
+  bool takeFront(std::atomic<std::uint64_t> &range, std::size_t &begin, std::size_t &end)
+  {
+    std::uint64_t bounds = range.load(std::memory_order_acquire);
+    for (;;)
+    {
+      const std::uint64_t b = bounds >> 32, e = bounds & 0xffffffffu;
+      if (b >= e)
+      {
+        return false;
+      }
+      const std::uint64_t next = std::min<std::uint64_t>(b + this->job_grain_, e);
+      if (range.compare_exchange_weak(bounds, pack(next, e), std::memory_order_acq_rel))
+      {
+        begin = b;
+        end = next;
+        return true;
+      }
+    }
+  };
+
+  /// move the back half of victim into the empty range own
+  bool stealBack(std::atomic<std::uint64_t> &victim, std::atomic<std::uint64_t> &own)
+  {
+    std::uint64_t bounds = victim.load(std::memory_order_acquire);
+    for (;;)
+    {
+      const std::uint64_t b = bounds >> 32, e = bounds & 0xffffffffu;
+      if (b >= e)
+      {
+        return false;
+      }
+      const std::uint64_t take = std::max<std::uint64_t>((e - b) / 2, std::min<std::uint64_t>(this->job_grain_, e - b));
+      if (victim.compare_exchange_weak(bounds, pack(b, e - take), std::memory_order_acq_rel))
+      {
+        own.store(pack(e - take, e), std::memory_order_release);
+        return true;
+      }
+    }
+  };
+
+  std::vector<Range> ranges_;
+  std::vector<std::thread> workers_;
+
+  /// the current loop, written before the generation is bumped
+  void (*job_function_)(void *, std::size_t, std::size_t, std::size_t) = nullptr;
+  void *job_context_ = nullptr;
+  std::size_t job_grain_ = 1;
+  std::size_t job_num_threads_ = 0;
+  std::atomic<bool> abort_{false};
+  std::exception_ptr exception_;
+
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  std::uint64_t generation_ = 0;
+  std::size_t pending_ = 0;
+  bool stop_ = false;
+};
+
+}
+
+#endif
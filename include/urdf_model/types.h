@@ -66,6 +66,7 @@ URDF_TYPEDEF_CLASS_POINTER(CouplingConstraint);
 URDF_TYPEDEF_CLASS_POINTER(LoopConstraint);
 URDF_TYPEDEF_CLASS_POINTER(Link);
 URDF_TYPEDEF_CLASS_POINTER(Cluster);
+URDF_TYPEDEF_CLASS_POINTER(CompiledModel);
 URDF_TYPEDEF_CLASS_POINTER(Material);
 URDF_TYPEDEF_CLASS_POINTER(Mesh);
 URDF_TYPEDEF_CLASS_POINTER(Sphere);
@@ -37,12 +37,32 @@
 #ifndef URDF_INTERFACE_UTILS_H
 #define URDF_INTERFACE_UTILS_H
 
-#include <locale>
-#include <sstream>
+#include <cstddef>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+// std::from_chars for double is missing from libstdc++ before GCC 11 and
+// libc++ before LLVM 20; parseDouble() then falls back to a stream parser.
+#ifndef URDF_HAS_FLOAT_FROM_CHARS
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define URDF_HAS_FLOAT_FROM_CHARS 1
+#else
+#define URDF_HAS_FLOAT_FROM_CHARS 0
+#endif
+#endif
+
+#if !URDF_HAS_FLOAT_FROM_CHARS
+#include <locale>
+#include <sstream>
+#endif
+
 namespace urdf {
 
 // Replacement for boost::split( ... , ... , boost::is_any_of(" "))
@@ -65,6 +85,190 @@ void split_string(std::vector<std::string> &result,
   }
 }
 
+// Allocation-free replacement for split_string().  Successive calls to next()
+// return the non-empty tokens of the input separated by any of the characters
+// in isAnyOf.  The tokens point into the input, which must outlive them.
+class StringTokenizer
+{
+public:
+  StringTokenizer(std::string_view input, std::string_view isAnyOf = " ")
+    : input_(input), delimiters_(isAnyOf), pos_(0) {}
+
+  bool next(std::string_view &token)
+  {
+    std::string_view::size_type start = input_.find_first_not_of(delimiters_, pos_);
+    if (start == std::string_view::npos)
+    {
+      pos_ = input_.size();
+      return false;
+    }
+    std::string_view::size_type end = input_.find_first_of(delimiters_, start);
+    if (end == std::string_view::npos)
+    {
+      end = input_.size();
+    }
+    token = input_.substr(start, end - start);
+    pos_ = end;
+    return true;
+  }
+
+private:
+  std::string_view input_;
+  std::string_view delimiters_;
+  std::string_view::size_type pos_;
+};
+
+// True when [digits, last) is an unsigned decimal number smaller than one
+// with a complete exponent, i.e. a range error converting it is an underflow
+// rather than an overflow or a malformed exponent.
+inline bool isBelowOne(const char *digits, const char *last)
+{
+  // decimal exponent of the leading nonzero digit, plus one
+  long magnitude = 0;
+  bool nonzero = false;
+  bool fraction = false;
+  const char *c = digits;
+  for (; c != last && *c != 'e' && *c != 'E'; ++c)
+  {
+    if (*c == '.')
+    {
+      fraction = true;
+    }
+    else if (*c != '0' || nonzero)
+    {
+      nonzero = true;
+      if (!fraction)
+      {
+        ++magnitude;
+      }
+    }
+    else if (fraction)
+    {
+      --magnitude;
+    }
+  }
+  if (!nonzero)
+  {
+    return true;
+  }
+  long exponent = 0;
+  bool negative = false;
+  if (c != last)
+  {
+    ++c;
+    if (c != last && (*c == '-' || *c == '+'))
+    {
+      negative = *c++ == '-';
+    }
+    if (c == last)
+    {
+      return false;
+    }
+    // saturate, anything this large is out of range either way
+    for (; c != last && *c >= '0' && *c <= '9' && exponent < 100000; ++c)
+    {
+      exponent = exponent * 10 + (*c - '0');
+    }
+  }
+  return (negative ? magnitude - exponent : magnitude + exponent) <= 0;
+}
+
+// Locale-free parse of a complete token into a double.  Uses std::from_chars,
+// which always follows the C locale and rounds correctly, so any value
+// printed with enough digits round-trips exactly; without it a stream imbued
+// with the classic locale does the conversion.  Like the stream based
+// parser this replaces, leading whitespace and a leading '+' are accepted,
+// values too small to represent give zero or a denormal, and trailing
+// characters, "inf", "nan" and overflow are rejected.  Returns false on
+// failure without touching out.
+inline bool parseDouble(std::string_view in, double &out)
+{
+  const char *first = in.data();
+  const char *last = in.data() + in.size();
+  while (first != last && (*first == ' ' || *first == '\t' || *first == '\n' ||
+                           *first == '\v' || *first == '\f' || *first == '\r'))
+  {
+    ++first;
+  }
+  if (first != last && *first == '+')
+  {
+    ++first;
+    // from_chars would otherwise accept "+-1"
+    if (first != last && *first == '-')
+    {
+      return false;
+    }
+  }
+
+  // from_chars also accepts "inf" and "nan", which the stream parser did not
+  const char *digits = (first != last && *first == '-') ? first + 1 : first;
+  if (digits == last || !((*digits >= '0' && *digits <= '9') || *digits == '.'))
+  {
+    return false;
+  }
+
+  double value;
+#if URDF_HAS_FLOAT_FROM_CHARS
+  std::from_chars_result result = std::from_chars(first, last, value);
+  if (result.ec == std::errc::result_out_of_range && result.ptr == last &&
+      isBelowOne(digits, last))
+  {
+    // value is left unmodified on underflow, the stream parser gave zero
+    value = digits != first ? -0.0 : 0.0;
+  }
+  else if (result.ec != std::errc() || result.ptr != last)
+  {
+    return false;
+  }
+#else
+  std::istringstream stream(std::string(first, last));
+  stream.imbue(std::locale::classic());
+  stream >> value;
+  if (stream.fail())
+  {
+    // libc++ fails on underflow, keeping the zero or denormal strtod gave
+    stream.clear();
+    if (!isBelowOne(digits, last))
+    {
+      return false;
+    }
+  }
+  if (stream.get() != std::istringstream::traits_type::eof())
+  {
+    return false;
+  }
+#endif
+  out = value;
+  return true;
+}
+
+// Parse exactly N whitespace separated doubles into values.  Returns the
+// number of tokens found, which may be larger than N (the excess is counted
+// but not stored).  If a token cannot be parsed it is returned in bad_token
+// and -1 is returned.
+template <std::size_t N>
+inline int parseDoubles(std::string_view in, double (&values)[N], std::string_view &bad_token)
+{
+  StringTokenizer tokenizer(in);
+  std::string_view token;
+  int count = 0;
+  while (tokenizer.next(token))
+  {
+    double value;
+    if (!parseDouble(token, value))
+    {
+      bad_token = token;
+      return -1;
+    }
+    if (static_cast<std::size_t>(count) < N)
+    {
+      values[count] = value;
+    }
+    ++count;
+  }
+  return count;
+}
+
 // This is a locale-safe version of string-to-double, which is suprisingly
 // difficult to do correctly.  This function ensures that the C locale is used
 // for parsing, as that matches up with what the XSD for double specifies.
@@ -72,15 +276,8 @@ void split_string(std::vector<std::string> &result,
 // thrown.
 static inline double strToDouble(const char *in)
 {
-  std::stringstream ss;
-  ss.imbue(std::locale::classic());
-
-  ss << in;
-
   double out;
-  ss >> out;
-
-  if (ss.fail() || !ss.eof()) {
+  if (!parseDouble(in, out)) {
     throw std::runtime_error("Failed converting string to double");
   }
 
@@ -37,6 +37,9 @@
 #ifndef URDF_MODEL_STATE_H
 #define URDF_MODEL_STATE_H
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
@@ -48,35 +51,108 @@
 
 namespace urdf{
 
-//round is not defined in C++98
-//So in Visual Studio <= 2012 is necessary to define it
-#ifdef _MSC_VER
-#if (_MSC_VER <= 1700)
-double round(double value)
-{
-    return (value >= 0.0f)?(floor(value + 0.5f)):(ceil(value - 0.5f));
-}
-#endif 
-#endif
-
+/// \brief A time stamp or duration in seconds and nanoseconds
+///
+/// nsec is kept in [0, 1e9), so negative times have a negative sec.
+/// Comparisons and arithmetic work on integers only; doubles are used
+/// only by set(), fromSec() and toSec(), which round to the nearest
+/// nanosecond.  toNSec() and fromNSec() convert without loss.
 class Time
 {
 public:
-  Time() { this->clear(); };
+  static constexpr int64_t NSEC_PER_SEC = 1000000000;
+
+  constexpr Time() : sec(0), nsec(0) {};
+  /// nsec outside [0, 1e9) is carried into sec
+  constexpr Time(int32_t _sec, int32_t _nsec) : sec(_sec), nsec(_nsec) { this->Correct(); };
+
+  static constexpr Time fromNSec(int64_t _nsec)
+  {
+    int64_t s = _nsec / NSEC_PER_SEC;
+    int64_t ns = _nsec % NSEC_PER_SEC;
+    if (ns < 0)
+    {
+      --s;
+      ns += NSEC_PER_SEC;
+    }
+    return Time(static_cast<int32_t>(s), static_cast<int32_t>(ns));
+  };
+
+  static constexpr Time fromSec(double _seconds)
+  {
+    // floor without calling into libm
+    int64_t s = static_cast<int64_t>(_seconds);
+    if (static_cast<double>(s) > _seconds)
+    {
+      --s;
+    }
+    const int64_t ns = static_cast<int64_t>((_seconds - static_cast<double>(s)) * 1e9 + 0.5);
+    return Time(static_cast<int32_t>(s), static_cast<int32_t>(ns));
+  };
+
+  template <typename Rep, typename Period>
+  static constexpr Time fromChrono(const std::chrono::duration<Rep, Period> &duration)
+  {
+    return fromNSec(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+  };
+
+  /// a time point as the time since the epoch of its clock
+  template <typename Clock, typename Duration>
+  static constexpr Time fromChrono(const std::chrono::time_point<Clock, Duration> &time_point)
+  {
+    return fromChrono(time_point.time_since_epoch());
+  };
 
   void set(double _seconds)
   {
-    this->sec = (int32_t)(floor(_seconds));
-    this->nsec = (int32_t)(round((_seconds - this->sec) * 1e9));
-    this->Correct();
+    *this = fromSec(_seconds);
   };
 
-  operator double ()
+  constexpr int64_t toNSec() const
+  {
+    return static_cast<int64_t>(this->sec) * NSEC_PER_SEC + this->nsec;
+  };
+
+  constexpr double toSec() const
   {
     return (static_cast<double>(this->sec) +
             static_cast<double>(this->nsec)*1e-9);
   };
 
+  constexpr std::chrono::nanoseconds toChrono() const
+  {
+    return std::chrono::nanoseconds(this->toNSec());
+  };
+
+  operator double () const
+  {
+    return this->toSec();
+  };
+
+  constexpr Time &operator+=(const Time &other)
+  {
+    this->sec += other.sec;
+    this->nsec += other.nsec;
+    if (this->nsec >= NSEC_PER_SEC)
+    {
+      ++this->sec;
+      this->nsec -= NSEC_PER_SEC;
+    }
+    return *this;
+  };
+
+  constexpr Time &operator-=(const Time &other)
+  {
+    this->sec -= other.sec;
+    this->nsec -= other.nsec;
+    if (this->nsec < 0)
+    {
+      --this->sec;
+      this->nsec += NSEC_PER_SEC;
+    }
+    return *this;
+  };
+
   int32_t sec;
   int32_t nsec;
 
@@ -86,22 +162,55 @@ public:
     this->nsec = 0;
   };
 private:
-  void Correct()
+  constexpr void Correct()
   {
     // Make any corrections
-    if (this->nsec >= 1e9)
-    {
-      this->sec++;
-      this->nsec = (int32_t)(this->nsec - 1e9);
-    }
-    else if (this->nsec < 0)
+    this->sec += this->nsec / NSEC_PER_SEC;
+    this->nsec %= NSEC_PER_SEC;
+    if (this->nsec < 0)
     {
-      this->sec--;
-      this->nsec = (int32_t)(this->nsec + 1e9);
+      --this->sec;
+      this->nsec += NSEC_PER_SEC;
     }
   };
 };
 
+constexpr Time operator+(Time a, const Time &b) { return a += b; }
+constexpr Time operator-(Time a, const Time &b) { return a -= b; }
+constexpr Time operator-(const Time &a) { return Time() - a; }
+
+constexpr bool operator==(const Time &a, const Time &b) { return a.sec == b.sec && a.nsec == b.nsec; }
+constexpr bool operator!=(const Time &a, const Time &b) { return !(a == b); }
+constexpr bool operator<(const Time &a, const Time &b) { return a.toNSec() < b.toNSec(); }
+constexpr bool operator>(const Time &a, const Time &b) { return b < a; }
+constexpr bool operator<=(const Time &a, const Time &b) { return !(b < a); }
+constexpr bool operator>=(const Time &a, const Time &b) { return !(a < b); }
+
+/// nanoseconds of n time stamps, e.g. to sort or search them as integers
+inline void toNSec(const Time *times, std::size_t n, int64_t *out)
+{
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    out[i] = times[i].toNSec();
+  }
+}
+
+inline void fromNSec(const int64_t *nsecs, std::size_t n, Time *out)
+{
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    out[i] = Time::fromNSec(nsecs[i]);
+  }
+}
+
+inline void toSec(const Time *times, std::size_t n, double *out)
+{
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    out[i] = times[i].toSec();
+  }
+}
+
 
 class JointState
 {
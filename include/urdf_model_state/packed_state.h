@@ -0,0 +1,376 @@
+/* Model states packed into contiguous buffers with a fixed joint layout */
+
+#ifndef URDF_MODEL_STATE_PACKED_STATE_H
+#define URDF_MODEL_STATE_PACKED_STATE_H
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <urdf_model/compiled_model.h>
+#include <urdf_model/name_index.h>
+#include <urdf_model_state/model_state.h>
+#include <urdf_exception/exception.h>
+
+namespace urdf{
+
+/// \brief Joint order and offsets of packed states
+///
+/// A packed state is one block of doubles: all positions, then all
+/// velocities, then all efforts, one effort per velocity.  The values of
+/// joint k are a fixed range of each part.  Built from a CompiledModel the
+/// joints are its joints in order, with its position and velocity counts
+/// (7 positions and 6 velocities for a FLOATING joint, 3 and 3 for PLANAR,
+/// none for FIXED), so the positions of a packed state are a joint position
+/// vector q as ForwardKinematics and the dynamics take it.  Joints added
+/// with their sizes only have type Joint::UNKNOWN.
+class StateLayout
+{
+public:
+  StateLayout() { this->clear(); };
+  explicit StateLayout(const CompiledModel &model) { this->init(model); };
+
+  void init(const CompiledModel &model)
+  {
+    this->clear();
+    for (std::size_t j = 0; j < model.getNumJoints(); ++j)
+    {
+      this->addJoint(model.joint_names[j], model.joint_nq[j], model.joint_nv[j]);
+      this->types_.back() = model.joint_type[j];
+    }
+  };
+
+  /// a joint of the given Joint::type, sized as CompiledModel sizes it
+  void addJoint(std::string_view name, int type)
+  {
+    this->addJoint(name, CompiledModel::jointNumPositions(type), CompiledModel::jointNumVelocities(type));
+    this->types_.back() = type;
+  };
+
+  /// throws ParseError if the name is already taken
+  void addJoint(std::string_view name, std::size_t num_positions, std::size_t num_velocities)
+  {
+    if (!this->index_.insert(name, static_cast<int>(this->getNumJoints())))
+    {
+      throw ParseError("Joint [" + std::string(name) + "] appears twice in the state layout");
+    }
+    this->names_.push_back(name);
+    this->types_.push_back(Joint::UNKNOWN);
+    this->q_offsets_.push_back(this->q_offsets_.back() + static_cast<int>(num_positions));
+    this->v_offsets_.push_back(this->v_offsets_.back() + static_cast<int>(num_velocities));
+  };
+
+  std::size_t getNumJoints() const { return this->names_.size(); };
+  std::size_t getNumPositions() const { return this->q_offsets_.back(); };
+  std::size_t getNumVelocities() const { return this->v_offsets_.back(); };
+  /// doubles in one packed state
+  std::size_t getSize() const { return this->getNumPositions() + 2 * this->getNumVelocities(); };
+
+  std::string_view getJointName(std::size_t k) const { return this->names_[k]; };
+  /// index of the named joint, -1 if there is none
+  int getJointIndex(std::string_view name) const { return this->index_.find(name); };
+  int getJointType(std::size_t k) const { return this->types_[k]; };
+
+  /// first position of joint k and its number of positions
+  std::size_t getJointPositionOffset(std::size_t k) const { return this->q_offsets_[k]; };
+  std::size_t getJointNumPositions(std::size_t k) const { return this->q_offsets_[k + 1] - this->q_offsets_[k]; };
+  /// first velocity (and effort) of joint k and its number of velocities
+  std::size_t getJointVelocityOffset(std::size_t k) const { return this->v_offsets_[k]; };
+  std::size_t getJointNumVelocities(std::size_t k) const { return this->v_offsets_[k + 1] - this->v_offsets_[k]; };
+
+  void clear()
+  {
+    this->names_.clear();
+    this->index_.clear();
+    this->types_.clear();
+    this->q_offsets_.assign(1, 0);
+    this->v_offsets_.assign(1, 0);
+  };
+
+private:
+  StringTable names_;
+  NameIndex index_;
+  std::vector<int> types_;
+  std::vector<int> q_offsets_;
+  std::vector<int> v_offsets_;
+};
+
+/// \brief A packed state somewhere else in memory
+///
+/// T is double for a view that can modify the state, const double for a
+/// read only one.  Views are cheap to copy and stay valid as long as the
+/// layout, the time stamp and the buffer they point to.
+template <typename T>
+class BasicPackedStateView
+{
+public:
+  typedef typename std::conditional<std::is_const<T>::value, const Time, Time>::type TimeType;
+
+  BasicPackedStateView(const StateLayout &layout, TimeType &time_stamp, T *data)
+    : layout_(&layout), time_stamp_(&time_stamp), data_(data) {};
+
+  /// a modifiable view converts to a read only one
+  template <typename U, typename = typename std::enable_if<std::is_convertible<U *, T *>::value>::type>
+  BasicPackedStateView(const BasicPackedStateView<U> &other)
+    : layout_(&other.getLayout()), time_stamp_(&other.timeStamp()), data_(other.data()) {};
+
+  const StateLayout &getLayout() const { return *this->layout_; };
+  TimeType &timeStamp() const { return *this->time_stamp_; };
+  /// the getLayout().getSize() doubles of the state
+  T *data() const { return this->data_; };
+
+  T *positions() const { return this->data_; };
+  T *velocities() const { return this->data_ + this->layout_->getNumPositions(); };
+  T *efforts() const { return this->velocities() + this->layout_->getNumVelocities(); };
+
+  T *jointPositions(std::size_t k) const { return this->positions() + this->layout_->getJointPositionOffset(k); };
+  T *jointVelocities(std::size_t k) const { return this->velocities() + this->layout_->getJointVelocityOffset(k); };
+  T *jointEfforts(std::size_t k) const { return this->efforts() + this->layout_->getJointVelocityOffset(k); };
+
+  /// copy the time stamp and values of a state with an equal layout
+  void assign(const BasicPackedStateView<const double> &other) const
+  {
+    static_assert(!std::is_const<T>::value, "Cannot assign to a read only state");
+    *this->time_stamp_ = other.timeStamp();
+    std::copy(other.data(), other.data() + this->layout_->getSize(), this->data_);
+  };
+
+  /// \brief set the time stamp and the joints a ModelState holds
+  ///
+  /// Joints are matched by position first and by name when the names
+  /// differ; joints the layout does not have are skipped.  Empty vectors
+  /// leave the values of the state as they are, so a state that does not
+  /// report efforts keeps the previous ones.  Does not allocate.  Throws
+  /// std::runtime_error for vectors of other sizes.
+  void fromModelState(const ModelState &state) const
+  {
+    static_assert(!std::is_const<T>::value, "Cannot assign to a read only state");
+    *this->time_stamp_ = state.time_stamp;
+    for (std::size_t s = 0; s < state.joint_states.size(); ++s)
+    {
+      const JointState &joint = *state.joint_states[s];
+      int k = static_cast<int>(s);
+      if (s >= this->layout_->getNumJoints() || this->layout_->getJointName(s) != joint.joint)
+      {
+        k = this->layout_->getJointIndex(joint.joint);
+        if (k < 0)
+        {
+          continue;
+        }
+      }
+      copyValues(joint, joint.position, this->layout_->getJointNumPositions(k), this->jointPositions(k));
+      copyValues(joint, joint.velocity, this->layout_->getJointNumVelocities(k), this->jointVelocities(k));
+      copyValues(joint, joint.effort, this->layout_->getJointNumVelocities(k), this->jointEfforts(k));
+    }
+  };
+
+  /// \brief fill a ModelState with one JointState per joint with values
+  ///
+  /// JointState objects already in state are reused when their number
+  /// matches, so converting into the same state repeatedly does not
+  /// allocate.
+  void toModelState(ModelState &state) const
+  {
+    std::size_t num_moving = 0;
+    for (std::size_t k = 0; k < this->layout_->getNumJoints(); ++k)
+    {
+      num_moving += this->layout_->getJointNumPositions(k) + this->layout_->getJointNumVelocities(k) > 0;
+    }
+    state.time_stamp = *this->time_stamp_;
+    if (state.joint_states.size() != num_moving)
+    {
+      state.joint_states.resize(num_moving);
+    }
+    std::size_t s = 0;
+    for (std::size_t k = 0; k < this->layout_->getNumJoints(); ++k)
+    {
+      const std::size_t nq = this->layout_->getJointNumPositions(k);
+      const std::size_t nv = this->layout_->getJointNumVelocities(k);
+      if (nq + nv == 0)
+      {
+        continue;
+      }
+      JointStateSharedPtr &joint = state.joint_states[s++];
+      if (!joint)
+      {
+        joint.reset(new JointState());
+      }
+      const std::string_view name = this->layout_->getJointName(k);
+      if (joint->joint != name)
+      {
+        joint->joint.assign(name.data(), name.size());
+      }
+      joint->position.assign(this->jointPositions(k), this->jointPositions(k) + nq);
+      joint->velocity.assign(this->jointVelocities(k), this->jointVelocities(k) + nv);
+      joint->effort.assign(this->jointEfforts(k), this->jointEfforts(k) + nv);
+    }
+  };
+
+private:
+  static void copyValues(const JointState &joint, const std::vector<double> &values, std::size_t size, double *out)
+  {
+    if (values.empty())
+    {
+      return;
+    }
+    if (values.size() != size)
+    {
+      throw std::runtime_error("State of joint [" + joint.joint + "] has " + std::to_string(values.size()) +
+                               " values where its layout has " + std::to_string(size));
+    }
+    std::copy(values.begin(), values.end(), out);
+  };
+
+  const StateLayout *layout_;
+  TimeType *time_stamp_;
+  T *data_;
+};
+
+typedef BasicPackedStateView<double> PackedStateView;
+typedef BasicPackedStateView<const double> ConstPackedStateView;
+
+/// \brief One packed state owning its buffer, all values zero initially
+class PackedModelState
+{
+public:
+  PackedModelState() { this->clear(); };
+  explicit PackedModelState(const StateLayout &layout) { this->init(layout); };
+
+  void init(const StateLayout &layout)
+  {
+    this->layout_ = layout;
+    this->time_stamp.clear();
+    this->data_.assign(layout.getSize(), 0.0);
+  };
+
+  const StateLayout &getLayout() const { return this->layout_; };
+
+  PackedStateView view() { return PackedStateView(this->layout_, this->time_stamp, this->data_.data()); };
+  ConstPackedStateView view() const { return ConstPackedStateView(this->layout_, this->time_stamp, this->data_.data()); };
+
+  double *positions() { return this->view().positions(); };
+  const double *positions() const { return this->view().positions(); };
+  double *velocities() { return this->view().velocities(); };
+  const double *velocities() const { return this->view().velocities(); };
+  double *efforts() { return this->view().efforts(); };
+  const double *efforts() const { return this->view().efforts(); };
+
+  void fromModelState(const ModelState &state) { this->view().fromModelState(state); };
+  void toModelState(ModelState &state) const { this->view().toModelState(state); };
+
+  void clear()
+  {
+    this->layout_.clear();
+    this->time_stamp.clear();
+    this->data_.clear();
+  };
+
+  Time time_stamp;
+
+private:
+  StateLayout layout_;
+  std::vector<double> data_;
+};
+
+/// \brief Ring buffer of the latest packed states
+///
+/// All states live in one block allocated by the constructor, so pushing
+/// never allocates; once capacity states are held each push overwrites the
+/// oldest.  States are indexed from the oldest (0) to the newest
+/// (size() - 1).
+class StateHistory
+{
+public:
+  StateHistory() : capacity_(0), begin_(0), size_(0) {};
+  StateHistory(const StateLayout &layout, std::size_t capacity) { this->init(layout, capacity); };
+
+  void init(const StateLayout &layout, std::size_t capacity)
+  {
+    this->layout_ = layout;
+    this->capacity_ = capacity;
+    this->times_.assign(capacity, Time());
+    this->data_.assign(capacity * layout.getSize(), 0.0);
+    this->begin_ = 0;
+    this->size_ = 0;
+  };
+
+  const StateLayout &getLayout() const { return this->layout_; };
+  std::size_t size() const { return this->size_; };
+  std::size_t capacity() const { return this->capacity_; };
+  bool empty() const { return this->size_ == 0; };
+  bool full() const { return this->size_ == this->capacity_; };
+
+  /// \brief add a state and return it
+  ///
+  /// The new state starts as a copy of the previous newest one, all zero for
+  /// the first, with the given time stamp.  Requires capacity() > 0.
+  PackedStateView push(const Time &time_stamp)
+  {
+    const std::size_t slot = this->full() ? this->begin_ : (this->begin_ + this->size_) % this->capacity_;
+    const std::size_t size = this->layout_.getSize();
+    if (this->size_ > 0)
+    {
+      const std::size_t newest = (this->begin_ + this->size_ - 1) % this->capacity_;
+      std::memmove(this->data_.data() + slot * size, this->data_.data() + newest * size, size * sizeof(double));
+    }
+    if (this->full())
+    {
+      this->begin_ = (this->begin_ + 1) % this->capacity_;
+    }
+    else
+    {
+      ++this->size_;
+    }
+    this->times_[slot] = time_stamp;
+    return this->slot(slot);
+  };
+
+  /// add a state holding the joints of state, see BasicPackedStateView::fromModelState()
+  PackedStateView push(const ModelState &state)
+  {
+    PackedStateView packed = this->push(state.time_stamp);
+    packed.fromModelState(state);
+    return packed;
+  };
+
+  PackedStateView operator[](std::size_t i) { return this->slot((this->begin_ + i) % this->capacity_); };
+  ConstPackedStateView operator[](std::size_t i) const { return this->slot((this->begin_ + i) % this->capacity_); };
+
+  PackedStateView newest() { return (*this)[this->size_ - 1]; };
+  ConstPackedStateView newest() const { return (*this)[this->size_ - 1]; };
+  PackedStateView oldest() { return (*this)[0]; };
+  ConstPackedStateView oldest() const { return (*this)[0]; };
+
+  /// drop all states, keeping the buffer
+  void clear()
+  {
+    this->begin_ = 0;
+    this->size_ = 0;
+  };
+
+private:
+  PackedStateView slot(std::size_t s)
+  {
+    return PackedStateView(this->layout_, this->times_[s], this->data_.data() + s * this->layout_.getSize());
+  };
+
+  ConstPackedStateView slot(std::size_t s) const
+  {
+    return ConstPackedStateView(this->layout_, this->times_[s], this->data_.data() + s * this->layout_.getSize());
+  };
+
+  StateLayout layout_;
+  std::size_t capacity_;
+  std::size_t begin_;
+  std::size_t size_;
+  std::vector<Time> times_;
+  std::vector<double> data_;
+};
+
+}
+
+#endif
@@ -0,0 +1,1010 @@
+/* Chunked, compressed binary logs of ModelState time series */
+
+#ifndef URDF_MODEL_STATE_LOG_H
+#define URDF_MODEL_STATE_LOG_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <urdf_model/mapped_file.h>
+#include <urdf_model/name_index.h>
+#include <urdf_model_state/model_state.h>
+#include <urdf_exception/exception.h>
+
+namespace urdf{
+
+/// \brief The joints of a state log and the columns their values fill
+///
+/// Every joint has fixed numbers of position, velocity and effort values.
+/// A record of the log is one time stamp and one double per column, the
+/// columns of joint k being its positions, then velocities, then efforts,
+/// starting at getColumn(k).
+class StateLogSchema
+{
+public:
+  StateLogSchema() { this->clear(); };
+  /// the joints of state with the sizes of their vectors
+  explicit StateLogSchema(const ModelState &state) { this->init(state); };
+
+  void init(const ModelState &state)
+  {
+    this->clear();
+    for (const JointStateSharedPtr &joint : state.joint_states)
+    {
+      this->addJoint(joint->joint, joint->position.size(), joint->velocity.size(), joint->effort.size());
+    }
+  };
+
+  /// throws ParseError if the name is already taken
+  void addJoint(std::string_view name, std::size_t num_position, std::size_t num_velocity, std::size_t num_effort)
+  {
+    if (!this->index_.insert(name, static_cast<int>(this->getNumJoints())))
+    {
+      throw ParseError("Joint [" + std::string(name) + "] appears twice in the state log schema");
+    }
+    this->names_.push_back(name);
+    this->num_position_.push_back(static_cast<std::uint32_t>(num_position));
+    this->num_velocity_.push_back(static_cast<std::uint32_t>(num_velocity));
+    this->num_effort_.push_back(static_cast<std::uint32_t>(num_effort));
+    this->column_offsets_.push_back(this->column_offsets_.back() +
+                                    static_cast<std::uint32_t>(num_position + num_velocity + num_effort));
+  };
+
+  std::size_t getNumJoints() const { return this->names_.size(); };
+  std::size_t getNumColumns() const { return this->column_offsets_.back(); };
+
+  std::string_view getJointName(std::size_t k) const { return this->names_[k]; };
+  /// index of the named joint, -1 if there is none
+  int getJointIndex(std::string_view name) const { return this->index_.find(name); };
+
+  std::size_t getNumPosition(std::size_t k) const { return this->num_position_[k]; };
+  std::size_t getNumVelocity(std::size_t k) const { return this->num_velocity_[k]; };
+  std::size_t getNumEffort(std::size_t k) const { return this->num_effort_[k]; };
+  /// first column of joint k, its first position
+  std::size_t getColumn(std::size_t k) const { return this->column_offsets_[k]; };
+
+  /// copy the vectors of state into a record, NaN for joints state lacks
+  ///
+  /// Joints are matched by position first and by name when the names
+  /// differ.  Does not allocate.  Throws std::runtime_error for joints whose
+  /// vector sizes differ from the schema.
+  void toRecord(const ModelState &state, double *values) const
+  {
+    std::fill(values, values + this->getNumColumns(), std::numeric_limits<double>::quiet_NaN());
+    for (std::size_t s = 0; s < state.joint_states.size(); ++s)
+    {
+      const JointState &joint = *state.joint_states[s];
+      int k = static_cast<int>(s);
+      if (s >= this->getNumJoints() || this->names_[s] != joint.joint)
+      {
+        k = this->getJointIndex(joint.joint);
+        if (k < 0)
+        {
+          continue;
+        }
+      }
+      if (joint.position.size() != this->num_position_[k] || joint.velocity.size() != this->num_velocity_[k] ||
+          joint.effort.size() != this->num_effort_[k])
+      {
+        throw std::runtime_error("State of joint [" + joint.joint + "] does not match the state log schema");
+      }
+      double *out = values + this->column_offsets_[k];
+      out = std::copy(joint.position.begin(), joint.position.end(), out);
+      out = std::copy(joint.velocity.begin(), joint.velocity.end(), out);
+      std::copy(joint.effort.begin(), joint.effort.end(), out);
+    }
+  };
+
+  /// \brief fill state.joint_states from a record
+  ///
+  /// JointState objects already in state are reused when state has one per
+  /// schema joint, so reading into the same state repeatedly does not
+  /// allocate.
+  void fromRecord(const double *values, ModelState &state) const
+  {
+    if (state.joint_states.size() != this->getNumJoints())
+    {
+      state.joint_states.resize(this->getNumJoints());
+    }
+    for (std::size_t k = 0; k < this->getNumJoints(); ++k)
+    {
+      JointStateSharedPtr &joint = state.joint_states[k];
+      if (!joint)
+      {
+        joint.reset(new JointState());
+      }
+      if (joint->joint != this->names_[k])
+      {
+        joint->joint.assign(this->names_[k].data(), this->names_[k].size());
+      }
+      const double *in = values + this->column_offsets_[k];
+      joint->position.assign(in, in + this->num_position_[k]);
+      in += this->num_position_[k];
+      joint->velocity.assign(in, in + this->num_velocity_[k]);
+      in += this->num_velocity_[k];
+      joint->effort.assign(in, in + this->num_effort_[k]);
+    }
+  };
+
+  void clear()
+  {
+    this->names_.clear();
+    this->index_.clear();
+    this->num_position_.clear();
+    this->num_velocity_.clear();
+    this->num_effort_.clear();
+    this->column_offsets_.assign(1, 0);
+  };
+
+private:
+  StringTable names_;
+  NameIndex index_;
+  std::vector<std::uint32_t> num_position_;
+  std::vector<std::uint32_t> num_velocity_;
+  std::vector<std::uint32_t> num_effort_;
+  std::vector<std::uint32_t> column_offsets_;
+};
+
+/// \brief Layout and bit level coding shared by StateLogWriter and StateLogReader
+///
+/// A log is
+///
+///   FileHeader, the schema, then chunks
+///
+/// where the schema is, per joint, uint32 name length, uint32 numbers of
+/// positions, velocities and efforts and the name bytes, padded to 8 bytes.
+/// A chunk holds up to FileHeader::chunk_records records as
+///
+///   ChunkHeader, uint32 end of each stream in words (time stream first,
+///   then one per column), padded to 8 bytes, then the streams
+///
+/// Every stream is a sequence of 64 bit words, filled from the most
+/// significant bit.  Time stamps, in nanoseconds, are stored as the second
+/// difference to the previous ones and each column with the XOR coding of
+/// Pelkonen et al., "Gorilla: A Fast, Scalable, In-Memory Time Series
+/// Database": one bit for a value equal to the previous one, otherwise the
+/// meaningful bits of its XOR with the previous value.  Chunks decode
+/// independently.  Integers and doubles are in the byte order of the
+/// writing machine.
+namespace state_log{
+
+static const std::uint32_t VERSION = 1;
+static const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct FileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint32_t chunk_records;
+  std::uint32_t num_joints;
+  /// bytes of the schema following the header, padding included
+  std::uint64_t schema_size;
+};
+
+struct ChunkHeader
+{
+  char magic[4];
+  std::uint32_t num_records;
+  /// time stamps of the first and last record in nanoseconds
+  std::int64_t first_time;
+  std::int64_t last_time;
+  /// bytes of the whole chunk, header included
+  std::uint64_t size;
+};
+
+inline std::uint64_t padding(std::uint64_t size) { return (8 - size % 8) % 8; }
+
+inline int leadingZeros(std::uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_clzll(x);
+#else
+  int n = 0;
+  for (std::uint64_t bit = std::uint64_t(1) << 63; !(x & bit); bit >>= 1) ++n;
+  return n;
+#endif
+}
+
+inline int trailingZeros(std::uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(x);
+#else
+  int n = 0;
+  for (; !(x & 1); x >>= 1) ++n;
+  return n;
+#endif
+}
+
+/// words a stream of n values may need at most
+inline std::size_t maxTimeWords(std::size_t n) { return (68 * n + 63) / 64 + 1; }
+inline std::size_t maxColumnWords(std::size_t n) { return (77 * n + 63) / 64 + 1; }
+
+/// writes bits into words the caller sized with maxTimeWords() or maxColumnWords()
+class BitWriter
+{
+public:
+  explicit BitWriter(std::uint64_t *words) : words_(words), size_(0), current_(0), used_(0) {};
+
+  /// the low bits of value, 1 <= bits <= 64
+  void write(std::uint64_t value, int bits)
+  {
+    if (bits < 64)
+    {
+      value &= (std::uint64_t(1) << bits) - 1;
+    }
+    const int free = 64 - this->used_;
+    if (bits <= free)
+    {
+      this->current_ |= value << (free - bits);
+      this->used_ += bits;
+    }
+    else
+    {
+      this->current_ |= value >> (bits - free);
+      this->words_[this->size_++] = this->current_;
+      this->used_ = bits - free;
+      this->current_ = value << (64 - this->used_);
+    }
+    if (this->used_ == 64)
+    {
+      this->words_[this->size_++] = this->current_;
+      this->current_ = 0;
+      this->used_ = 0;
+    }
+  };
+
+  /// store the last partial word, returns the number of words written
+  std::size_t finish()
+  {
+    if (this->used_ > 0)
+    {
+      this->words_[this->size_++] = this->current_;
+      this->current_ = 0;
+      this->used_ = 0;
+    }
+    return this->size_;
+  };
+
+private:
+  std::uint64_t *words_;
+  std::size_t size_;
+  std::uint64_t current_;
+  int used_;
+};
+
+/// reads bits from words, throws ParseError past their end
+class BitReader
+{
+public:
+  BitReader(const std::uint64_t *words, std::size_t size) : words_(words), size_(size), index_(0), used_(0) {};
+
+  std::uint64_t read(int bits)
+  {
+    if (this->index_ >= this->size_)
+    {
+      throw ParseError("State log stream ends early");
+    }
+    const int available = 64 - this->used_;
+    std::uint64_t value;
+    if (bits <= available)
+    {
+      value = (this->words_[this->index_] << this->used_) >> (64 - bits);
+      this->used_ += bits;
+    }
+    else
+    {
+      if (this->index_ + 1 >= this->size_)
+      {
+        throw ParseError("State log stream ends early");
+      }
+      const int rest = bits - available;
+      value = ((this->words_[this->index_] << this->used_) >> this->used_) << rest |
+              this->words_[this->index_ + 1] >> (64 - rest);
+      ++this->index_;
+      this->used_ = rest;
+    }
+    if (this->used_ == 64)
+    {
+      ++this->index_;
+      this->used_ = 0;
+    }
+    return value;
+  };
+
+private:
+  const std::uint64_t *words_;
+  std::size_t size_;
+  std::size_t index_;
+  int used_;
+};
+
+/// \brief XOR coding of one column, state is the previous value and its window
+class ValueEncoder
+{
+public:
+  ValueEncoder() : previous_(0), leading_(-1), trailing_(0) {};
+
+  void encode(BitWriter &out, double value)
+  {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const std::uint64_t x = bits ^ this->previous_;
+    this->previous_ = bits;
+    if (x == 0)
+    {
+      out.write(0, 1);
+      return;
+    }
+    // the length of the leading zeros is written with 5 bits
+    const int leading = std::min(leadingZeros(x), 31);
+    const int trailing = trailingZeros(x);
+    if (this->leading_ >= 0 && leading >= this->leading_ && trailing >= this->trailing_)
+    {
+      out.write(2, 2);
+      out.write(x >> this->trailing_, 64 - this->leading_ - this->trailing_);
+      return;
+    }
+    const int meaningful = 64 - leading - trailing;
+    out.write(3, 2);
+    out.write(static_cast<std::uint64_t>(leading), 5);
+    out.write(static_cast<std::uint64_t>(meaningful - 1), 6);
+    out.write(x >> trailing, meaningful);
+    this->leading_ = leading;
+    this->trailing_ = trailing;
+  };
+
+private:
+  std::uint64_t previous_;
+  int leading_;
+  int trailing_;
+};
+
+class ValueDecoder
+{
+public:
+  ValueDecoder() : previous_(0), leading_(-1), trailing_(0) {};
+
+  double decode(BitReader &in)
+  {
+    if (in.read(1))
+    {
+      if (in.read(1))
+      {
+        this->leading_ = static_cast<int>(in.read(5));
+        const int meaningful = static_cast<int>(in.read(6)) + 1;
+        this->trailing_ = 64 - this->leading_ - meaningful;
+        if (this->trailing_ < 0)
+        {
+          throw ParseError("Corrupt state log value");
+        }
+      }
+      else if (this->leading_ < 0)
+      {
+        throw ParseError("Corrupt state log value");
+      }
+      this->previous_ ^= in.read(64 - this->leading_ - this->trailing_) << this->trailing_;
+    }
+    double value;
+    std::memcpy(&value, &this->previous_, sizeof(value));
+    return value;
+  };
+
+private:
+  std::uint64_t previous_;
+  int leading_;
+  int trailing_;
+};
+
+/// \brief second differences of time stamps, in zigzag form
+///
+///   0          one 0 bit
+///   < 2^8      10 and 8 bits
+///   < 2^16     110 and 16 bits
+///   < 2^32     1110 and 32 bits
+///   otherwise  1111 and 64 bits
+class TimeEncoder
+{
+public:
+  TimeEncoder() : previous_(0), delta_(0), first_(true) {};
+
+  void encode(BitWriter &out, std::int64_t time)
+  {
+    if (this->first_)
+    {
+      // the chunk header holds the first time stamp
+      this->previous_ = time;
+      this->first_ = false;
+      return;
+    }
+    const std::int64_t delta = static_cast<std::int64_t>(static_cast<std::uint64_t>(time) - static_cast<std::uint64_t>(this->previous_));
+    const std::int64_t second = static_cast<std::int64_t>(static_cast<std::uint64_t>(delta) - static_cast<std::uint64_t>(this->delta_));
+    this->previous_ = time;
+    this->delta_ = delta;
+    const std::uint64_t zigzag = (static_cast<std::uint64_t>(second) << 1) ^ static_cast<std::uint64_t>(second >> 63);
+    if (zigzag == 0)
+    {
+      out.write(0, 1);
+    }
+    else if (zigzag < (std::uint64_t(1) << 8))
+    {
+      out.write(2, 2);
+      out.write(zigzag, 8);
+    }
+    else if (zigzag < (std::uint64_t(1) << 16))
+    {
+      out.write(6, 3);
+      out.write(zigzag, 16);
+    }
+    else if (zigzag < (std::uint64_t(1) << 32))
+    {
+      out.write(14, 4);
+      out.write(zigzag, 32);
+    }
+    else
+    {
+      out.write(15, 4);
+      out.write(zigzag, 64);
+    }
+  };
+
+private:
+  std::int64_t previous_;
+  std::int64_t delta_;
+  bool first_;
+};
+
+class TimeDecoder
+{
+public:
+  explicit TimeDecoder(std::int64_t first_time) : previous_(first_time), delta_(0), first_(true) {};
+
+  std::int64_t decode(BitReader &in)
+  {
+    if (this->first_)
+    {
+      this->first_ = false;
+      return this->previous_;
+    }
+    std::uint64_t zigzag = 0;
+    if (in.read(1))
+    {
+      int bits = 8;
+      if (in.read(1))
+      {
+        bits = 16;
+        if (in.read(1))
+        {
+          bits = in.read(1) ? 64 : 32;
+        }
+      }
+      zigzag = in.read(bits);
+    }
+    const std::int64_t second = static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1);
+    this->delta_ = static_cast<std::int64_t>(static_cast<std::uint64_t>(this->delta_) + static_cast<std::uint64_t>(second));
+    this->previous_ = static_cast<std::int64_t>(static_cast<std::uint64_t>(this->previous_) + static_cast<std::uint64_t>(this->delta_));
+    return this->previous_;
+  };
+
+private:
+  std::int64_t previous_;
+  std::int64_t delta_;
+  bool first_;
+};
+
+}
+
+/// \brief Append only writer of a state log
+///
+/// The schema is written by the constructor.  Records are buffered column
+/// by column and every chunk_records of them are compressed into one chunk
+/// and written to the stream; close() writes the last, partial chunk.  All
+/// buffers are sized in the constructor, so append() does not allocate.
+/// Time stamps must not decrease, so readers can seek by time.
+class StateLogWriter
+{
+public:
+  StateLogWriter(std::ostream &out, const StateLogSchema &schema, std::size_t chunk_records = 1024)
+    : out_(out), schema_(schema), chunk_records_(std::max<std::size_t>(chunk_records, 1)), num_records_(0),
+      chunk_size_(0), last_time_(std::numeric_limits<std::int64_t>::min())
+  {
+    const std::size_t num_columns = schema.getNumColumns();
+    this->times_.resize(this->chunk_records_);
+    this->values_.resize(num_columns * this->chunk_records_);
+    this->record_.resize(num_columns);
+    this->stream_ends_.resize(num_columns + 1 + (num_columns % 2 == 0));
+    this->words_.resize(state_log::maxTimeWords(this->chunk_records_) +
+                        num_columns * state_log::maxColumnWords(this->chunk_records_));
+
+    std::string header(sizeof(state_log::FileHeader), '\0');
+    for (std::size_t k = 0; k < schema.getNumJoints(); ++k)
+    {
+      const std::string_view name = schema.getJointName(k);
+      const std::uint32_t fields[4] = {static_cast<std::uint32_t>(name.size()),
+                                       static_cast<std::uint32_t>(schema.getNumPosition(k)),
+                                       static_cast<std::uint32_t>(schema.getNumVelocity(k)),
+                                       static_cast<std::uint32_t>(schema.getNumEffort(k))};
+      header.append(reinterpret_cast<const char *>(fields), sizeof(fields));
+      header.append(name.data(), name.size());
+    }
+    header.append(state_log::padding(header.size()), '\0');
+    state_log::FileHeader file_header;
+    std::memset(&file_header, 0, sizeof(file_header));
+    std::memcpy(file_header.magic, "URDFSLOG", 8);
+    file_header.version = state_log::VERSION;
+    file_header.byte_order = state_log::BYTE_ORDER_MARK;
+    file_header.chunk_records = static_cast<std::uint32_t>(this->chunk_records_);
+    file_header.num_joints = static_cast<std::uint32_t>(schema.getNumJoints());
+    file_header.schema_size = header.size() - sizeof(file_header);
+    std::memcpy(&header[0], &file_header, sizeof(file_header));
+    this->write(header.data(), header.size());
+  };
+
+  ~StateLogWriter()
+  {
+    try
+    {
+      this->close();
+    }
+    catch (...)
+    {
+    }
+  };
+
+  StateLogWriter(const StateLogWriter &) = delete;
+  StateLogWriter &operator=(const StateLogWriter &) = delete;
+
+  const StateLogSchema &getSchema() const { return this->schema_; };
+  /// records appended so far
+  std::size_t getNumRecords() const { return this->num_records_; };
+
+  /// \brief append one record of getSchema().getNumColumns() values
+  ///
+  /// Throws std::runtime_error if stamp is earlier than the previous one or
+  /// the stream fails.
+  void append(const Time &stamp, const double *values)
+  {
+    const std::int64_t time = stamp.toNSec();
+    if (time < this->last_time_)
+    {
+      throw std::runtime_error("State log time stamps must not decrease");
+    }
+    this->last_time_ = time;
+    this->times_[this->chunk_size_] = time;
+    const std::size_t num_columns = this->schema_.getNumColumns();
+    for (std::size_t c = 0; c < num_columns; ++c)
+    {
+      this->values_[c * this->chunk_records_ + this->chunk_size_] = values[c];
+    }
+    ++this->num_records_;
+    if (++this->chunk_size_ == this->chunk_records_)
+    {
+      this->writeChunk();
+    }
+  };
+
+  /// append the joint states of state, see StateLogSchema::toRecord()
+  void append(const ModelState &state)
+  {
+    this->schema_.toRecord(state, this->record_.data());
+    this->append(state.time_stamp, this->record_.data());
+  };
+
+  /// write the buffered records as a chunk and flush the stream
+  void flush()
+  {
+    if (this->chunk_size_ > 0)
+    {
+      this->writeChunk();
+    }
+    this->out_.flush();
+  };
+
+  void close() { this->flush(); };
+
+private:
+  void write(const void *data, std::size_t size)
+  {
+    this->out_.write(static_cast<const char *>(data), size);
+    if (!this->out_)
+    {
+      throw std::runtime_error("Failed to write the state log");
+    }
+  };
+
+  void writeChunk()
+  {
+    const std::size_t n = this->chunk_size_;
+    const std::size_t num_columns = this->schema_.getNumColumns();
+    std::size_t size = 0;
+    {
+      state_log::BitWriter out(this->words_.data());
+      state_log::TimeEncoder encoder;
+      for (std::size_t r = 0; r < n; ++r)
+      {
+        encoder.encode(out, this->times_[r]);
+      }
+      size = out.finish();
+      this->stream_ends_[0] = static_cast<std::uint32_t>(size);
+    }
+    for (std::size_t c = 0; c < num_columns; ++c)
+    {
+      state_log::BitWriter out(this->words_.data() + size);
+      state_log::ValueEncoder encoder;
+      const double *column = this->values_.data() + c * this->chunk_records_;
+      for (std::size_t r = 0; r < n; ++r)
+      {
+        encoder.encode(out, column[r]);
+      }
+      size += out.finish();
+      this->stream_ends_[c + 1] = static_cast<std::uint32_t>(size);
+    }
+
+    state_log::ChunkHeader header;
+    std::memcpy(header.magic, "SLCK", 4);
+    header.num_records = static_cast<std::uint32_t>(n);
+    header.first_time = this->times_[0];
+    header.last_time = this->times_[n - 1];
+    const std::size_t ends_size = this->stream_ends_.size() * sizeof(std::uint32_t);
+    header.size = sizeof(header) + ends_size + size * sizeof(std::uint64_t);
+    this->write(&header, sizeof(header));
+    this->write(this->stream_ends_.data(), ends_size);
+    this->write(this->words_.data(), size * sizeof(std::uint64_t));
+    this->chunk_size_ = 0;
+  };
+
+  std::ostream &out_;
+  StateLogSchema schema_;
+  std::size_t chunk_records_;
+  std::size_t num_records_;
+  std::size_t chunk_size_;
+  std::int64_t last_time_;
+  std::vector<std::int64_t> times_;
+  /// column c of the current chunk is values_[c * chunk_records_ ...]
+  std::vector<double> values_;
+  std::vector<double> record_;
+  /// padded to an even count, so the streams stay 8 byte aligned
+  std::vector<std::uint32_t> stream_ends_;
+  std::vector<std::uint64_t> words_;
+};
+
+/// \brief Memory mapped reader of a state log
+///
+/// open() reads the schema and walks the chunk headers to index them; a
+/// chunk cut short, as by a writer that did not close, ends the log.
+/// Records are numbered from 0 in the order they were written.  read()
+/// decodes the chunk holding a record once and keeps it, so reading records
+/// in order decodes each chunk once, and does not allocate once the first
+/// chunk is decoded.  seek() finds a record by time stamp with a binary
+/// search over the chunks and then over the time stamps of one chunk,
+/// decoding only its time stream.
+class StateLogReader
+{
+public:
+  StateLogReader() { this->clear(); };
+  explicit StateLogReader(const std::string &filename) { this->open(filename); };
+
+  /// throws std::runtime_error if the file cannot be read and ParseError
+  /// if it is not a state log this version can read
+  void open(const std::string &filename)
+  {
+    this->clear();
+    std::size_t size = 0;
+    std::shared_ptr<const char> storage = mapFile(filename, size);
+    this->attach(storage.get(), size);
+    this->storage_ = storage;
+  };
+
+  /// read a log in memory without copying it, data must be 8 byte aligned
+  /// and outlive this reader
+  void attach(const void *data, std::size_t size)
+  {
+    this->clear();
+    const char *bytes = static_cast<const char *>(data);
+    if (reinterpret_cast<std::uintptr_t>(data) % 8 != 0)
+    {
+      throw ParseError("State log data must be 8 byte aligned");
+    }
+    state_log::FileHeader header;
+    if (size < sizeof(header))
+    {
+      throw ParseError("State log of " + std::to_string(size) + " bytes is too small");
+    }
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, "URDFSLOG", 8) != 0)
+    {
+      throw ParseError("Not a state log");
+    }
+    if (header.byte_order != state_log::BYTE_ORDER_MARK)
+    {
+      throw ParseError("State log was written on a machine with another byte order");
+    }
+    if (header.version != state_log::VERSION)
+    {
+      throw ParseError("Unsupported state log version " + std::to_string(header.version));
+    }
+    if (header.chunk_records == 0 || header.schema_size > size - sizeof(header) || header.schema_size % 8 != 0)
+    {
+      throw ParseError("Corrupt state log header");
+    }
+    std::size_t offset = sizeof(header);
+    const std::size_t schema_end = offset + header.schema_size;
+    std::uint64_t num_schema_columns = 0;
+    for (std::uint32_t k = 0; k < header.num_joints; ++k)
+    {
+      std::uint32_t fields[4];
+      if (schema_end - offset < sizeof(fields))
+      {
+        throw ParseError("Truncated state log schema");
+      }
+      std::memcpy(fields, bytes + offset, sizeof(fields));
+      offset += sizeof(fields);
+      if (schema_end - offset < fields[0])
+      {
+        throw ParseError("Truncated state log schema");
+      }
+      num_schema_columns += static_cast<std::uint64_t>(fields[1]) + fields[2] + fields[3];
+      if (num_schema_columns > std::numeric_limits<std::uint32_t>::max())
+      {
+        throw ParseError("Corrupt state log schema");
+      }
+      this->schema_.addJoint(std::string_view(bytes + offset, fields[0]), fields[1], fields[2], fields[3]);
+      offset += fields[0];
+    }
+    offset = schema_end;
+
+    const std::size_t num_columns = this->schema_.getNumColumns();
+    const std::size_t ends_size = (num_columns + 1 + (num_columns % 2 == 0)) * sizeof(std::uint32_t);
+    std::size_t max_records = 0;
+    // chunks that fail a check are treated like a truncated end of the log
+    while (size - offset >= sizeof(state_log::ChunkHeader) + ends_size)
+    {
+      const state_log::ChunkHeader &chunk = *reinterpret_cast<const state_log::ChunkHeader *>(bytes + offset);
+      if (std::memcmp(chunk.magic, "SLCK", 4) != 0 || chunk.size > size - offset ||
+          chunk.size < sizeof(chunk) + ends_size || chunk.num_records == 0 ||
+          chunk.num_records > header.chunk_records)
+      {
+        break;
+      }
+      const std::uint32_t *ends = reinterpret_cast<const std::uint32_t *>(bytes + offset + sizeof(chunk));
+      const std::uint64_t num_words = ends[num_columns];
+      if (num_words * sizeof(std::uint64_t) != chunk.size - sizeof(chunk) - ends_size ||
+          !std::is_sorted(ends, ends + num_columns + 1) ||
+          // every time and value takes at least one bit
+          chunk.num_records > 64 * num_words / (num_columns + 1))
+      {
+        break;
+      }
+      max_records = std::max<std::size_t>(max_records, chunk.num_records);
+      this->chunk_offsets_.push_back(offset);
+      this->chunk_first_record_.push_back(this->num_records_);
+      this->chunk_first_time_.push_back(chunk.first_time);
+      this->num_records_ += chunk.num_records;
+      offset += chunk.size;
+    }
+    this->data_ = bytes;
+    this->ends_size_ = ends_size;
+    this->chunk_records_ = max_records;
+    this->times_.reserve(this->chunk_records_);
+    this->seek_times_.reserve(this->chunk_records_);
+    this->values_.reserve(num_columns * this->chunk_records_);
+  };
+
+  bool isOpen() const { return this->data_ != nullptr; };
+
+  const StateLogSchema &getSchema() const { return this->schema_; };
+  std::size_t getNumRecords() const { return this->num_records_; };
+  std::size_t getNumChunks() const { return this->chunk_offsets_.size(); };
+
+  /// index of the first record stamped at or after stamp, getNumRecords() if none is
+  std::size_t seek(const Time &stamp) { return this->seek(stamp.toNSec()); };
+
+  std::size_t seek(std::int64_t nanoseconds)
+  {
+    // last chunk starting at or before the time, the record may be in it
+    const std::vector<std::int64_t>::const_iterator after =
+      std::upper_bound(this->chunk_first_time_.begin(), this->chunk_first_time_.end(), nanoseconds);
+    if (after == this->chunk_first_time_.begin())
+    {
+      return 0;
+    }
+    std::size_t chunk = static_cast<std::size_t>(after - this->chunk_first_time_.begin()) - 1;
+    // equal stamps may begin in an earlier chunk
+    while (chunk > 0 && this->chunk_first_time_[chunk] == nanoseconds)
+    {
+      --chunk;
+    }
+    if (this->getChunk(chunk).last_time < nanoseconds)
+    {
+      return chunk + 1 < this->getNumChunks() ? this->chunk_first_record_[chunk + 1] : this->num_records_;
+    }
+    this->decodeTimes(chunk, this->seek_times_);
+    return this->chunk_first_record_[chunk] +
+           static_cast<std::size_t>(std::lower_bound(this->seek_times_.begin(), this->seek_times_.end(), nanoseconds) -
+                                    this->seek_times_.begin());
+  };
+
+  /// time stamp and getSchema().getNumColumns() values of a record
+  void read(std::size_t record, Time &stamp, double *values)
+  {
+    const std::size_t r = this->locate(record);
+    stamp = Time::fromNSec(this->times_[r]);
+    const std::size_t num_columns = this->schema_.getNumColumns();
+    for (std::size_t c = 0; c < num_columns; ++c)
+    {
+      values[c] = this->values_[c * this->chunk_records_ + r];
+    }
+  };
+
+  /// a record as a ModelState, see StateLogSchema::fromRecord()
+  void read(std::size_t record, ModelState &state)
+  {
+    const std::size_t r = this->locate(record);
+    state.time_stamp = Time::fromNSec(this->times_[r]);
+    const std::size_t num_columns = this->schema_.getNumColumns();
+    this->record_.resize(num_columns);
+    for (std::size_t c = 0; c < num_columns; ++c)
+    {
+      this->record_[c] = this->values_[c * this->chunk_records_ + r];
+    }
+    this->schema_.fromRecord(this->record_.data(), state);
+  };
+
+  /// \brief values of one column for count records from first
+  ///
+  /// Decodes only that column of the chunks involved.
+  void readColumn(std::size_t column, std::size_t first, std::size_t count, double *values) const
+  {
+    if (first + count > this->num_records_)
+    {
+      throw std::runtime_error("State log has no record " + std::to_string(first + count - 1));
+    }
+    std::size_t chunk = this->findChunk(first);
+    while (count > 0)
+    {
+      const state_log::ChunkHeader &header = this->getChunk(chunk);
+      const std::uint32_t *ends = this->getStreamEnds(chunk);
+      if (ends[column] > ends[column + 1] || ends[column + 1] > ends[this->schema_.getNumColumns()])
+      {
+        throw ParseError("Corrupt state log chunk " + std::to_string(chunk));
+      }
+      state_log::BitReader in(this->getWords(chunk) + ends[column], ends[column + 1] - ends[column]);
+      state_log::ValueDecoder decoder;
+      std::size_t r = 0;
+      for (; r < first - this->chunk_first_record_[chunk]; ++r)
+      {
+        decoder.decode(in);
+      }
+      for (; r < header.num_records && count > 0; ++r, --count)
+      {
+        *values++ = decoder.decode(in);
+      }
+      first = this->chunk_first_record_[chunk] + r;
+      ++chunk;
+    }
+  };
+
+  void clear()
+  {
+    this->storage_.reset();
+    this->data_ = nullptr;
+    this->ends_size_ = 0;
+    this->chunk_records_ = 0;
+    this->num_records_ = 0;
+    this->schema_.clear();
+    this->chunk_offsets_.clear();
+    this->chunk_first_record_.clear();
+    this->chunk_first_time_.clear();
+    this->decoded_chunk_ = static_cast<std::size_t>(-1);
+    this->times_.clear();
+    this->values_.clear();
+    this->seek_times_.clear();
+  };
+
+private:
+  const state_log::ChunkHeader &getChunk(std::size_t chunk) const
+  {
+    return *reinterpret_cast<const state_log::ChunkHeader *>(this->data_ + this->chunk_offsets_[chunk]);
+  };
+
+  const std::uint32_t *getStreamEnds(std::size_t chunk) const
+  {
+    return reinterpret_cast<const std::uint32_t *>(this->data_ + this->chunk_offsets_[chunk] + sizeof(state_log::ChunkHeader));
+  };
+
+  const std::uint64_t *getWords(std::size_t chunk) const
+  {
+    return reinterpret_cast<const std::uint64_t *>(this->data_ + this->chunk_offsets_[chunk] +
+                                                   sizeof(state_log::ChunkHeader) + this->ends_size_);
+  };
+
+  std::size_t findChunk(std::size_t record) const
+  {
+    return static_cast<std::size_t>(std::upper_bound(this->chunk_first_record_.begin(), this->chunk_first_record_.end(),
+                                                     record) - this->chunk_first_record_.begin()) - 1;
+  };
+
+  /// decode the chunk holding record, returns its position in the chunk
+  std::size_t locate(std::size_t record)
+  {
+    if (record >= this->num_records_)
+    {
+      throw std::runtime_error("State log has no record " + std::to_string(record));
+    }
+    const std::size_t chunk = this->findChunk(record);
+    this->decodeChunk(chunk);
+    return record - this->chunk_first_record_[chunk];
+  };
+
+  void decodeTimes(std::size_t chunk, std::vector<std::int64_t> &times) const
+  {
+    const state_log::ChunkHeader &header = this->getChunk(chunk);
+    state_log::BitReader in(this->getWords(chunk), this->getStreamEnds(chunk)[0]);
+    state_log::TimeDecoder decoder(header.first_time);
+    times.resize(header.num_records);
+    for (std::uint32_t r = 0; r < header.num_records; ++r)
+    {
+      times[r] = decoder.decode(in);
+    }
+  };
+
+  void decodeChunk(std::size_t chunk)
+  {
+    if (chunk == this->decoded_chunk_)
+    {
+      return;
+    }
+    this->decoded_chunk_ = static_cast<std::size_t>(-1);
+    const state_log::ChunkHeader &header = this->getChunk(chunk);
+    const std::uint32_t *ends = this->getStreamEnds(chunk);
+    const std::uint64_t *words = this->getWords(chunk);
+    const std::size_t num_columns = this->schema_.getNumColumns();
+    this->decodeTimes(chunk, this->times_);
+    this->values_.resize(num_columns * this->chunk_records_);
+    for (std::size_t c = 0; c < num_columns; ++c)
+    {
+      state_log::BitReader in(words + ends[c], ends[c + 1] - ends[c]);
+      state_log::ValueDecoder decoder;
+      double *column = this->values_.data() + c * this->chunk_records_;
+      for (std::uint32_t r = 0; r < header.num_records; ++r)
+      {
+        column[r] = decoder.decode(in);
+      }
+    }
+    this->decoded_chunk_ = chunk;
+  };
+
+  /// keeps a mapped file alive, empty for attach()
+  std::shared_ptr<const char> storage_;
+  const char *data_;
+  std::size_t ends_size_;
+  /// records of the largest indexed chunk
+  std::size_t chunk_records_;
+  std::size_t num_records_;
+  StateLogSchema schema_;
+  std::vector<std::size_t> chunk_offsets_;
+  std::vector<std::size_t> chunk_first_record_;
+  std::vector<std::int64_t> chunk_first_time_;
+
+  /// the decoded chunk, column c at values_[c * chunk_records_ ...]
+  std::size_t decoded_chunk_;
+  std::vector<std::int64_t> times_;
+  std::vector<double> values_;
+  std::vector<double> record_;
+  /// time stamps of the chunk seek() searched last
+  std::vector<std::int64_t> seek_times_;
+};
+
+}
+
+#endif
@@ -0,0 +1,462 @@
+/* Interpolation and resampling of model state trajectories */
+
+#ifndef URDF_MODEL_STATE_TRAJECTORY_H
+#define URDF_MODEL_STATE_TRAJECTORY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <urdf_model/joint.h>
+#include <urdf_model/pose.h>
+#include <urdf_model/simd.h>
+#include <urdf_model_state/model_state.h>
+#include <urdf_model_state/packed_state.h>
+
+namespace urdf{
+
+namespace detail{
+
+inline void lerpScalar(std::size_t begin, std::size_t n, const double *a, const double *b, double s, double *out)
+{
+  for (std::size_t i = begin; i < n; ++i)
+  {
+    out[i] = a[i] + s * (b[i] - a[i]);
+  }
+}
+
+/// h holds the weights of p0, m0, p1 and m1
+inline void hermiteScalar(std::size_t begin, std::size_t n, const double *p0, const double *m0,
+                          const double *p1, const double *m1, const double *h, double *out)
+{
+  for (std::size_t i = begin; i < n; ++i)
+  {
+    out[i] = h[0] * p0[i] + h[1] * m0[i] + h[2] * p1[i] + h[3] * m1[i];
+  }
+}
+
+#ifdef URDF_SIMD_X86
+
+URDF_TARGET_AVX2
+inline void lerpAvx2(std::size_t n, const double *a, const double *b, double s, double *out)
+{
+  const __m256d weight = _mm256_set1_pd(s);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m256d first = _mm256_loadu_pd(a + i);
+    _mm256_storeu_pd(out + i, _mm256_fmadd_pd(weight, _mm256_sub_pd(_mm256_loadu_pd(b + i), first), first));
+  }
+  lerpScalar(i, n, a, b, s, out);
+}
+
+URDF_TARGET_AVX2
+inline void hermiteAvx2(std::size_t n, const double *p0, const double *m0,
+                        const double *p1, const double *m1, const double *h, double *out)
+{
+  const __m256d h00 = _mm256_set1_pd(h[0]), h10 = _mm256_set1_pd(h[1]);
+  const __m256d h01 = _mm256_set1_pd(h[2]), h11 = _mm256_set1_pd(h[3]);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    __m256d value = _mm256_mul_pd(h00, _mm256_loadu_pd(p0 + i));
+    value = _mm256_fmadd_pd(h10, _mm256_loadu_pd(m0 + i), value);
+    value = _mm256_fmadd_pd(h01, _mm256_loadu_pd(p1 + i), value);
+    _mm256_storeu_pd(out + i, _mm256_fmadd_pd(h11, _mm256_loadu_pd(m1 + i), value));
+  }
+  hermiteScalar(i, n, p0, m0, p1, m1, h, out);
+}
+
+URDF_TARGET_AVX512
+inline void lerpAvx512(std::size_t n, const double *a, const double *b, double s, double *out)
+{
+  const __m512d weight = _mm512_set1_pd(s);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    const __m512d first = _mm512_loadu_pd(a + i);
+    _mm512_storeu_pd(out + i, _mm512_fmadd_pd(weight, _mm512_sub_pd(_mm512_loadu_pd(b + i), first), first));
+  }
+  lerpScalar(i, n, a, b, s, out);
+}
+
+URDF_TARGET_AVX512
+inline void hermiteAvx512(std::size_t n, const double *p0, const double *m0,
+                          const double *p1, const double *m1, const double *h, double *out)
+{
+  const __m512d h00 = _mm512_set1_pd(h[0]), h10 = _mm512_set1_pd(h[1]);
+  const __m512d h01 = _mm512_set1_pd(h[2]), h11 = _mm512_set1_pd(h[3]);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    __m512d value = _mm512_mul_pd(h00, _mm512_loadu_pd(p0 + i));
+    value = _mm512_fmadd_pd(h10, _mm512_loadu_pd(m0 + i), value);
+    value = _mm512_fmadd_pd(h01, _mm512_loadu_pd(p1 + i), value);
+    _mm512_storeu_pd(out + i, _mm512_fmadd_pd(h11, _mm512_loadu_pd(m1 + i), value));
+  }
+  hermiteScalar(i, n, p0, m0, p1, m1, h, out);
+}
+
+#endif
+
+/// out = a + s (b - a) for n values
+inline void lerp(std::size_t n, const double *a, const double *b, double s, double *out)
+{
+#ifdef URDF_SIMD_X86
+  switch (simd::detectLevel())
+  {
+    case simd::AVX512: lerpAvx512(n, a, b, s, out); return;
+    case simd::AVX2: lerpAvx2(n, a, b, s, out); return;
+    default: break;
+  }
+#endif
+  lerpScalar(0, n, a, b, s, out);
+}
+
+/// out = h[0] p0 + h[1] m0 + h[2] p1 + h[3] m1 for n values
+inline void hermite(std::size_t n, const double *p0, const double *m0,
+                    const double *p1, const double *m1, const double *h, double *out)
+{
+#ifdef URDF_SIMD_X86
+  switch (simd::detectLevel())
+  {
+    case simd::AVX512: hermiteAvx512(n, p0, m0, p1, m1, h, out); return;
+    case simd::AVX2: hermiteAvx2(n, p0, m0, p1, m1, h, out); return;
+    default: break;
+  }
+#endif
+  hermiteScalar(0, n, p0, m0, p1, m1, h, out);
+}
+
+/// b - a for angles, wrapped to [-pi, pi)
+inline double angleDifference(double a, double b)
+{
+  const double pi = 3.14159265358979323846;
+  const double d = b - a;
+  return d - 2.0 * pi * std::floor((d + pi) / (2.0 * pi));
+}
+
+/// spherical interpolation of unit quaternions (x, y, z, w) along the shorter arc
+inline void slerp(const double *a, const double *b, double s, double *out)
+{
+  double cos_angle = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+  const double sign = cos_angle < 0.0 ? -1.0 : 1.0;
+  cos_angle *= sign;
+  double weight_a = 1.0 - s;
+  double weight_b = s;
+  // nearly equal rotations: the normalized lerp below is as accurate and sin(angle) ~ 0
+  if (cos_angle < 0.9995)
+  {
+    const double angle = std::acos(cos_angle);
+    const double sin_angle = std::sin(angle);
+    weight_a = std::sin(weight_a * angle) / sin_angle;
+    weight_b = std::sin(weight_b * angle) / sin_angle;
+  }
+  weight_b *= sign;
+  double squared_norm = 0.0;
+  for (int k = 0; k < 4; ++k)
+  {
+    out[k] = weight_a * a[k] + weight_b * b[k];
+    squared_norm += out[k] * out[k];
+  }
+  const double scale = 1.0 / std::sqrt(squared_norm);
+  for (int k = 0; k < 4; ++k)
+  {
+    out[k] *= scale;
+  }
+}
+
+}
+
+/// \brief Packed states at increasing time stamps, interpolated between them
+///
+/// The knots are stored like a StateHistory, one packed state per row, so
+/// interpolation is one pass over all positions and one over all
+/// velocities and efforts.  The joint types of the StateLayout only matter
+/// for three kinds of coordinates, patched after that pass:
+///
+///   CONTINUOUS and the PLANAR angle   take the shorter way around the circle
+///   FLOATING quaternion               slerp
+///   positions without a velocity      linear (joints of type UNKNOWN with
+///                                     different position and velocity counts)
+///
+/// CUBIC_HERMITE uses the velocities of the knots as the derivatives of
+/// the positions; for FLOATING joints the linear velocity is rotated out of
+/// the child frame.  Velocities and efforts are interpolated linearly.
+class Trajectory
+{
+public:
+  enum Interpolation
+  {
+    LINEAR, CUBIC_HERMITE
+  };
+
+  Trajectory() { this->clear(); };
+  explicit Trajectory(const StateLayout &layout) { this->init(layout); };
+
+  void init(const StateLayout &layout)
+  {
+    this->clear();
+    this->layout_ = layout;
+    this->tangent_source_.assign(layout.getNumPositions(), -1);
+    for (std::size_t k = 0; k < layout.getNumJoints(); ++k)
+    {
+      const int q = static_cast<int>(layout.getJointPositionOffset(k));
+      const int v = static_cast<int>(layout.getJointVelocityOffset(k));
+      const int nq = static_cast<int>(layout.getJointNumPositions(k));
+      switch (layout.getJointType(k))
+      {
+        case Joint::CONTINUOUS: this->wrapped_.push_back(q); break;
+        case Joint::PLANAR: this->wrapped_.push_back(q + 2); break;
+        case Joint::FLOATING:
+          this->floating_q_.push_back(q);
+          this->floating_v_.push_back(v);
+          continue;
+        default: break;
+      }
+      if (nq != static_cast<int>(layout.getJointNumVelocities(k)))
+      {
+        for (int i = 0; i < nq; ++i)
+        {
+          this->linear_.push_back(q + i);
+        }
+        continue;
+      }
+      for (int i = 0; i < nq; ++i)
+      {
+        this->tangent_source_[q + i] = v + i;
+      }
+    }
+  };
+
+  const StateLayout &getLayout() const { return this->layout_; };
+  std::size_t size() const { return this->times_.size(); };
+  bool empty() const { return this->times_.empty(); };
+
+  void reserve(std::size_t n)
+  {
+    this->times_.reserve(n);
+    this->data_.reserve(n * this->layout_.getSize());
+    this->tangents_.reserve(n * this->layout_.getNumPositions());
+  };
+
+  /// append a knot, throws std::runtime_error unless its time stamp is after the last one
+  void append(const ConstPackedStateView &state)
+  {
+    this->checkTime(state.timeStamp());
+    this->times_.push_back(state.timeStamp());
+    this->data_.insert(this->data_.end(), state.data(), state.data() + this->layout_.getSize());
+    this->addTangents();
+  };
+
+  /// \brief append the joints of state as a knot
+  ///
+  /// Joints state does not hold keep their values of the previous knot,
+  /// zero for the first, see BasicPackedStateView::fromModelState().
+  void append(const ModelState &state)
+  {
+    this->checkTime(state.time_stamp);
+    const std::size_t size = this->layout_.getSize();
+    this->times_.push_back(state.time_stamp);
+    this->data_.resize(this->data_.size() + size, 0.0);
+    if (this->times_.size() > 1)
+    {
+      std::copy(this->data_.end() - 2 * size, this->data_.end() - size, this->data_.end() - size);
+    }
+    try
+    {
+      PackedStateView(this->layout_, this->times_.back(), this->data_.data() + this->data_.size() - size)
+        .fromModelState(state);
+    }
+    catch (...)
+    {
+      this->times_.pop_back();
+      this->data_.resize(this->data_.size() - size);
+      throw;
+    }
+    this->addTangents();
+  };
+
+  ConstPackedStateView operator[](std::size_t i) const
+  {
+    return ConstPackedStateView(this->layout_, this->times_[i], this->row(i));
+  };
+
+  /// index of the first knot not before stamp, size() if there is none
+  std::size_t lowerBound(const Time &stamp) const
+  {
+    return static_cast<std::size_t>(std::lower_bound(this->times_.begin(), this->times_.end(), stamp) -
+                                    this->times_.begin());
+  };
+
+  /// \brief the state at stamp, written to out
+  ///
+  /// Before the first and after the last knot the state is that knot's.
+  /// Does not allocate.  Requires !empty().
+  void sample(const Time &stamp, const PackedStateView &out, Interpolation interpolation = LINEAR) const
+  {
+    this->sampleAt(this->lowerBound(stamp), stamp, out, interpolation);
+  };
+
+  /// \brief sample n states at start, start + period, ... into out
+  ///
+  /// out gets the layout of this trajectory and holds exactly those
+  /// samples.  The knots are walked once instead of searched per sample.
+  /// Throws std::runtime_error if period is not positive.  Requires !empty()
+  /// and &out != this.
+  void resample(const Time &start, const Time &period, std::size_t n, Trajectory &out,
+                Interpolation interpolation = LINEAR) const
+  {
+    if (period <= Time())
+    {
+      throw std::runtime_error("Trajectory resampling needs a positive period");
+    }
+    out.init(this->layout_);
+    const std::size_t size = this->layout_.getSize();
+    out.times_.resize(n);
+    out.data_.resize(n * size);
+    out.tangents_.resize(n * this->layout_.getNumPositions());
+    const std::int64_t first = start.toNSec();
+    const std::int64_t step = period.toNSec();
+    std::size_t knot = this->lowerBound(start);
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      const Time stamp = Time::fromNSec(first + static_cast<std::int64_t>(k) * step);
+      while (knot < this->times_.size() && this->times_[knot] < stamp)
+      {
+        ++knot;
+      }
+      this->sampleAt(knot, stamp, PackedStateView(out.layout_, out.times_[k], out.data_.data() + k * size),
+                     interpolation);
+      out.computeTangents(k);
+    }
+  };
+
+  void clear()
+  {
+    this->layout_.clear();
+    this->times_.clear();
+    this->data_.clear();
+    this->tangents_.clear();
+    this->wrapped_.clear();
+    this->floating_q_.clear();
+    this->floating_v_.clear();
+    this->linear_.clear();
+    this->tangent_source_.clear();
+  };
+
+private:
+  const double *row(std::size_t i) const { return this->data_.data() + i * this->layout_.getSize(); };
+
+  void checkTime(const Time &stamp) const
+  {
+    if (!this->times_.empty() && !(this->times_.back() < stamp))
+    {
+      throw std::runtime_error("Trajectory knots need increasing time stamps");
+    }
+  };
+
+  void addTangents()
+  {
+    this->tangents_.resize(this->tangents_.size() + this->layout_.getNumPositions());
+    this->computeTangents(this->times_.size() - 1);
+  };
+
+  /// position derivatives of knot i from its velocities
+  void computeTangents(std::size_t i)
+  {
+    const std::size_t nq = this->layout_.getNumPositions();
+    const double *q = this->row(i);
+    const double *v = q + nq;
+    double *tangent = this->tangents_.data() + i * nq;
+    for (std::size_t c = 0; c < nq; ++c)
+    {
+      tangent[c] = this->tangent_source_[c] >= 0 ? v[this->tangent_source_[c]] : 0.0;
+    }
+    for (std::size_t f = 0; f < this->floating_q_.size(); ++f)
+    {
+      const double *position = q + this->floating_q_[f];
+      const double *velocity = v + this->floating_v_[f];
+      const Vector3 linear = Rotation(position[3], position[4], position[5], position[6]) *
+                             Vector3(velocity[3], velocity[4], velocity[5]);
+      double *out = tangent + this->floating_q_[f];
+      out[0] = linear.x;
+      out[1] = linear.y;
+      out[2] = linear.z;
+    }
+  };
+
+  /// the state at stamp given the lowerBound() knot of stamp
+  void sampleAt(std::size_t knot, const Time &stamp, const PackedStateView &out, Interpolation interpolation) const
+  {
+    const std::size_t size = this->layout_.getSize();
+    out.timeStamp() = stamp;
+    if (knot == 0 || knot == this->times_.size() || this->times_[knot] == stamp)
+    {
+      const double *source = this->row(std::min(knot, this->times_.size() - 1));
+      std::copy(source, source + size, out.data());
+      return;
+    }
+
+    const std::size_t nq = this->layout_.getNumPositions();
+    const double *a = this->row(knot - 1);
+    const double *b = this->row(knot);
+    const std::int64_t span = (this->times_[knot] - this->times_[knot - 1]).toNSec();
+    const double s = static_cast<double>((stamp - this->times_[knot - 1]).toNSec()) / static_cast<double>(span);
+    double *result = out.data();
+
+    // weight of the position of b, used to move it by whole turns
+    double weight_b = s;
+    if (interpolation == CUBIC_HERMITE)
+    {
+      const double dt = 1e-9 * static_cast<double>(span);
+      const double s2 = s * s, s3 = s2 * s;
+      const double h[4] = {2.0 * s3 - 3.0 * s2 + 1.0, (s3 - 2.0 * s2 + s) * dt, 3.0 * s2 - 2.0 * s3, (s3 - s2) * dt};
+      weight_b = h[2];
+      detail::hermite(nq, a, this->tangents_.data() + (knot - 1) * nq, b, this->tangents_.data() + knot * nq,
+                      h, result);
+      detail::lerp(size - nq, a + nq, b + nq, s, result + nq);
+      for (int c : this->linear_)
+      {
+        result[c] = a[c] + s * (b[c] - a[c]);
+      }
+    }
+    else
+    {
+      detail::lerp(size, a, b, s, result);
+    }
+
+    for (int c : this->wrapped_)
+    {
+      result[c] += weight_b * (a[c] + detail::angleDifference(a[c], b[c]) - b[c]);
+    }
+    for (int c : this->floating_q_)
+    {
+      detail::slerp(a + c + 3, b + c + 3, s, result + c + 3);
+    }
+  };
+
+  StateLayout layout_;
+  std::vector<Time> times_;
+  /// one packed state per knot
+  std::vector<double> data_;
+  /// getNumPositions() position derivatives per knot
+  std::vector<double> tangents_;
+
+  /// positions of CONTINUOUS joints and PLANAR angles
+  std::vector<int> wrapped_;
+  /// first position and velocity of FLOATING joints
+  std::vector<int> floating_q_;
+  std::vector<int> floating_v_;
+  /// positions always interpolated linearly
+  std::vector<int> linear_;
+  /// velocity that is the derivative of each position, -1 if there is none
+  std::vector<int> tangent_source_;
+};
+
+}
+
+#endif